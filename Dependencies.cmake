@@ -56,4 +56,17 @@ function(travels_setup_dependencies)
     cpmaddpackage("gh:nlohmann/json@3.11.2")
   endif()
 
+  if(travels_BUILD_BENCHMARKS AND NOT TARGET benchmark::benchmark_main)
+    cpmaddpackage(
+      NAME
+      benchmark
+      VERSION
+      1.8.0
+      GITHUB_REPOSITORY
+      "google/benchmark"
+      OPTIONS
+      "BENCHMARK_ENABLE_TESTING OFF"
+      "BENCHMARK_ENABLE_INSTALL OFF")
+  endif()
+
 endfunction()
@@ -29,6 +29,7 @@ macro(travels_setup_options)
 
   travels_check_libfuzzer_support(LIBFUZZER_SUPPORTED)
   option(travels_BUILD_FUZZ_TESTS "Enable fuzz testing executable" ${LIBFUZZER_SUPPORTED})
+  option(travels_BUILD_BENCHMARKS "Enable the travels_bench benchmark executable" OFF)
 
 
   if(NOT PROJECT_IS_TOP_LEVEL OR travels_PACKAGING_MAINTAINER_MODE)
@@ -0,0 +1,435 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/screen.hpp>
+#include <utility>
+#include <vector>
+
+#include "ansi_encoder.hpp"
+#include "asset_loader.hpp"
+#include "bitmap.hpp"
+#include "color.hpp"
+#include "color_blend.hpp"
+#include "compiled_map.hpp"
+#include "game.hpp"
+#include "game_components.hpp"
+#include "minimap.hpp"
+#include "palette.hpp"
+#include "pathfinding.hpp"
+#include "thread_pool.hpp"
+#include "viewport.hpp"
+
+#include <internal_use_only/config.hpp>
+
+// Run with `--benchmark_format=json` or `--benchmark_out=<file> --benchmark_out_format=json`
+// for machine readable results
+
+namespace {
+
+using namespace lefticus::travels;
+
+std::vector<std::filesystem::path> search_directories()
+{
+  return { std::filesystem::path(travels::cmake::source_dir) / "resources" };
+}
+
+std::filesystem::path tiles_path()
+{
+  return std::filesystem::path(travels::cmake::source_dir) / "resources/travels/tiled/tiles";
+}
+
+// some deterministic "random" colors with a spread of alpha values
+std::vector<Color> make_colors(const std::size_t count, std::uint32_t seed, const bool opaque)
+{
+  std::vector<Color> result;
+  result.reserve(count);
+
+  const auto next = [&seed] {
+    seed = seed * 1664525U + 1013904223U;// NOLINT magic numbers
+    return static_cast<std::uint8_t>(seed >> 24U);// NOLINT magic numbers
+  };
+
+  for (std::size_t index = 0; index < count; ++index) {
+    result.push_back(Color{ next(), next(), next(), opaque ? std::uint8_t{ 255 } : next() });// NOLINT magic numbers
+  }
+
+  return result;
+}
+
+void load_tiled_map(benchmark::State &state, const char *map_file)
+{
+  const auto directories = search_directories();
+  for ([[maybe_unused]] auto _ : state) {
+    auto map = lefticus::travels::load_tiled_map(map_file, directories);
+    benchmark::DoNotOptimize(map);
+  }
+}
+BENCHMARK_CAPTURE(load_tiled_map, main, "travels/tiled/tiles/Map.tmj")->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(load_tiled_map, store, "travels/tiled/tiles/Store.tmj")->Unit(benchmark::kMillisecond);
+
+void load_maps_in_parallel(benchmark::State &state)
+{
+  const auto directories = search_directories();
+  Thread_Pool pool;
+  Asset_Loader loader{ pool };
+
+  for ([[maybe_unused]] auto _ : state) {
+    auto main_map = loader.read_tiled_map(tiles_path() / "Map.tmj");
+    auto store_map = loader.read_tiled_map(tiles_path() / "Store.tmj");
+    benchmark::DoNotOptimize(main_map.get());
+    benchmark::DoNotOptimize(store_map.get());
+  }
+}
+BENCHMARK(load_maps_in_parallel)->Unit(benchmark::kMillisecond);
+
+void load_compiled_map(benchmark::State &state, const char *map_file)
+{
+  const auto compiled_file = std::filesystem::temp_directory_path() / "travels_bench_map.tmapc";
+  {
+    std::ofstream output(compiled_file, std::ios::binary);
+    write_compiled_map(read_tiled_map(tiles_path() / map_file), output);
+  }
+
+  for ([[maybe_unused]] auto _ : state) {
+    auto map = lefticus::travels::load_compiled_map(compiled_file);
+    benchmark::DoNotOptimize(map);
+  }
+
+  std::filesystem::remove(compiled_file);
+}
+BENCHMARK_CAPTURE(load_compiled_map, main, "Map.tmj")->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(load_compiled_map, store, "Store.tmj")->Unit(benchmark::kMillisecond);
+
+void load_png(benchmark::State &state)
+{
+  const auto file = tiles_path() / "8x8 fantasytiles.png";
+  for ([[maybe_unused]] auto _ : state) {
+    auto image = lefticus::travels::load_png(file);
+    benchmark::DoNotOptimize(image);
+  }
+}
+BENCHMARK(load_png)->Unit(benchmark::kMillisecond);
+
+void color_plus_equals(benchmark::State &state)
+{
+  constexpr std::size_t count = 4096;
+  const auto under = make_colors(count, 1, state.range(0) != 0);
+  const auto over = make_colors(count, 2, false);
+  auto result = under;
+
+  for ([[maybe_unused]] auto _ : state) {
+    std::copy(under.begin(), under.end(), result.begin());
+    for (std::size_t index = 0; index < count; ++index) { result[index] += over[index]; }
+    benchmark::DoNotOptimize(result.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(count));
+}
+BENCHMARK(color_plus_equals)->ArgName("opaque_destination")->Arg(0)->Arg(1);
+
+void color_blend_span(benchmark::State &state)
+{
+  constexpr std::size_t count = 4096;
+  const auto under = make_colors(count, 1, state.range(0) != 0);
+  const auto over = make_colors(count, 2, false);
+  auto result = under;
+
+  for ([[maybe_unused]] auto _ : state) {
+    std::copy(under.begin(), under.end(), result.begin());
+    blend_span(std::span<Color>(result), std::span<const Color>(over));
+    benchmark::DoNotOptimize(result.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(count));
+}
+BENCHMARK(color_blend_span)->ArgName("opaque_destination")->Arg(0)->Arg(1);
+
+void variable_comparison(benchmark::State &state)
+{
+  Game game;
+  game.variables["Cash"] = 50;// NOLINT magic numbers
+  game.variables["xstation"] = false;
+
+  const auto condition = variable{ "Cash" } >= 20 && variable{ "xstation" } == false;// NOLINT magic numbers
+
+  for ([[maybe_unused]] auto _ : state) { benchmark::DoNotOptimize(condition(game)); }
+}
+BENCHMARK(variable_comparison);
+
+// the main map is 30x20 tiles of 8x8 pixels, the viewport can not be larger than that
+void add_viewport_sizes(benchmark::internal::Benchmark *benchmark)
+{
+  benchmark->ArgNames({ "width", "height" });
+  benchmark->Args({ 64, 40 });// NOLINT magic numbers
+  benchmark->Args({ 128, 80 });// NOLINT magic numbers
+  benchmark->Args({ 240, 160 });// NOLINT magic numbers
+}
+
+Size viewport_size(const benchmark::State &state)
+{
+  return Size{ static_cast<std::size_t>(state.range(0)), static_cast<std::size_t>(state.range(1)) };
+}
+
+void draw_full(benchmark::State &state)
+{
+  const auto game = make_game(search_directories());
+  Bitmap viewport{ viewport_size(state) };
+
+  for ([[maybe_unused]] auto _ : state) {
+    draw(viewport, game.player.map_location, game, game.get_current_map());
+    benchmark::DoNotOptimize(viewport.pixels.data().data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(
+    state.iterations() * static_cast<std::int64_t>(viewport.pixels.size().width * viewport.pixels.size().height));
+}
+BENCHMARK(draw_full)->Apply(add_viewport_sizes);
+
+// the largest viewport, redrawn in full by the calling thread and `threads - 1` pool threads
+void draw_full_banded(benchmark::State &state)
+{
+  const auto game = make_game(search_directories());
+  Bitmap viewport{ Size{ 240, 160 } };// NOLINT magic numbers
+
+  Thread_Pool pool{ static_cast<std::size_t>(state.range(0)) - 1 };
+  Viewport_Tracker tracker;
+  tracker.pool = &pool;
+
+  for ([[maybe_unused]] auto _ : state) {
+    tracker.invalidate();
+    draw(viewport, game, tracker);
+    benchmark::DoNotOptimize(viewport.pixels.data().data());
+    benchmark::ClobberMemory();
+  }
+
+  state.counters["bands"] = static_cast<double>(tracker.bands);
+  state.SetItemsProcessed(
+    state.iterations() * static_cast<std::int64_t>(viewport.pixels.size().width * viewport.pixels.size().height));
+}
+BENCHMARK(draw_full_banded)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();// NOLINT magic numbers
+
+// the whole main map zoomed out, redrawn in full every time
+void draw_minimap_full(benchmark::State &state)
+{
+  const auto game = make_game(search_directories());
+  Bitmap minimap{ viewport_size(state) };
+  Minimap_Tracker tracker;
+
+  for ([[maybe_unused]] auto _ : state) {
+    tracker.invalidate();
+    draw_minimap(minimap, game, tracker);
+    benchmark::DoNotOptimize(minimap.pixels.data().data());
+    benchmark::ClobberMemory();
+  }
+
+  state.counters["level"] = static_cast<double>(tracker.level);
+  state.counters["cells_drawn"] = static_cast<double>(tracker.cells_drawn);
+}
+BENCHMARK(draw_minimap_full)->Apply(add_viewport_sizes);
+
+// nothing moves, so only the player tile is redrawn
+void draw_idle(benchmark::State &state)
+{
+  const auto game = make_game(search_directories());
+  Bitmap viewport{ viewport_size(state) };
+  Viewport_Tracker tracker;
+  draw(viewport, game, tracker);
+
+  for ([[maybe_unused]] auto _ : state) {
+    draw(viewport, game, tracker);
+    benchmark::DoNotOptimize(viewport.pixels.data().data());
+    benchmark::ClobberMemory();
+  }
+
+  state.counters["tiles_drawn"] = static_cast<double>(tracker.tiles_drawn);
+}
+BENCHMARK(draw_idle)->Apply(add_viewport_sizes);
+
+void bitmap_render(benchmark::State &state, const bool changing)
+{
+  auto bitmap = std::make_shared<Bitmap>(viewport_size(state));
+  const auto colors = make_colors(bitmap->pixels.data().size(), 3, true);
+  std::copy(colors.begin(), colors.end(), bitmap->pixels.data().begin());
+
+  auto screen = ftxui::Screen::Create(ftxui::Dimension::Fixed(static_cast<int>(bitmap->pixels.size().width)),
+    ftxui::Dimension::Fixed(static_cast<int>(bitmap->pixels.size().height / 2)));
+
+  std::uint8_t frame = 0;
+  for ([[maybe_unused]] auto _ : state) {
+    if (changing) { bitmap->pixels.data().front().R = ++frame; }
+    ftxui::Render(screen, bitmap);
+    benchmark::DoNotOptimize(screen.PixelAt(0, 0));
+    screen.Clear();
+  }
+
+  state.counters["cells_updated"] = static_cast<double>(bitmap->cells_updated);
+}
+BENCHMARK_CAPTURE(bitmap_render, static, false)->Apply(add_viewport_sizes);
+BENCHMARK_CAPTURE(bitmap_render, one_cell_changing, true)->Apply(add_viewport_sizes);
+
+// a full redraw in palette colors, including the quantization pass
+void bitmap_render_palette(benchmark::State &state, const Color_Depth depth, const bool dither)
+{
+  auto bitmap = std::make_shared<Bitmap>(viewport_size(state));
+  const auto colors = make_colors(bitmap->pixels.data().size(), 3, true);
+  std::copy(colors.begin(), colors.end(), bitmap->pixels.data().begin());
+  bitmap->palette.emplace(depth, dither);
+
+  auto screen = ftxui::Screen::Create(ftxui::Dimension::Fixed(static_cast<int>(bitmap->pixels.size().width)),
+    ftxui::Dimension::Fixed(static_cast<int>(bitmap->pixels.size().height / 2)));
+
+  for ([[maybe_unused]] auto _ : state) {
+    // every cell changes, so every cell is quantized and converted
+    for (auto &pixel : bitmap->pixels.data()) { ++pixel.G; }
+    ftxui::Render(screen, bitmap);
+    benchmark::DoNotOptimize(screen.PixelAt(0, 0));
+    screen.Clear();
+  }
+
+  state.counters["cells_updated"] = static_cast<double>(bitmap->cells_updated);
+}
+BENCHMARK_CAPTURE(bitmap_render_palette, palette_256, Color_Depth::Palette_256, false)->Apply(add_viewport_sizes);
+BENCHMARK_CAPTURE(bitmap_render_palette, palette_256_dither, Color_Depth::Palette_256, true)
+  ->Apply(add_viewport_sizes);
+BENCHMARK_CAPTURE(bitmap_render_palette, palette_16, Color_Depth::Palette_16, false)->Apply(add_viewport_sizes);
+
+// the bytes FTXUI writes to the terminal for the bitmap each frame, it always redraws everything
+void bitmap_terminal_output(benchmark::State &state)
+{
+  auto bitmap = std::make_shared<Bitmap>(viewport_size(state));
+  const auto colors = make_colors(bitmap->pixels.data().size(), 3, true);
+  std::copy(colors.begin(), colors.end(), bitmap->pixels.data().begin());
+
+  auto screen = ftxui::Screen::Create(ftxui::Dimension::Fixed(static_cast<int>(bitmap->pixels.size().width)),
+    ftxui::Dimension::Fixed(static_cast<int>(bitmap->pixels.size().height / 2)));
+
+  std::size_t bytes = 0;
+  std::uint8_t frame = 0;
+  for ([[maybe_unused]] auto _ : state) {
+    bitmap->pixels.data().front().R = ++frame;
+    ftxui::Render(screen, bitmap);
+    bytes = screen.ToString().size();
+    screen.Clear();
+  }
+
+  state.counters["bytes_per_frame"] = static_cast<double>(bytes);
+}
+BENCHMARK(bitmap_terminal_output)->Apply(add_viewport_sizes);
+
+// the same with Ansi_Encoder, which only writes the one cell that changed
+void bitmap_ansi_encode(benchmark::State &state, const bool full_frame)
+{
+  Vector2D<Color> pixels{ viewport_size(state) };
+  const auto colors = make_colors(pixels.data().size(), 3, true);
+  std::copy(colors.begin(), colors.end(), pixels.data().begin());
+
+  Ansi_Encoder encoder;
+  std::uint8_t frame = 0;
+  for ([[maybe_unused]] auto _ : state) {
+    pixels.data().front().R = ++frame;
+    if (full_frame) { encoder.invalidate(); }
+    benchmark::DoNotOptimize(encoder.encode(pixels).data());
+  }
+
+  state.counters["bytes_per_frame"] = static_cast<double>(encoder.stats().bytes);
+}
+BENCHMARK_CAPTURE(bitmap_ansi_encode, full_frame, true)->Apply(add_viewport_sizes);
+BENCHMARK_CAPTURE(bitmap_ansi_encode, one_cell_changing, false)->Apply(add_viewport_sizes);
+
+// a 1000x1000 map of 25x25 rooms with a door in the middle of each wall, and clutter in them
+Passability_Grid make_rooms_map(std::uint32_t seed)
+{
+  constexpr std::size_t map_size = 1000;
+  constexpr std::size_t room_size = 25;
+
+  const auto next = [&seed] {
+    seed = seed * 1664525U + 1013904223U;// NOLINT magic numbers
+    return seed >> 8U;// NOLINT magic numbers
+  };
+
+  Passability_Grid grid{ Size{ map_size, map_size } };
+  for (std::size_t cur_y = 0; cur_y < map_size; ++cur_y) {
+    for (std::size_t cur_x = 0; cur_x < map_size; ++cur_x) {
+      const auto wall = cur_x % room_size == 0 || cur_y % room_size == 0;
+      const auto door = cur_x % room_size == room_size / 2 || cur_y % room_size == room_size / 2;
+      if ((wall && !door) || next() % 10 == 0) { grid.set_entry_mask(Point{ cur_x, cur_y }, 0); }// NOLINT
+    }
+  }
+  return grid;
+}
+
+// queries between cells that can be entered, at most `max_distance` apart on each axis
+void find_path(benchmark::State &state, const std::size_t max_distance)
+{
+  Path_Finder finder{ make_rooms_map(1) };
+
+  std::uint32_t seed = 2;
+  const auto next = [&seed](const std::size_t limit) {
+    seed = seed * 1664525U + 1013904223U;// NOLINT magic numbers
+    return static_cast<std::size_t>(seed >> 8U) % limit;// NOLINT magic numbers
+  };
+  // somewhere on the map within `max_distance` of `center`
+  const auto near = [&](const std::size_t center) {
+    const auto low = center > max_distance ? center - max_distance : 0;
+    const auto high = std::min(center + max_distance, std::size_t{ 999 });// NOLINT magic numbers
+    return low + next(high - low + 1);
+  };
+  const auto open_cell = [&](const Point center) {
+    while (true) {
+      const auto cell = Point{ near(center.x), near(center.y) };
+      if (finder.grid().entry_mask(cell) != 0) { return cell; }
+    }
+  };
+
+  std::vector<std::pair<Point, Point>> queries;
+  for (int query = 0; query < 64; ++query) {// NOLINT magic numbers
+    const auto from = open_cell(Point{ next(1000), next(1000) });// NOLINT magic numbers
+    queries.emplace_back(from, open_cell(from));
+  }
+
+  std::size_t index = 0;
+  std::size_t nodes_expanded = 0;
+  std::size_t cells_expanded = 0;
+  for ([[maybe_unused]] auto _ : state) {
+    const auto &[from, to] = queries[index++ % queries.size()];
+    benchmark::DoNotOptimize(finder.find_path(from, to));
+    nodes_expanded += finder.stats().nodes_expanded;
+    cells_expanded += finder.stats().cells_expanded;
+  }
+
+  const auto iterations = static_cast<double>(state.iterations());
+  state.counters["nodes_expanded"] = static_cast<double>(nodes_expanded) / iterations;
+  state.counters["cells_expanded"] = static_cast<double>(cells_expanded) / iterations;
+}
+BENCHMARK_CAPTURE(find_path, nearby, 20)->Unit(benchmark::kMicrosecond);// NOLINT magic numbers
+BENCHMARK_CAPTURE(find_path, across_the_map, 1000)->Unit(benchmark::kMicrosecond);// NOLINT magic numbers
+
+// a door opening and closing, and the components labeled again
+void path_finder_update(benchmark::State &state)
+{
+  Path_Finder finder{ make_rooms_map(1) };
+  const auto door = Point{ 500, 512 };// NOLINT magic numbers
+
+  bool open = false;
+  for ([[maybe_unused]] auto _ : state) {
+    open = !open;
+    finder.set_entry_mask(door, open ? Passability_Grid::all_sides : std::uint8_t{ 0 });
+    benchmark::DoNotOptimize(finder.component(door));
+  }
+}
+BENCHMARK(path_finder_update)->Unit(benchmark::kMicrosecond);
+
+// what opening a door costs before the landmarks are good again
+void path_finder_place_landmarks(benchmark::State &state)
+{
+  Path_Finder finder{ make_rooms_map(1) };
+  for ([[maybe_unused]] auto _ : state) { finder.place_landmarks(); }
+}
+BENCHMARK(path_finder_place_landmarks)->Unit(benchmark::kMillisecond);
+
+}// namespace
@@ -0,0 +1,132 @@
+#include "ansi_encoder.hpp"
+
+#include <array>
+
+namespace lefticus::travels {
+
+namespace {
+  [[nodiscard]] bool same_rgb(const Color lhs, const Color rhs) noexcept
+  {
+    return lhs.R == rhs.R && lhs.G == rhs.G && lhs.B == rhs.B;
+  }
+}// namespace
+
+
+std::string_view Ansi_Encoder::encode(const Vector2D<Color> &pixels, const Point origin)
+{
+  const auto cells_size = Size{ pixels.size().width, pixels.size().height / 2 };
+
+  if (previous_.size() != cells_size || previous_origin_ != origin) {
+    previous_ = Vector2D<Cell>{ cells_size };
+    previous_origin_ = origin;
+    valid_ = false;
+  }
+
+  buffer_.clear();
+  stats_ = Stats{};
+  cursor_.reset();
+  foreground_.reset();
+  background_.reset();
+
+  for (std::size_t cur_y = 0; cur_y < cells_size.height; ++cur_y) {
+    const auto top_row = pixels.row(cur_y * 2);
+    const auto bottom_row = pixels.row(cur_y * 2 + 1);
+    const auto previous_row = previous_.row(cur_y);
+
+    for (std::size_t cur_x = 0; cur_x < cells_size.width; ++cur_x) {
+      const auto cell = Cell{ top_row[cur_x], bottom_row[cur_x] };
+      const auto &previous = previous_row[cur_x];
+      if (valid_ && same_rgb(previous.top, cell.top) && same_rgb(previous.bottom, cell.bottom)) { continue; }
+      previous_row[cur_x] = cell;
+
+      move_to(origin + Point{ cur_x, cur_y });
+
+      if (same_rgb(cell.top, cell.bottom)) {
+        set_colors(std::nullopt, cell.top);
+        buffer_ += ' ';
+      } else {
+        set_colors(cell.bottom, cell.top);
+        buffer_ += "▄";// lower half block
+      }
+
+      cursor_ = origin + Point{ cur_x + 1, cur_y };
+      ++stats_.cells_written;
+    }
+  }
+
+  // leave the terminal the way it was found for whatever is written after this
+  if (foreground_ || background_) { buffer_ += "\x1b[0m"; }
+
+  valid_ = true;
+  stats_.bytes = buffer_.size();
+  return buffer_;
+}
+
+void Ansi_Encoder::move_to(const Point cell)
+{
+  if (cursor_ == cell) { return; }
+
+  if (cursor_ && cursor_->y == cell.y && cursor_->x < cell.x) {
+    // forward on the same row, "\x1b[nC"
+    buffer_ += "\x1b[";
+    append_number(cell.x - cursor_->x);
+    buffer_ += 'C';
+  } else {
+    // "\x1b[row;columnH", 1 based
+    buffer_ += "\x1b[";
+    append_number(cell.y + 1);
+    buffer_ += ';';
+    append_number(cell.x + 1);
+    buffer_ += 'H';
+  }
+
+  cursor_ = cell;
+}
+
+void Ansi_Encoder::set_colors(const std::optional<Color> foreground, const Color background)
+{
+  const bool set_foreground = foreground && !(foreground_ && same_rgb(*foreground_, *foreground));
+  const bool set_background = !(background_ && same_rgb(*background_, background));
+  if (!set_foreground && !set_background) { return; }
+
+  // both in one sequence when both change
+  buffer_ += "\x1b[";
+  if (set_foreground) {
+    buffer_ += "38;2;";
+    append_color(*foreground);
+    foreground_ = foreground;
+  }
+  if (set_background) {
+    if (set_foreground) { buffer_ += ';'; }
+    buffer_ += "48;2;";
+    append_color(background);
+    background_ = background;
+  }
+  buffer_ += 'm';
+
+  ++stats_.color_changes;
+}
+
+void Ansi_Encoder::append_number(std::size_t value)
+{
+  std::array<char, 20> digits{};// NOLINT magic number, enough for any 64 bit value
+  auto first = digits.end();
+  do {
+    --first;
+    *first = static_cast<char>('0' + value % 10);// NOLINT magic number
+    value /= 10;// NOLINT magic number
+  } while (value != 0);
+
+  buffer_.append(first, digits.end());
+}
+
+void Ansi_Encoder::append_color(const Color color)
+{
+  append_number(color.R);
+  buffer_ += ';';
+  append_number(color.G);
+  buffer_ += ';';
+  append_number(color.B);
+}
+
+}// namespace lefticus::travels
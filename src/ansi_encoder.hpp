@@ -0,0 +1,72 @@
+#ifndef AWESOME_GAME_ANSI_ENCODER_HPP
+#define AWESOME_GAME_ANSI_ENCODER_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "color.hpp"
+#include "point.hpp"
+#include "vector2d.hpp"
+
+namespace lefticus::travels {
+
+// Encodes a bitmap straight to truecolor ANSI escape sequences, two pixels per terminal cell
+// with the lower half block, the same way Bitmap::Render shows it through FTXUI.
+//
+// The terminal is assumed to still show what the previous call wrote, so only cells that changed
+// are written and the cursor jumps over the rest. Colors are only set when they differ from the
+// ones in effect, so runs of identical cells are just repeated characters, and cells whose two
+// pixels are the same are a space that only needs a background color. Alpha is ignored.
+//
+// For now this only measures what the viewport would cost to send (see Headless_Report): the
+// interactive game still draws through FTXUI, which redraws the whole screen every frame.
+class Ansi_Encoder
+{
+public:
+  // The escape sequences for `pixels` drawn with its upper left corner at terminal cell `origin`
+  // (column, row from 0). Valid until the next call, the buffer is reused between frames.
+  [[nodiscard]] std::string_view encode(const Vector2D<Color> &pixels, Point origin = {});
+
+  // the terminal was cleared or written over, the next call writes every cell
+  void invalidate() noexcept { valid_ = false; }
+
+  struct Stats
+  {
+    std::size_t bytes = 0;
+    std::size_t cells_written = 0;
+    std::size_t color_changes = 0;
+  };
+
+  // of the last call to `encode`
+  [[nodiscard]] const Stats &stats() const noexcept { return stats_; }
+
+private:
+  struct Cell
+  {
+    Color top;
+    Color bottom;
+  };
+
+  void move_to(Point cell);
+  void set_colors(std::optional<Color> foreground, Color background);
+  void append_number(std::size_t value);
+  void append_color(Color color);
+
+  Vector2D<Cell> previous_{ Size{ 0, 0 } };
+  Point previous_origin_{};
+  bool valid_ = false;
+
+  std::string buffer_;
+  Stats stats_;
+
+  // terminal state while encoding, unknown at the start of each frame
+  std::optional<Point> cursor_;
+  std::optional<Color> foreground_;
+  std::optional<Color> background_;
+};
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_ANSI_ENCODER_HPP
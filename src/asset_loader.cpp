@@ -0,0 +1,172 @@
+#include "asset_loader.hpp"
+#include "compiled_map.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#ifdef _MSC_VER
+#pragma warning(disable : 4189)
+#endif
+#include <spdlog/spdlog.h>
+#ifdef _MSC_VER
+#pragma warning(default : 4189)
+#endif
+
+namespace lefticus::travels {
+
+namespace {
+  // shared by the tasks loading one map, the last tile set to finish completes the map
+  class Tiled_Map_Load
+  {
+  public:
+    Tiled_Map_Load(std::function<void(Tiled_Map)> then, std::function<void(std::exception_ptr)> fail)
+      : then_{ std::move(then) }, fail_{ std::move(fail) }
+    {}
+
+    Tiled_Map map;
+
+    void start_tile_sets(const std::size_t count)
+    {
+      map.tile_sets.resize(count);
+      remaining_ = count;
+      if (count == 0) { finish(); }
+    }
+
+    void failed(std::exception_ptr error)
+    {
+      const std::scoped_lock lock{ mutex_ };
+      if (!error_) { error_ = std::move(error); }
+    }
+
+    // once for every tile set, whether it loaded or not
+    void tile_set_done()
+    {
+      if (remaining_.fetch_sub(1) == 1) { finish(); }
+    }
+
+    void finish()
+    {
+      {
+        const std::scoped_lock lock{ mutex_ };
+        if (error_) {
+          fail_(error_);
+          return;
+        }
+      }
+
+      try {
+        then_(std::move(map));
+      } catch (...) {
+        fail_(std::current_exception());
+      }
+    }
+
+  private:
+    std::function<void(Tiled_Map)> then_;
+    std::function<void(std::exception_ptr)> fail_;
+
+    std::atomic<std::size_t> remaining_ = 0;
+    std::mutex mutex_;
+    std::exception_ptr error_;
+  };
+}// namespace
+
+
+std::future<Tiled_Map> Asset_Loader::read_tiled_map(const std::filesystem::path &map_json)
+{
+  auto result = std::make_shared<std::promise<Tiled_Map>>();
+  auto future = result->get_future();
+
+  read_tiled_map(
+    map_json,
+    [result](Tiled_Map tiled_map) { result->set_value(std::move(tiled_map)); },
+    [result](std::exception_ptr error) { result->set_exception(std::move(error)); });
+
+  return future;
+}
+
+std::future<Game_Map> Asset_Loader::load_map(const std::filesystem::path &map_json,
+  std::vector<std::filesystem::path> search_paths)
+{
+  auto result = std::make_shared<std::promise<Game_Map>>();
+  auto future = result->get_future();
+
+  pool_.post([this, result, map_json, search_paths = std::move(search_paths)] {
+    std::filesystem::path path;
+
+    try {
+      path = find_map(map_json, search_paths);
+
+      if (const auto compiled_path = up_to_date_compiled_map(path)) {
+        try {
+          result->set_value(load_compiled_map(*compiled_path));
+          return;
+        } catch (const std::exception &e) {
+          spdlog::warn("Unable to load compiled map '{}', loading '{}' instead: {}",
+            compiled_path->string(),
+            path.string(),
+            e.what());
+        }
+      }
+    } catch (...) {
+      result->set_exception(std::current_exception());
+      return;
+    }
+
+    read_tiled_map(
+      path,
+      [result](Tiled_Map tiled_map) { result->set_value(make_game_map(std::move(tiled_map))); },
+      [result](std::exception_ptr error) { result->set_exception(std::move(error)); });
+  });
+
+  return future;
+}
+
+void Asset_Loader::read_tiled_map(const std::filesystem::path &map_json,
+  std::function<void(Tiled_Map)> then,
+  std::function<void(std::exception_ptr)> fail)
+{
+  auto load = std::make_shared<Tiled_Map_Load>(std::move(then), std::move(fail));
+
+  pool_.post([this, load, map_json] {
+    Tiled_Map_Layout layout;
+    try {
+      layout = read_tiled_map_layout(map_json);
+    } catch (...) {
+      load->failed(std::current_exception());
+      load->finish();
+      return;
+    }
+
+    load->map = std::move(layout.map);
+    load->start_tile_sets(layout.tile_sets.size());
+
+    for (std::size_t index = 0; index < layout.tile_sets.size(); ++index) {
+      pool_.post([this, load, index, map_json, source = std::move(layout.tile_sets[index])] {
+        try {
+          const auto tile_set = assets_.tile_set(source.tsj);
+          load->map.tile_sets[index].start_id = source.start_id;
+          load->map.tile_sets[index].properties = tile_set->properties;
+          load->map.tile_sets[index].tsj = map_source(map_json, source.tsj);
+
+          // the image is its own task, it is by far the slowest part
+          pool_.post([this, load, index, map_json, image = tile_set->image] {
+            try {
+              load->map.tile_sets[index].image = assets_.image(image);
+              load->map.tile_sets[index].image_file = map_source(map_json, image);
+            } catch (...) {
+              load->failed(std::current_exception());
+            }
+            load->tile_set_done();
+          });
+        } catch (...) {
+          load->failed(std::current_exception());
+          load->tile_set_done();
+        }
+      });
+    }
+  });
+}
+
+}// namespace lefticus::travels
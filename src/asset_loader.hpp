@@ -0,0 +1,53 @@
+#ifndef AWESOME_GAME_ASSET_LOADER_HPP
+#define AWESOME_GAME_ASSET_LOADER_HPP
+
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <vector>
+
+#include "asset_registry.hpp"
+#include "game_components.hpp"
+#include "thread_pool.hpp"
+
+namespace lefticus::travels {
+
+// Loads maps on a Thread_Pool.
+//
+// Each map is split into tasks: the map JSON, then every tile set JSON, then every tile set
+// image, and finally the Game_Map built from them. Each step is submitted as soon as its inputs
+// are ready, so all the tile sets of all the maps being loaded are decoded in parallel, and each
+// map is ready as soon as its own files are.
+//
+// Tile sets and images come from `assets`, so files shared between maps are only loaded once.
+//
+// The pool has to outlive every load that was started on it.
+class Asset_Loader
+{
+public:
+  explicit Asset_Loader(Thread_Pool &pool, Asset_Registry &assets = Asset_Registry::shared())
+    : pool_{ pool }, assets_{ assets }
+  {}
+
+  // same as the free `read_tiled_map`
+  [[nodiscard]] std::future<Tiled_Map> read_tiled_map(const std::filesystem::path &map_json);
+
+  // same as the free `load_map`, including the preference for compiled maps
+  [[nodiscard]] std::future<Game_Map> load_map(const std::filesystem::path &map_json,
+    std::vector<std::filesystem::path> search_paths);
+
+private:
+  // `then` runs on the pool once the map is complete, if it throws `fail` is called instead.
+  // Exactly one of the two is called.
+  void read_tiled_map(const std::filesystem::path &map_json,
+    std::function<void(Tiled_Map)> then,
+    std::function<void(std::exception_ptr)> fail);
+
+  Thread_Pool &pool_;
+  Asset_Registry &assets_;
+};
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_ASSET_LOADER_HPP
@@ -0,0 +1,112 @@
+#include "asset_registry.hpp"
+#include "bitmap.hpp"
+#include "game_components.hpp"
+
+#include <algorithm>
+
+namespace lefticus::travels {
+
+namespace {
+  std::string path_key(const std::filesystem::path &path)
+  {
+    std::error_code error;
+    auto canonical = std::filesystem::weakly_canonical(path, error);
+    return error ? path.lexically_normal().string() : canonical.string();
+  }
+}// namespace
+
+
+Asset_Registry &Asset_Registry::shared()
+{
+  static Asset_Registry registry;
+  return registry;
+}
+
+Asset_Registry::Image Asset_Registry::image(const std::filesystem::path &png)
+{
+  return find_or_load(images_, png, [this, &png] { return image(load_png(png)); });
+}
+
+Asset_Registry::Image Asset_Registry::image(Vector2D<Color> pixels)
+{
+  const auto hash = content_hash(pixels);
+
+  const std::scoped_lock lock{ mutex_ };
+
+  auto [first, last] = images_by_content_.equal_range(hash);
+  while (first != last) {
+    auto existing = first->second.lock();
+    if (!existing) {
+      first = images_by_content_.erase(first);
+      continue;
+    }
+
+    if (existing->size() == pixels.size() && std::ranges::equal(existing->data(), pixels.data())) {
+      ++stats_.reuses;
+      return existing;
+    }
+    ++first;
+  }
+
+  auto result = std::make_shared<const Vector2D<Color>>(std::move(pixels));
+  images_by_content_.emplace(hash, result);
+  return result;
+}
+
+std::shared_ptr<const Tiled_Tile_Set> Asset_Registry::tile_set(const std::filesystem::path &tsj)
+{
+  return find_or_load(
+    tile_sets_, tsj, [&tsj] { return std::make_shared<const Tiled_Tile_Set>(read_tiled_tile_set(tsj)); });
+}
+
+Asset_Registry::Stats Asset_Registry::stats() const
+{
+  const std::scoped_lock lock{ mutex_ };
+  return stats_;
+}
+
+template<typename Asset, typename Load>
+std::shared_ptr<const Asset> Asset_Registry::find_or_load(std::unordered_map<std::string, Entry<Asset>> &entries,
+  const std::filesystem::path &path,
+  Load load)
+{
+  std::unique_lock lock{ mutex_ };
+
+  // unordered_map never moves its elements, so this stays valid while the lock is released
+  auto &entry = entries[path_key(path)];
+
+  if (auto asset = entry.asset.lock()) {
+    ++stats_.reuses;
+    return asset;
+  }
+
+  if (entry.loading.valid()) {
+    ++stats_.reuses;
+    auto loading = entry.loading;
+    lock.unlock();
+    return loading.get();
+  }
+
+  std::promise<std::shared_ptr<const Asset>> promise;
+  entry.loading = promise.get_future().share();
+  lock.unlock();
+
+  std::shared_ptr<const Asset> asset;
+  try {
+    asset = load();
+  } catch (...) {
+    promise.set_exception(std::current_exception());
+    lock.lock();
+    entry.loading = {};
+    throw;
+  }
+
+  promise.set_value(asset);
+  lock.lock();
+  entry.asset = asset;
+  entry.loading = {};
+  ++stats_.loads;
+  return asset;
+}
+
+}// namespace lefticus::travels
@@ -0,0 +1,71 @@
+#ifndef AWESOME_GAME_ASSET_REGISTRY_HPP
+#define AWESOME_GAME_ASSET_REGISTRY_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "color.hpp"
+#include "vector2d.hpp"
+
+namespace lefticus::travels {
+
+struct Tiled_Tile_Set;
+
+// Hands out shared, immutable copies of the assets maps are built from, so a file that is used
+// by several maps is only loaded and kept in memory once.
+//
+// Files are identified by their canonical path. Images are also compared by content, so two
+// identical images loaded from different files, or out of compiled maps, are still stored once.
+//
+// Assets are only held on to while something is using them. Safe to use from any thread, if two
+// threads ask for the same file at the same time it is loaded once and both get the result.
+class Asset_Registry
+{
+public:
+  // the registry the game's loaders use
+  [[nodiscard]] static Asset_Registry &shared();
+
+  using Image = std::shared_ptr<const Vector2D<Color>>;
+
+  // throws whatever decoding the file throws
+  [[nodiscard]] Image image(const std::filesystem::path &png);
+  [[nodiscard]] Image image(Vector2D<Color> pixels);
+
+  // the tile set's properties and the path of its image, which is not loaded
+  [[nodiscard]] std::shared_ptr<const Tiled_Tile_Set> tile_set(const std::filesystem::path &tsj);
+
+  struct Stats
+  {
+    std::size_t loads = 0;
+    std::size_t reuses = 0;// requests answered with an asset that was already loaded
+  };
+
+  [[nodiscard]] Stats stats() const;
+
+private:
+  template<typename Asset> struct Entry
+  {
+    std::weak_ptr<const Asset> asset;
+    std::shared_future<std::shared_ptr<const Asset>> loading;// only while it is being loaded
+  };
+
+  template<typename Asset, typename Load>
+  std::shared_ptr<const Asset> find_or_load(std::unordered_map<std::string, Entry<Asset>> &entries,
+    const std::filesystem::path &path,
+    Load load);
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Entry<Vector2D<Color>>> images_;
+  std::unordered_multimap<std::uint64_t, std::weak_ptr<const Vector2D<Color>>> images_by_content_;
+  std::unordered_map<std::string, Entry<Tiled_Tile_Set>> tile_sets_;
+  Stats stats_;
+};
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_ASSET_REGISTRY_HPP
@@ -2,7 +2,85 @@
 
 #include "bitmap.hpp"
 
+#include <ftxui/screen/terminal.hpp>
+
 namespace lefticus::travels {
+void Bitmap::Render(ftxui::Screen &screen)
+{
+  const auto cells_size = Size{ pixels.size().width, pixels.size().height / 2 };
+
+  const auto depth = palette ? std::optional{ palette->depth() } : std::nullopt;
+  const bool dither = palette && palette->dither();
+
+  const bool resized = cells.size() != cells_size || rendered_depth != depth || rendered_dither != dither;
+  if (resized) {
+    cells = Vector2D<Cell>{ cells_size };
+    rendered_depth = depth;
+    rendered_dither = dither;
+  }
+
+  // one pass over the whole frame, cheaper than looking up each changed pixel on its own
+  if (palette) {
+    if (palette_indices.size() != pixels.size()) { palette_indices = Vector2D<std::uint8_t>{ pixels.size() }; }
+    palette->quantize(pixels, palette_indices);
+  }
+
+  const auto to_ftxui = [&](const Color color, const Point position) {
+    if (!palette) { return ftxui::Color{ color.R, color.G, color.B }; }
+
+    const auto index = palette_indices.unchecked_at(position);
+    if (palette->depth() == Color_Depth::Palette_16) {
+      return ftxui::Color{ static_cast<ftxui::Color::Palette16>(index) };
+    }
+    return ftxui::Color{ static_cast<ftxui::Color::Palette256>(index) };
+  };
+
+  cells_updated = 0;
+
+  // FTXUI clears the screen after every frame, so every cell still needs to be written,
+  // but constructing `ftxui::Color`s can be expensive (palette lookups on terminals without true color)
+  for (std::size_t cur_y = 0; cur_y < cells_size.height; ++cur_y) {
+    const auto top_row = pixels.row(cur_y * 2);
+    const auto bottom_row = pixels.row(cur_y * 2 + 1);
+    const auto cell_row = cells.row(cur_y);
+
+    for (std::size_t cur_x = 0; cur_x < cells_size.width; ++cur_x) {
+      auto &cell = cell_row[cur_x];
+      const auto &top_color = top_row[cur_x];
+      const auto &bottom_color = bottom_row[cur_x];
+
+      if (resized || cell.top != top_color || cell.bottom != bottom_color) {
+        cell.top = top_color;
+        cell.bottom = bottom_color;
+        cell.background = to_ftxui(top_color, Point{ cur_x, cur_y * 2 });
+        cell.foreground = to_ftxui(bottom_color, Point{ cur_x, cur_y * 2 + 1 });
+        ++cells_updated;
+      }
+
+      static const std::string lower_half_block = "▄";
+
+      auto &ftxui_pixel = screen.PixelAt(box_.x_min + static_cast<int>(cur_x), box_.y_min + static_cast<int>(cur_y));
+      ftxui_pixel.character = lower_half_block;
+      ftxui_pixel.background_color = cell.background;
+      ftxui_pixel.foreground_color = cell.foreground;
+    }
+  }
+}
+
+Color_Depth detect_color_depth()
+{
+  switch (ftxui::Terminal::ColorSupport()) {
+  case ftxui::Terminal::Color::TrueColor:
+    return Color_Depth::True_Color;
+  case ftxui::Terminal::Color::Palette256:
+    return Color_Depth::Palette_256;
+  case ftxui::Terminal::Color::Palette1:
+  case ftxui::Terminal::Color::Palette16:
+  default:
+    return Color_Depth::Palette_16;
+  }
+}
+
 Vector2D<Color> load_png(const std::filesystem::path &filename)
 {
   std::vector<unsigned char> image;// the raw pixels
@@ -22,17 +100,30 @@ Vector2D<Color> load_png(const std::filesystem::path &filename)
   Vector2D<Color> results{ Size{ static_cast<std::size_t>(width), static_cast<std::size_t>(height) } };
 
   std::size_t position = 0;
-  for (std::size_t cur_y = 0; cur_y < results.size().height; ++cur_y) {
-    for (std::size_t cur_x = 0; cur_x < results.size().width; ++cur_x) {
-      auto &color = results.at(Point{ cur_x, cur_y });
-      // cppcheck is wrong about this.
-      color.R = image[position++];// cppcheck-suppress danglingTempReference
-      color.G = image[position++];// cppcheck-suppress danglingTempReference
-      color.B = image[position++];// cppcheck-suppress danglingTempReference
-      color.A = image[position++];// cppcheck-suppress danglingTempReference
-    }
+  for (auto &color : results.data()) {
+    color.R = image[position++];
+    color.G = image[position++];
+    color.B = image[position++];
+    color.A = image[position++];
   }
 
   return results;
 }
+
+std::uint64_t content_hash(const Vector2D<Color> &pixels) noexcept
+{
+  std::uint64_t hash = 14695981039346656037ULL;// NOLINT magic numbers
+  const auto add = [&hash](const std::uint64_t value) {
+    hash ^= value;
+    hash *= 1099511628211ULL;// NOLINT magic numbers
+  };
+
+  add(pixels.size().width);
+  add(pixels.size().height);
+  for (const auto &pixel : pixels.data()) {
+    add((std::uint64_t{ pixel.R } << 24U) | (std::uint64_t{ pixel.G } << 16U)// NOLINT magic numbers
+        | (std::uint64_t{ pixel.B } << 8U) | pixel.A);// NOLINT magic numbers
+  }
+  return hash;
+}
 }// namespace lefticus::travels
\ No newline at end of file
@@ -1,10 +1,14 @@
 #ifndef AWESOME_GAME_BITMAP_HPP
 #define AWESOME_GAME_BITMAP_HPP
 
+#include <cstdint>
 #include <filesystem>
 #include <ftxui/dom/node.hpp>
+#include <ftxui/screen/screen.hpp>
+#include <optional>
 
 #include "color.hpp"
+#include "palette.hpp"
 #include "size.hpp"
 #include "vector2d.hpp"
 #include <fmt/format.h>
@@ -23,25 +27,46 @@ struct Bitmap : ftxui::Node
       .selected_box{ 0, 0, 0, 0 } };
   }
 
-  void Render(ftxui::Screen &screen) override
-  {
-    for (std::size_t cur_x = 0; cur_x < pixels.size().width; ++cur_x) {
-      for (std::size_t cur_y = 0; cur_y < pixels.size().height / 2; ++cur_y) {
-        auto &ftxui_pixel = screen.PixelAt(box_.x_min + static_cast<int>(cur_x), box_.y_min + static_cast<int>(cur_y));
-        ftxui_pixel.character = "▄";
-        const auto &top_color = pixels.at(Point{ cur_x, cur_y * 2 });
-        const auto &bottom_color = pixels.at(Point{ cur_x, cur_y * 2 + 1 });
-        ftxui_pixel.background_color = ftxui::Color{ top_color.R, top_color.G, top_color.B };
-        ftxui_pixel.foreground_color = ftxui::Color{ bottom_color.R, bottom_color.G, bottom_color.B };
-      }
-    }
-  }
+  // Each terminal cell shows two pixels using the lower half block character.
+  // The FTXUI colors for a cell are only recomputed when one of its two pixels changed.
+  void Render(ftxui::Screen &screen) override;
 
   Vector2D<Color> pixels;
+
+  // if set, cells are given to FTXUI as entries of this palette instead of 24 bit colors,
+  // so it doesn't have to convert every cell on terminals without true color
+  std::optional<Palette_Quantizer> palette;
+
+  // how many terminal cells changed color in the last call to `Render`
+  std::size_t cells_updated = 0;
+
+private:
+  struct Cell
+  {
+    Color top;
+    Color bottom;
+    ftxui::Color background;
+    ftxui::Color foreground;
+  };
+
+  // what was emitted for each terminal cell last time
+  Vector2D<Cell> cells{ Size{ 0, 0 } };
+
+  // the palette `cells` were computed with
+  std::optional<Color_Depth> rendered_depth;
+  bool rendered_dither = false;
+
+  Vector2D<std::uint8_t> palette_indices{ Size{ 0, 0 } };
 };
 
+// what the terminal FTXUI is drawing to supports
+[[nodiscard]] Color_Depth detect_color_depth();
+
 Vector2D<Color> load_png(const std::filesystem::path &filename);
 
+// FNV-1a of the size and every pixel, equal images always have equal hashes
+[[nodiscard]] std::uint64_t content_hash(const Vector2D<Color> &pixels) noexcept;
+
 }// namespace lefticus::travels
 
 #endif// AWESOME_GAME_BITMAP_HPP
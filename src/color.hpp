@@ -61,29 +61,65 @@ template<typename Type> struct Basic_Color
 
   template<typename RHS> constexpr auto &operator+=(Basic_Color<RHS> rhs) noexcept
   {
-    // from stackoverflow
-    // Short answer:
-    // if we want to overlay color0 over color1 both with some alpha then
-    // a01 = (1 - a0)·a1 + a0
-    // r01 = ((1 - a0)·a1·r1 + a0·r0) / a01
-    // g01 = ((1 - a0)·a1·g1 + a0·g0) / a01
-    // b01 = ((1 - a0)·a1·b1 + a0·b0) / a01
-
-    const auto color1 = color_cast<double>(*this);
-    const auto color0 = color_cast<double>(rhs);
-    auto color01 = Basic_Color<double>{};
-
-    color01.A = (1 - color0.A) * color1.A + color0.A;
-    color01.R = ((1 - color0.A) * color1.A * color1.R + color0.A * color0.R) / color01.A;
-    color01.G = ((1 - color0.A) * color1.A * color1.G + color0.A * color0.G) / color01.A;
-    color01.B = ((1 - color0.A) * color1.A * color1.B + color0.A * color0.B) / color01.A;
-
-    *this = color_cast<Type>(color01);
+    if constexpr (std::is_same_v<Type, std::uint8_t> && std::is_same_v<RHS, std::uint8_t>) {
+      // see `blend` below for the fast integer version
+      *this = blend(*this, rhs);
+    } else {
+      // from stackoverflow
+      // Short answer:
+      // if we want to overlay color0 over color1 both with some alpha then
+      // a01 = (1 - a0)·a1 + a0
+      // r01 = ((1 - a0)·a1·r1 + a0·r0) / a01
+      // g01 = ((1 - a0)·a1·g1 + a0·g0) / a01
+      // b01 = ((1 - a0)·a1·b1 + a0·b0) / a01
+
+      const auto color1 = color_cast<double>(*this);
+      const auto color0 = color_cast<double>(rhs);
+      auto color01 = Basic_Color<double>{};
+
+      color01.A = (1 - color0.A) * color1.A + color0.A;
+      color01.R = ((1 - color0.A) * color1.A * color1.R + color0.A * color0.R) / color01.A;
+      color01.G = ((1 - color0.A) * color1.A * color1.G + color0.A * color0.G) / color01.A;
+      color01.B = ((1 - color0.A) * color1.A * color1.B + color0.A * color0.B) / color01.A;
+
+      *this = color_cast<Type>(color01);
+    }
     return *this;
   }
 };
 
 using Color = Basic_Color<std::uint8_t>;
+
+// Integer version of `Basic_Color::operator+=` for 8 bit colors: draws `over` on top of `under`.
+//
+// Every channel is the exact rational result of the floating point formula, rounded half up.
+// Compared to the `double` implementation the result differs by at most 1, and only
+// where the exact result lies on a .5 boundary and the `double` math lands on the other side of it
+// (~190k of the 2^32 possible inputs). When both alphas are 0 the result is transparent black.
+[[nodiscard]] constexpr Color blend(const Color under, const Color over) noexcept
+{
+  constexpr std::uint32_t max = std::numeric_limits<std::uint8_t>::max();
+
+  // the common cases: opaque or fully transparent tile pixels
+  if (over.A == max) { return over; }
+  if (over.A == 0 && under.A != 0) { return under; }
+
+  const std::uint32_t under_weight = (max - over.A) * under.A;
+  const std::uint32_t over_weight = max * over.A;
+  const std::uint32_t total_weight = under_weight + over_weight;
+
+  if (total_weight == 0) { return Color{}; }
+
+  const auto channel = [&](const std::uint8_t under_channel, const std::uint8_t over_channel) {
+    return static_cast<std::uint8_t>(
+      (2 * (under_weight * under_channel + over_weight * over_channel) + total_weight) / (2 * total_weight));
+  };
+
+  return Color{ channel(under.R, over.R),
+    channel(under.G, over.G),
+    channel(under.B, over.B),
+    static_cast<std::uint8_t>((2 * total_weight + max) / (2 * max)) };
+}
 }// namespace lefticus::travels
 
 #endif// AWESOME_GAME_COLOR_HPP
@@ -0,0 +1,202 @@
+#ifndef AWESOME_GAME_COLOR_BLEND_HPP
+#define AWESOME_GAME_COLOR_BLEND_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "color.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TRAVELS_BLEND_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRAVELS_BLEND_SSE2 1
+#endif
+
+namespace lefticus::travels {
+
+static_assert(sizeof(Color) == 4, "the vectorized blend kernels assume tightly packed RGBA colors");
+
+namespace detail {
+  // The vector kernels only handle the case where every destination pixel is opaque,
+  // which is what the background pass always leaves behind. Then the result alpha is always
+  // 255 and each channel is round((src * a + dst * (255 - a)) / 255), computed exactly
+  // in 16 bits with the usual (t + (t >> 8)) >> 8 trick. That is bit-identical to `blend`.
+  //
+  // Anything else goes through the scalar `blend`.
+
+#if defined(TRAVELS_BLEND_SSE2) || defined(TRAVELS_BLEND_AVX2)
+  // 8 16-bit lanes, 2 pixels
+  [[nodiscard]] inline __m128i blend_opaque_epi16(const __m128i under, const __m128i over) noexcept
+  {
+    const auto max = _mm_set1_epi16(255);// NOLINT magic number
+    const auto half = _mm_set1_epi16(128);// NOLINT magic number
+
+    auto alpha = _mm_shufflelo_epi16(over, _MM_SHUFFLE(3, 3, 3, 3));// NOLINT
+    alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));// NOLINT
+
+    const auto weighted =
+      _mm_add_epi16(_mm_mullo_epi16(over, alpha), _mm_mullo_epi16(under, _mm_sub_epi16(max, alpha)));
+    const auto rounded = _mm_add_epi16(weighted, half);
+    return _mm_srli_epi16(_mm_add_epi16(rounded, _mm_srli_epi16(rounded, 8)), 8);// NOLINT magic number
+  }
+
+  // 4 pixels
+  [[nodiscard]] inline bool blend_opaque_sse2(Color *under, const Color *over) noexcept
+  {
+    const auto alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000));// NOLINT magic number
+    // NOLINTNEXTLINE reinterpret_cast is required for intrinsics
+    const auto destination = _mm_loadu_si128(reinterpret_cast<const __m128i *>(under));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(destination, alpha_mask), alpha_mask)) != 0xFFFF) {
+      return false;
+    }
+
+    // NOLINTNEXTLINE reinterpret_cast is required for intrinsics
+    const auto source = _mm_loadu_si128(reinterpret_cast<const __m128i *>(over));
+    const auto zero = _mm_setzero_si128();
+
+    const auto low = blend_opaque_epi16(_mm_unpacklo_epi8(destination, zero), _mm_unpacklo_epi8(source, zero));
+    const auto high = blend_opaque_epi16(_mm_unpackhi_epi8(destination, zero), _mm_unpackhi_epi8(source, zero));
+
+    // NOLINTNEXTLINE reinterpret_cast is required for intrinsics
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(under), _mm_or_si128(_mm_packus_epi16(low, high), alpha_mask));
+    return true;
+  }
+#endif
+
+#if defined(TRAVELS_BLEND_AVX2)
+  // 8 pixels
+  [[nodiscard]] inline bool blend_opaque_avx2(Color *under, const Color *over) noexcept
+  {
+    const auto alpha_mask = _mm256_set1_epi32(static_cast<int>(0xFF000000));// NOLINT magic number
+    // NOLINTNEXTLINE reinterpret_cast is required for intrinsics
+    const auto destination = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(under));
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(destination, alpha_mask), alpha_mask)) != -1) {
+      return false;
+    }
+
+    // NOLINTNEXTLINE reinterpret_cast is required for intrinsics
+    const auto source = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(over));
+    const auto zero = _mm256_setzero_si256();
+    const auto max = _mm256_set1_epi16(255);// NOLINT magic number
+    const auto half = _mm256_set1_epi16(128);// NOLINT magic number
+
+    // unpack / pack both work within 128 bit lanes, so pixel order is preserved
+    const auto blend_half = [&](const __m256i under_epi16, const __m256i over_epi16) {
+      auto alpha = _mm256_shufflelo_epi16(over_epi16, _MM_SHUFFLE(3, 3, 3, 3));// NOLINT
+      alpha = _mm256_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));// NOLINT
+
+      const auto weighted = _mm256_add_epi16(
+        _mm256_mullo_epi16(over_epi16, alpha), _mm256_mullo_epi16(under_epi16, _mm256_sub_epi16(max, alpha)));
+      const auto rounded = _mm256_add_epi16(weighted, half);
+      return _mm256_srli_epi16(_mm256_add_epi16(rounded, _mm256_srli_epi16(rounded, 8)), 8);// NOLINT magic number
+    };
+
+    const auto low = blend_half(_mm256_unpacklo_epi8(destination, zero), _mm256_unpacklo_epi8(source, zero));
+    const auto high = blend_half(_mm256_unpackhi_epi8(destination, zero), _mm256_unpackhi_epi8(source, zero));
+
+    // NOLINTNEXTLINE reinterpret_cast is required for intrinsics
+    _mm256_storeu_si256(
+      reinterpret_cast<__m256i *>(under), _mm256_or_si256(_mm256_packus_epi16(low, high), alpha_mask));
+    return true;
+  }
+#endif
+
+  inline void blend_span_scalar(Color *under, const Color *over, const std::size_t count) noexcept
+  {
+    for (std::size_t index = 0; index < count; ++index) {
+      under[index] = blend(under[index], over[index]);// NOLINT pointer arithmetic
+    }
+  }
+}// namespace detail
+
+
+// Draws each pixel of `over` on top of the matching pixel of `under`, same as `under[i] += over[i]`.
+// Uses AVX2 or SSE2 when they are enabled for the build, with results identical to `blend`.
+inline void blend_span(const std::span<Color> under, const std::span<const Color> over) noexcept
+{
+  assert(under.size() == over.size());
+
+  auto *destination = under.data();
+  const auto *source = over.data();
+  std::size_t remaining = under.size();
+
+#if defined(TRAVELS_BLEND_AVX2)
+  constexpr std::size_t avx2_width = 8;
+  for (; remaining >= avx2_width; remaining -= avx2_width) {
+    if (!detail::blend_opaque_avx2(destination, source)) { detail::blend_span_scalar(destination, source, avx2_width); }
+    destination += avx2_width;// NOLINT pointer arithmetic
+    source += avx2_width;// NOLINT pointer arithmetic
+  }
+#endif
+
+#if defined(TRAVELS_BLEND_SSE2) || defined(TRAVELS_BLEND_AVX2)
+  constexpr std::size_t sse2_width = 4;
+  for (; remaining >= sse2_width; remaining -= sse2_width) {
+    if (!detail::blend_opaque_sse2(destination, source)) { detail::blend_span_scalar(destination, source, sse2_width); }
+    destination += sse2_width;// NOLINT pointer arithmetic
+    source += sse2_width;// NOLINT pointer arithmetic
+  }
+#endif
+
+  detail::blend_span_scalar(destination, source, remaining);
+}
+
+// Blends every row of `over` onto the same row of `under`. Both must be the same size.
+inline void blend_span(auto &&under, const auto &over) noexcept
+  requires requires { under.rows(); over.rows(); }
+{
+  assert(under.size().width == over.size().width && under.size().height == over.size().height);
+  for (std::size_t cur_y = 0; cur_y < under.size().height; ++cur_y) { blend_span(under.row(cur_y), over.row(cur_y)); }
+}
+
+// Shrinks `source` into `destination`, each pixel the average of the block of source pixels it
+// covers. Colors are weighted by their alpha, so transparent pixels don't darken the edges of
+// what is next to them. Any remainder of the source at the right and bottom edges is ignored.
+inline void box_filter(const auto &source, auto &&destination) noexcept
+  requires requires { source.rows(); destination.rows(); }
+{
+  const auto block_width = source.size().width / destination.size().width;
+  const auto block_height = source.size().height / destination.size().height;
+  const auto block_pixels = static_cast<std::uint32_t>(block_width * block_height);
+  assert(block_pixels > 0);
+
+  for (std::size_t cur_y = 0; cur_y < destination.size().height; ++cur_y) {
+    auto destination_row = destination.row(cur_y);
+
+    for (std::size_t cur_x = 0; cur_x < destination.size().width; ++cur_x) {
+      std::uint32_t red = 0;
+      std::uint32_t green = 0;
+      std::uint32_t blue = 0;
+      std::uint32_t alpha = 0;
+
+      for (std::size_t block_y = 0; block_y < block_height; ++block_y) {
+        const auto source_row = source.row(cur_y * block_height + block_y);
+        for (std::size_t block_x = 0; block_x < block_width; ++block_x) {
+          const auto color = source_row[cur_x * block_width + block_x];
+          red += std::uint32_t{ color.R } * color.A;
+          green += std::uint32_t{ color.G } * color.A;
+          blue += std::uint32_t{ color.B } * color.A;
+          alpha += color.A;
+        }
+      }
+
+      if (alpha == 0) {
+        destination_row[cur_x] = Color{};
+        continue;
+      }
+
+      destination_row[cur_x] = Color{ static_cast<std::uint8_t>((red + alpha / 2) / alpha),
+        static_cast<std::uint8_t>((green + alpha / 2) / alpha),
+        static_cast<std::uint8_t>((blue + alpha / 2) / alpha),
+        static_cast<std::uint8_t>((alpha + block_pixels / 2) / block_pixels) };
+    }
+  }
+}
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_COLOR_BLEND_HPP
@@ -0,0 +1,456 @@
+#include "compiled_map.hpp"
+#include "asset_registry.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#ifdef _MSC_VER
+#pragma warning(disable : 4189)
+#endif
+#include <spdlog/spdlog.h>
+#ifdef _MSC_VER
+#pragma warning(default : 4189)
+#endif
+
+namespace lefticus::travels {
+
+namespace {
+  static_assert(sizeof(Color) == 4 && std::is_trivially_copyable_v<Color>,
+    "compiled maps store pixels as raw RGBA bytes");
+
+  constexpr std::array<char, 8> magic{ 'T', 'R', 'V', 'L', 'M', 'A', 'P', '\0' };
+
+  constexpr std::uint32_t background_flag = 1;
+  constexpr std::uint32_t foreground_flag = 2;
+
+  // the index of each type in Tile_Properties::Value
+  enum struct Property_Type : std::uint32_t { Bool, Int, Float, String };
+
+  constexpr std::size_t padding(const std::size_t size) noexcept { return (4 - size % 4) % 4; }
+
+  class Writer
+  {
+  public:
+    explicit Writer(std::ostream &output) : output_{ output } {}
+
+    void u32(const std::size_t value)
+    {
+      if (value > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error(fmt::format("Value {} is too large for a compiled map", value));
+      }
+
+      std::array<char, 4> bytes{};
+      for (std::size_t byte = 0; byte < bytes.size(); ++byte) {
+        bytes[byte] = static_cast<char>((value >> (byte * 8)) & 0xFFU);// NOLINT magic numbers
+      }
+      output_.write(bytes.data(), bytes.size());
+    }
+
+    void u64(const std::uint64_t value)
+    {
+      u32(value & 0xFFFFFFFFU);// NOLINT magic number
+      u32(value >> 32U);// NOLINT magic number
+    }
+
+    void bytes(const void *data, const std::size_t size)
+    {
+      output_.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    }
+
+    void string(const std::string_view value)
+    {
+      u32(value.size());
+      bytes(value.data(), value.size());
+      constexpr std::array<char, 4> zeros{};
+      bytes(zeros.data(), padding(value.size()));
+    }
+
+  private:
+    std::ostream &output_;
+  };
+
+  class Reader
+  {
+  public:
+    explicit Reader(const std::span<const std::byte> data) : data_{ data } {}
+
+    [[nodiscard]] std::span<const std::byte> bytes(const std::size_t size)
+    {
+      if (size > data_.size() - offset_) { throw std::runtime_error("Compiled map is truncated"); }
+      const auto result = data_.subspan(offset_, size);
+      offset_ += size;
+      return result;
+    }
+
+    [[nodiscard]] std::uint32_t u32()
+    {
+      std::uint32_t value = 0;
+      const auto data = bytes(sizeof(value));
+      for (std::size_t byte = 0; byte < data.size(); ++byte) {
+        value |= std::to_integer<std::uint32_t>(data[byte]) << (byte * 8);// NOLINT magic number
+      }
+      return value;
+    }
+
+    [[nodiscard]] std::size_t size() { return u32(); }
+
+    // a count of things that each take at least `min_bytes` of what is left of the file
+    [[nodiscard]] std::size_t count(const std::size_t min_bytes)
+    {
+      const auto value = size();
+      if (value > remaining() / min_bytes) { throw std::runtime_error("Compiled map is truncated"); }
+      return value;
+    }
+
+    [[nodiscard]] std::size_t remaining() const noexcept { return data_.size() - offset_; }
+
+    [[nodiscard]] std::uint64_t u64()
+    {
+      const std::uint64_t low = u32();
+      const std::uint64_t high = u32();
+      return low | (high << 32U);// NOLINT magic number
+    }
+
+    [[nodiscard]] std::string string()
+    {
+      const auto length = size();
+      const auto data = bytes(length);
+      std::string result(length, '\0');
+      if (length != 0) { std::memcpy(result.data(), data.data(), length); }
+      [[maybe_unused]] const auto padding_bytes = bytes(padding(length));
+      return result;
+    }
+
+  private:
+    std::span<const std::byte> data_;
+    std::size_t offset_ = 0;
+  };
+
+  void write_properties(Writer &writer, const Tile_Properties &properties)
+  {
+    writer.u32(properties.tile_count());
+
+    std::size_t column_count = 0;
+    properties.for_each_column([&](std::string_view, const auto &) { ++column_count; });
+    writer.u32(column_count);
+
+    properties.for_each_column([&](const std::string_view name, const Tile_Properties::Any_Column &any_column) {
+      writer.string(name);
+      writer.u32(any_column.index());
+
+      std::visit(
+        [&](const auto &values) {
+          writer.u32(static_cast<std::size_t>(
+            std::count_if(values.begin(), values.end(), [](const auto &value) { return value.has_value(); })));
+
+          for (std::size_t tile = 0; tile < values.size(); ++tile) {
+            if (!values[tile]) { continue; }
+            writer.u32(tile);
+
+            using Type = typename std::decay_t<decltype(values)>::value_type::value_type;
+            if constexpr (std::is_same_v<Type, bool>) {
+              writer.u32(*values[tile] ? 1 : 0);
+            } else if constexpr (std::is_same_v<Type, std::int64_t>) {
+              writer.u64(static_cast<std::uint64_t>(*values[tile]));
+            } else if constexpr (std::is_same_v<Type, double>) {
+              writer.u64(std::bit_cast<std::uint64_t>(*values[tile]));
+            } else {
+              writer.string(*values[tile]);
+            }
+          }
+        },
+        any_column);
+    });
+  }
+
+  Tile_Properties read_properties(Reader &reader, const std::size_t max_tiles)
+  {
+    const auto tile_count = reader.size();
+    if (tile_count > max_tiles) {
+      throw std::runtime_error(fmt::format("Compiled map has {} tiles in an image of {} tiles", tile_count, max_tiles));
+    }
+    Tile_Properties properties{ tile_count };
+
+    // a name and a type and a value count at the least
+    const auto column_count = reader.count(3 * sizeof(std::uint32_t));
+    for (std::size_t column = 0; column < column_count; ++column) {
+      const auto name = reader.string();
+      const auto type = static_cast<Property_Type>(reader.u32());
+
+      // a tile and a value at the least
+      const auto value_count = reader.count(2 * sizeof(std::uint32_t));
+      for (std::size_t value = 0; value < value_count; ++value) {
+        const auto tile = reader.size();
+        switch (type) {
+        case Property_Type::Bool:
+          properties.set(tile, name, reader.u32() != 0);
+          break;
+        case Property_Type::Int:
+          properties.set(tile, name, static_cast<std::int64_t>(reader.u64()));
+          break;
+        case Property_Type::Float:
+          properties.set(tile, name, std::bit_cast<double>(reader.u64()));
+          break;
+        case Property_Type::String:
+          properties.set(tile, name, reader.string());
+          break;
+        default:
+          throw std::runtime_error(fmt::format("Unknown type for tile property '{}'", name));
+        }
+      }
+    }
+
+    return properties;
+  }
+}// namespace
+
+
+void write_compiled_map(const Tiled_Map &tiled_map, std::ostream &output)
+{
+  Writer writer{ output };
+
+  writer.bytes(magic.data(), magic.size());
+  writer.u32(compiled_map::version);
+  writer.u32(tiled_map.tile_size.width);
+  writer.u32(tiled_map.tile_size.height);
+  writer.u32(tiled_map.map_size.width);
+  writer.u32(tiled_map.map_size.height);
+  writer.u32(tiled_map.tile_sets.size());
+  writer.u32(tiled_map.layers.size());
+
+  for (const auto &tile_set : tiled_map.tile_sets) {
+    for (const auto *source : { &tile_set.tsj, &tile_set.image_file }) {
+      writer.string(source->path.generic_string());
+      writer.u64(static_cast<std::uint64_t>(source->modified.time_since_epoch().count()));
+    }
+  }
+
+  for (const auto &tile_set : tiled_map.tile_sets) {
+    writer.u32(tile_set.start_id);
+    writer.u32(tile_set.image->size().width);
+    writer.u32(tile_set.image->size().height);
+    write_properties(writer, *tile_set.properties);
+
+    const auto pixels = tile_set.image->data();
+    writer.bytes(pixels.data(), pixels.size_bytes());
+  }
+
+  for (const auto &layer : tiled_map.layers) {
+    writer.u32((layer.background ? background_flag : 0) | (layer.foreground ? foreground_flag : 0));
+  }
+
+  writer.u32(tiled_map.stacks.size());
+  for (const auto &stack : tiled_map.stacks) {
+    for (std::size_t layer = 0; layer < tiled_map.layers.size(); ++layer) {
+      writer.u32(layer < stack.size() ? stack[layer] : 0);
+    }
+  }
+
+  // the runs are already in their compiled form
+  const auto &cells = tiled_map.cells;
+  if (cells.size() != tiled_map.map_size) { throw std::runtime_error("Map cells don't match the map size"); }
+  writer.u32(cells.runs().size() / (2 * sizeof(std::uint32_t)));
+  writer.bytes(cells.starts().data(), cells.starts().size());
+  writer.bytes(cells.runs().data(), cells.runs().size());
+
+  if (!output.good()) { throw std::runtime_error("Unable to write compiled map"); }
+}
+
+
+namespace {
+  struct Header
+  {
+    std::size_t tile_set_count = 0;
+    std::size_t layer_count = 0;
+    std::vector<Tiled_Map::Source_File> sources;// the .tsj and the image of each tile set
+  };
+
+  // everything before the tile sets, the sizes go into `tiled_map`
+  Header read_header(Reader &reader, Tiled_Map &tiled_map)
+  {
+    if (std::memcmp(reader.bytes(magic.size()).data(), magic.data(), magic.size()) != 0) {
+      throw std::runtime_error("Not a compiled map");
+    }
+
+    if (const auto version = reader.u32(); version != compiled_map::version) {
+      throw std::runtime_error(
+        fmt::format("Compiled map is version {}, expected version {}", version, compiled_map::version));
+    }
+
+    tiled_map.tile_size.width = reader.size();
+    tiled_map.tile_size.height = reader.size();
+    tiled_map.map_size.width = reader.size();
+    tiled_map.map_size.height = reader.size();
+    if (tiled_map.tile_size.width == 0 || tiled_map.tile_size.height == 0) {
+      throw std::runtime_error("Compiled map has an empty tile size");
+    }
+
+    Header header;
+    // two sources, a start gid, an image size, a tile count and a property count at the least
+    header.tile_set_count = reader.count(11 * sizeof(std::uint32_t));// NOLINT magic number
+    header.layer_count = reader.count(sizeof(std::uint32_t));
+
+    for (std::size_t source = 0; source < header.tile_set_count * 2; ++source) {
+      auto path = std::filesystem::path{ reader.string() };
+      const auto modified = static_cast<std::filesystem::file_time_type::rep>(reader.u64());
+      header.sources.push_back(Tiled_Map::Source_File{ .path = std::move(path),
+        .modified = std::filesystem::file_time_type{ std::filesystem::file_time_type::duration{ modified } } });
+    }
+
+    return header;
+  }
+
+  // The cells stay in `data`, which `owner` keeps alive
+  Tiled_Map read_contents(const std::span<const std::byte> data, std::shared_ptr<const void> owner)
+  {
+    Reader reader{ data };
+
+    Tiled_Map tiled_map;
+    const auto header = read_header(reader, tiled_map);
+    const auto layer_count = header.layer_count;
+
+    for (std::size_t index = 0; index < header.tile_set_count; ++index) {
+      auto &tile_set = tiled_map.tile_sets.emplace_back();
+      tile_set.tsj = header.sources[index * 2];
+      tile_set.image_file = header.sources[index * 2 + 1];
+      tile_set.start_id = reader.size();
+
+      const auto width = reader.size();
+      const auto height = reader.size();
+      // nothing is allocated for the image or the properties before the file is known to hold the pixels
+      if (height != 0 && width > reader.remaining() / sizeof(Color) / height) {
+        throw std::runtime_error("Compiled map is truncated");
+      }
+
+      const auto max_tiles = (width / tiled_map.tile_size.width) * (height / tiled_map.tile_size.height);
+      tile_set.properties = std::make_shared<const Tile_Properties>(read_properties(reader, max_tiles));
+
+      Vector2D<Color> image{ Size{ width, height } };
+      const auto pixels = image.data();
+      const auto image_data = reader.bytes(pixels.size_bytes());
+      if (!pixels.empty()) { std::memcpy(pixels.data(), image_data.data(), image_data.size()); }
+
+      // maps compiled from the same tile set all carry their own copy of the image
+      tile_set.image = Asset_Registry::shared().image(std::move(image));
+    }
+
+    for (std::size_t index = 0; index < layer_count; ++index) {
+      auto &layer = tiled_map.layers.emplace_back();
+      const auto flags = reader.u32();
+      layer.background = (flags & background_flag) != 0;
+      layer.foreground = (flags & foreground_flag) != 0;
+    }
+
+    // a gid for each layer, a stack without layers is still counted as taking a field
+    const auto stack_count = reader.count(std::max(layer_count, std::size_t{ 1 }) * sizeof(std::uint32_t));
+    tiled_map.stacks.resize(stack_count);
+    for (auto &stack : tiled_map.stacks) {
+      stack.resize(layer_count);
+      for (auto &gid : stack) { gid = reader.u32(); }
+    }
+
+    const auto run_count = reader.count(2 * sizeof(std::uint32_t));
+    const auto chunks_wide = (tiled_map.map_size.width + Map_Chunks::chunk_size - 1) / Map_Chunks::chunk_size;
+    const auto chunks_high = (tiled_map.map_size.height + Map_Chunks::chunk_size - 1) / Map_Chunks::chunk_size;
+    const auto starts = reader.bytes((chunks_wide * chunks_high + 1) * sizeof(std::uint64_t));
+    const auto runs = reader.bytes(run_count * 2 * sizeof(std::uint32_t));
+    tiled_map.cells = Chunk_Runs{ tiled_map.map_size, starts, runs, std::move(owner) };
+
+    return tiled_map;
+  }
+}// namespace
+
+
+Tiled_Map read_compiled_map(const std::span<const std::byte> data)
+{
+  auto tiled_map = read_contents(data, nullptr);
+  // `data` is only borrowed
+  tiled_map.cells = tiled_map.cells.owned();
+  return tiled_map;
+}
+
+std::vector<Tiled_Map::Source_File> read_compiled_map_sources(const std::span<const std::byte> data)
+{
+  Reader reader{ data };
+  Tiled_Map sizes_only;
+  return read_header(reader, sizes_only).sources;
+}
+
+
+Game_Map load_compiled_map(const std::filesystem::path &compiled_map)
+{
+  spdlog::debug("Loading compiled map: {}", compiled_map.string());
+  // each chunk's runs are read straight out of the mapping as it is loaded, the file stays mapped for that
+  auto file = std::make_shared<const Mapped_File>(compiled_map);
+  const auto data = file->data();
+  return make_game_map(read_contents(data, std::move(file)));
+}
+
+
+std::filesystem::path find_map(const std::filesystem::path &map_json,
+  const std::vector<std::filesystem::path> &search_paths)
+{
+  for (const auto &search_path : search_paths) {
+    auto path = search_path / map_json;
+    if (std::error_code error; std::filesystem::is_regular_file(path, error)) { return path; }
+  }
+
+  throw std::runtime_error(fmt::format("Unable to find map in any search path: {}", map_json.string()));
+}
+
+std::optional<std::filesystem::path> up_to_date_compiled_map(const std::filesystem::path &map_json)
+{
+  auto compiled_path = map_json;
+  compiled_path.replace_extension(compiled_map::extension);
+
+  std::error_code error;
+  const auto compiled_time = std::filesystem::last_write_time(compiled_path, error);
+  if (error || compiled_time < std::filesystem::last_write_time(map_json, error) || error) { return std::nullopt; }
+
+  // the tile sets and their images are compiled in too, they have to be the same files
+  std::vector<Tiled_Map::Source_File> sources;
+  try {
+    const Mapped_File file{ compiled_path };
+    sources = read_compiled_map_sources(file.data());
+  } catch (const std::exception &) {
+    // loading it reports what is wrong with it
+    return compiled_path;
+  }
+
+  for (const auto &source : sources) {
+    const auto path = map_json.parent_path() / source.path;
+    if (std::filesystem::last_write_time(path, error) != source.modified || error) {
+      spdlog::info("'{}' changed since '{}' was compiled, loading '{}' instead",
+        path.string(),
+        compiled_path.string(),
+        map_json.string());
+      return std::nullopt;
+    }
+  }
+
+  return compiled_path;
+}
+
+Game_Map load_map(const std::filesystem::path &map_json, const std::vector<std::filesystem::path> &search_paths)
+{
+  const auto path = find_map(map_json, search_paths);
+
+  if (const auto compiled_path = up_to_date_compiled_map(path)) {
+    try {
+      return load_compiled_map(*compiled_path);
+    } catch (const std::exception &e) {
+      spdlog::warn(
+        "Unable to load compiled map '{}', loading '{}' instead: {}", compiled_path->string(), path.string(), e.what());
+    }
+  }
+
+  return load_tiled_map(path);
+}
+
+}// namespace lefticus::travels
@@ -0,0 +1,69 @@
+#ifndef AWESOME_GAME_COMPILED_MAP_HPP
+#define AWESOME_GAME_COMPILED_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <vector>
+
+#include "game_components.hpp"
+
+namespace lefticus::travels {
+
+// A Tiled map and its tilesets compiled into one binary file by `travels-mapc`, so that
+// loading it needs no JSON parsing or PNG decoding.
+//
+// Layout, all fields are little endian std::uint32_t, so every section stays 4 byte aligned:
+//
+//   header:     magic "TRVLMAP\0", version, tile width, tile height, map width, map height,
+//               tile set count, layer count
+//   sources:    tile set count * { .tsj, image }, the files it was compiled from, each a path
+//               relative to the map's directory and its modification time as a signed int
+//   tile sets:  start gid, image width, image height, tile count, property count,
+//               property count * property,
+//               image width * image height RGBA pixels
+//   properties: name, type (0 bool, 1 int, 2 float, 3 string), value count,
+//               value count * { tile id, value }
+//   layers:     layer count * flags (1 = background, 2 = foreground)
+//   stacks:     stack count, stack count * layer count * gid
+//   cells:      run count, the runs of each chunk of the map (see Chunk_Runs)
+//
+// Strings are a byte count followed by the bytes, padded to a multiple of 4. bool is one field,
+// int and float are two, low half first.
+namespace compiled_map {
+  inline constexpr std::uint32_t version = 4;
+  inline constexpr std::string_view extension = ".tmapc";
+}// namespace compiled_map
+
+void write_compiled_map(const Tiled_Map &tiled_map, std::ostream &output);
+
+// throws std::runtime_error if `data` is not a complete compiled map of the current version
+Tiled_Map read_compiled_map(std::span<const std::byte> data);
+
+// the tile set files and images `data` was compiled from, without reading any further
+// throws std::runtime_error if `data` doesn't start with a compiled map of the current version
+std::vector<Tiled_Map::Source_File> read_compiled_map_sources(std::span<const std::byte> data);
+
+// Memory maps the file and builds the map from it. The file stays mapped, the cells are only
+// read out of it as the map's chunks are loaded.
+Game_Map load_compiled_map(const std::filesystem::path &compiled_map);
+
+// the first search path that has `map_json` in it
+// throws std::runtime_error if there is none
+std::filesystem::path find_map(const std::filesystem::path &map_json,
+  const std::vector<std::filesystem::path> &search_paths);
+
+// the compiled map next to `map_json` (same name, `compiled_map::extension`), if there is one
+// that is at least as new as the JSON, and none of the tile sets or images it was compiled from
+// has changed since
+std::optional<std::filesystem::path> up_to_date_compiled_map(const std::filesystem::path &map_json);
+
+// Loads `map_json` from the first search path that has it, preferring its up to date compiled map.
+Game_Map load_map(const std::filesystem::path &map_json, const std::vector<std::filesystem::path> &search_paths);
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_COMPILED_MAP_HPP
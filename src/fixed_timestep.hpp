@@ -0,0 +1,84 @@
+#ifndef AWESOME_GAME_FIXED_TIMESTEP_HPP
+#define AWESOME_GAME_FIXED_TIMESTEP_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+#include "frame_timings.hpp"
+
+namespace lefticus::travels {
+
+// Advances a simulation in fixed size ticks, no matter how often `update` gets called.
+//
+// Every tick that is due by `now` is run, in order, so game logic driven by the simulated time
+// does the same thing at any render rate. If more than `max_ticks_per_update` are due
+// the rest are dropped: the simulation slows down instead of falling further and further behind.
+class Fixed_Timestep
+{
+public:
+  using clock = std::chrono::steady_clock;
+
+  // the tick and render rates accepted from the command line and from recordings, per second,
+  // so that a tick is never rounded down to nothing
+  static constexpr double min_rate = 1.0;
+  static constexpr double max_rate = 10000.0;// NOLINT magic number
+
+  // throws std::invalid_argument if `tick_length` isn't positive
+  Fixed_Timestep(const clock::duration tick_length,
+    const std::size_t max_ticks_per_update,
+    const clock::time_point start,
+    Timing_Histogram &jitter)
+    : tick_length_{ tick_length }, max_ticks_per_update_{ max_ticks_per_update }, next_tick_{ start + tick_length },
+      jitter_{ jitter }
+  {
+    if (tick_length_ <= clock::duration::zero()) { throw std::invalid_argument("Fixed_Timestep needs a tick length"); }
+  }
+
+  // runs `tick()` for each tick due by `now`, returns how many were run
+  template<typename Function> std::size_t update(const clock::time_point now, Function &&tick)
+  {
+    std::size_t ticks_run = 0;
+
+    while (next_tick_ <= now && ticks_run < max_ticks_per_update_) {
+      // how late this tick is, compared to when it should have happened
+      jitter_.add(now - next_tick_);
+
+      ++ticks_;
+      ++ticks_run;
+      next_tick_ += tick_length_;
+      tick();
+    }
+
+    if (next_tick_ <= now) {
+      const auto behind = (now - next_tick_) / tick_length_ + 1;
+      dropped_ticks_ += static_cast<std::uint64_t>(behind);
+      next_tick_ += tick_length_ * behind;
+    }
+
+    return ticks_run;
+  }
+
+  [[nodiscard]] std::uint64_t ticks() const noexcept { return ticks_; }
+  [[nodiscard]] std::uint64_t dropped_ticks() const noexcept { return dropped_ticks_; }
+
+  // the total time simulated so far, `ticks() * tick_length`
+  [[nodiscard]] clock::duration simulated_time() const noexcept
+  {
+    return tick_length_ * static_cast<clock::rep>(ticks_);
+  }
+
+  [[nodiscard]] clock::duration tick_length() const noexcept { return tick_length_; }
+
+private:
+  clock::duration tick_length_;
+  std::size_t max_ticks_per_update_;
+  clock::time_point next_tick_;
+  std::uint64_t ticks_ = 0;
+  std::uint64_t dropped_ticks_ = 0;
+  Timing_Histogram &jitter_;
+};
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_FIXED_TIMESTEP_HPP
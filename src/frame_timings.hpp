@@ -0,0 +1,126 @@
+#ifndef AWESOME_GAME_FRAME_TIMINGS_HPP
+#define AWESOME_GAME_FRAME_TIMINGS_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fmt/format.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lefticus::travels {
+
+// Keeps the most recent `Capacity` samples of how long something took
+template<std::size_t Capacity = 512> class Basic_Timing_Histogram
+{
+public:
+  using duration = std::chrono::steady_clock::duration;
+
+  struct Summary
+  {
+    duration p50{};
+    duration p95{};
+    duration p99{};
+    duration max{};
+    std::size_t samples = 0;
+  };
+
+  void add(const duration sample) noexcept
+  {
+    samples_[next_] = sample;
+    next_ = (next_ + 1) % Capacity;
+    count_ = std::min(count_ + 1, Capacity);
+    ++total_;
+  }
+
+  // number of samples ever added, not just the ones still held
+  [[nodiscard]] std::size_t total() const noexcept { return total_; }
+
+  [[nodiscard]] Summary summary() const
+  {
+    if (count_ == 0) { return Summary{}; }
+
+    std::vector<duration> sorted(samples_.begin(), std::next(samples_.begin(), static_cast<std::ptrdiff_t>(count_)));
+    std::sort(sorted.begin(), sorted.end());
+
+    const auto percentile = [&](const std::size_t percent) { return sorted[(sorted.size() - 1) * percent / 100]; };
+
+    return Summary{ percentile(50), percentile(95), percentile(99), sorted.back(), count_ };// NOLINT magic numbers
+  }
+
+private:
+  std::array<duration, Capacity> samples_{};
+  std::size_t next_ = 0;
+  std::size_t count_ = 0;
+  std::size_t total_ = 0;
+};
+
+using Timing_Histogram = Basic_Timing_Histogram<>;
+
+// Adds the time between construction and destruction to a histogram
+class Scoped_Timer
+{
+public:
+  explicit Scoped_Timer(Timing_Histogram &histogram) noexcept
+    : histogram_{ histogram }, start_{ std::chrono::steady_clock::now() }
+  {}
+
+  Scoped_Timer(const Scoped_Timer &) = delete;
+  Scoped_Timer &operator=(const Scoped_Timer &) = delete;
+  Scoped_Timer(Scoped_Timer &&) = delete;
+  Scoped_Timer &operator=(Scoped_Timer &&) = delete;
+
+  ~Scoped_Timer() { histogram_.add(std::chrono::steady_clock::now() - start_); }
+
+private:
+  Timing_Histogram &histogram_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// The stages of producing one frame in `play_game`
+struct Frame_Timings
+{
+  Timing_Histogram frame;// time from the start of one frame to the start of the next
+  Timing_Histogram events;// processing input and game actions
+  Timing_Histogram draw;// drawing the map into the viewport bitmap
+  Timing_Histogram layout;// building the FTXUI element tree
+  Timing_Histogram render;// FTXUI rendering the element tree into its screen
+  Timing_Histogram tick_jitter;// how late each simulation tick ran, compared to its schedule
+
+  template<typename Function> void for_each_stage(Function &&function) const
+  {
+    function(std::string_view{ "frame" }, frame);
+    function(std::string_view{ "events" }, events);
+    function(std::string_view{ "draw" }, draw);
+    function(std::string_view{ "layout" }, layout);
+    function(std::string_view{ "render" }, render);
+    function(std::string_view{ "jitter" }, tick_jitter);
+  }
+
+  // one line per stage, times in milliseconds
+  [[nodiscard]] std::vector<std::string> summary_lines() const
+  {
+    std::vector<std::string> lines;
+    lines.push_back(fmt::format("{:<7}{:>7}{:>7}{:>7}{:>7}", "ms", "p50", "p95", "p99", "max"));
+
+    for_each_stage([&](const std::string_view name, const Timing_Histogram &histogram) {
+      const auto summary = histogram.summary();
+      const auto milliseconds = [](const Timing_Histogram::duration value) {
+        return std::chrono::duration<double, std::milli>(value).count();
+      };
+      lines.push_back(fmt::format("{:<7}{:>7.2f}{:>7.2f}{:>7.2f}{:>7.2f}",
+        name,
+        milliseconds(summary.p50),
+        milliseconds(summary.p95),
+        milliseconds(summary.p99),
+        milliseconds(summary.max)));
+    });
+
+    return lines;
+  }
+};
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_FRAME_TIMINGS_HPP
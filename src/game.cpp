@@ -1,14 +1,14 @@
 #include "game.hpp"
+#include "asset_loader.hpp"
 #include "bitmap.hpp"
+#include "color_blend.hpp"
 #include "game_components.hpp"
 #include <set>
 
 namespace lefticus::travels {
 
-Game_Map make_map(const std::vector<std::filesystem::path> &search_directories)
+Game_Map make_map(Game_Map map)
 {
-  auto map = load_tiled_map("travels/tiled/tiles/Map.tmj", search_directories);
-
   map.locations.at(Point{ 4, 5 }).can_enter// NOLINT magic numbers
     = [](const Game &, Point, Direction) { return true; };
   map.locations.at(Point{ 4, 5 }).enter_action// NOLINT magic numbers
@@ -26,10 +26,8 @@ Game_Map make_map(const std::vector<std::filesystem::path> &search_directories)
   return map;
 }
 
-Game_Map make_store(const std::vector<std::filesystem::path> &search_directories)
+Game_Map make_store(Game_Map map)
 {
-  auto map = load_tiled_map("travels/tiled/tiles/Store.tmj", search_directories);
-
   map.locations.at(Point{ 7, 6 }).enter_action// NOLINT magic numbers
     = [](Game &game, Point, Direction) {
         game.current_map = "main";
@@ -54,9 +52,15 @@ Game_Map make_store(const std::vector<std::filesystem::path> &search_directories
 
 Game make_game(const std::vector<std::filesystem::path> &search_directories)
 {
+  // every map and tile set is loaded at once, the pool is done when it goes out of scope
+  Thread_Pool pool;
+  Asset_Loader loader{ pool };
+  auto main_map = loader.load_map("travels/tiled/tiles/Map.tmj", search_directories);
+  auto store_map = loader.load_map("travels/tiled/tiles/Store.tmj", search_directories);
+
   Game retval{};
-  retval.maps.emplace("main", make_map(search_directories));
-  retval.maps.emplace("store", make_store(search_directories));
+  retval.maps.emplace("main", make_map(main_map.get()));
+  retval.maps.emplace("store", make_store(store_map.get()));
   retval.current_map = "main";
   retval.tile_size = Size{ 8, 8 };// NOLINT Magic Number
 
@@ -69,12 +73,7 @@ Game make_game(const std::vector<std::filesystem::path> &search_directories)
   player.map_location = { 14, 17 };// NOLINT Magic Number
   player.draw =
     [](Vector2D_Span<Color> &pixels, [[maybe_unused]] const Game &game, [[maybe_unused]] Point map_location) {
-      const auto &tile = game.maps.at("main").tile_sets.front().at(98);// NOLINT magic number
-      for (std::size_t cur_x = 0; cur_x < pixels.size().width; ++cur_x) {
-        for (std::size_t cur_y = 0; cur_y < pixels.size().height; ++cur_y) {
-          pixels.at(Point{ cur_x, cur_y }) += tile.at(Point{ cur_x, cur_y });
-        }
-      }
+      blend_span(pixels, game.maps.at("main").tile_sets.front().at(98));// NOLINT magic number
     };
 
 
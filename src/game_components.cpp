@@ -1,7 +1,10 @@
 #include "game_components.hpp"
+#include "asset_registry.hpp"
+#include "color_blend.hpp"
 #include "tile_set.hpp"
 #include <filesystem>
 #include <fstream>
+#include <utility>
 #include <nlohmann/json.hpp>
 
 #ifdef _MSC_VER
@@ -31,142 +34,396 @@ Game_Map load_tiled_map(const std::filesystem::path &map_json, const std::vector
 }
 
 
-Game_Map load_tiled_map(const std::filesystem::path &map_json)// NOLINT cognitive complexity
-{
-  const auto parent_path = map_json.parent_path();
-
-  const auto load_json = [](const std::filesystem::path &json_file) {
+namespace {
+  nlohmann::json load_json(const std::filesystem::path &json_file)
+  {
     spdlog::debug("Loading JSON: {}", json_file.string());
     std::ifstream input(json_file);
     if (!input.good()) { spdlog::error("Unable to open JSON file"); }
     nlohmann::json json;
     input >> json;
     return json;
+  }
+
+  // A rectangle of one layer's gids, all of a finite layer or one chunk of an infinite one
+  struct Tile_Block
+  {
+    std::ptrdiff_t x = 0;
+    std::ptrdiff_t y = 0;
+    std::size_t width = 0;
+    std::size_t height = 0;
+    const nlohmann::json *data = nullptr;
   };
 
-  const auto map_file = load_json(map_json);
+  // Finds the block holding a cell of a layer. Tiled writes the chunks of a layer all the same size,
+  // on a grid, so the block is found by dividing instead of searching.
+  class Layer_Blocks
+  {
+  public:
+    explicit Layer_Blocks(std::vector<Tile_Block> blocks) : blocks_{ std::move(blocks) }
+    {
+      if (blocks_.empty()) { return; }
+
+      block_size_ = Size{ blocks_.front().width, blocks_.front().height };
+      if (block_size_.width == 0 || block_size_.height == 0) { return; }
+
+      for (std::size_t index = 0; index < blocks_.size(); ++index) {
+        const auto &block = blocks_[index];
+        if (block.width != block_size_.width || block.height != block_size_.height
+            || grid_offset(block.x, block.width) != 0 || grid_offset(block.y, block.height) != 0) {
+          throw std::runtime_error(fmt::format("Unsupported tile layer chunk at ({}, {})", block.x, block.y));
+        }
+        grid_.emplace(grid_cell(block.x, block.y), index);
+      }
+    }
 
-  const Size tile_size{ map_file["tilewidth"], map_file["tileheight"] };
-  const Size map_size{ map_file["width"], map_file["height"] };
+    [[nodiscard]] const std::vector<Tile_Block> &blocks() const noexcept { return blocks_; }
 
-  Game_Map map{ map_size };
+    // 0 if no block covers the cell
+    [[nodiscard]] std::uint32_t gid(const std::ptrdiff_t x, const std::ptrdiff_t y)
+    {
+      if (grid_.empty()) { return 0; }
 
-  map.tile_sets = [&] {
-    std::vector<Tile_Set> result;
-    for (const auto &tileset : map_file["tilesets"]) {
-      const std::size_t start_gid = tileset["firstgid"];
-      const std::filesystem::path tsj_path = tileset["source"];
+      // the cells are read in runs, mostly from the same block
+      if (last_ == nullptr || !covers(*last_, x, y)) {
+        const auto block = grid_.find(grid_cell(x, y));
+        if (block == grid_.end()) { return 0; }
+        last_ = &blocks_[block->second];
+      }
 
-      const auto tsj = load_json(parent_path / tsj_path);
-      const std::filesystem::path tsj_image_path = tsj["image"];
-      result.emplace_back(parent_path / tsj_image_path, tile_size, start_gid);
+      const auto index = static_cast<std::size_t>(y - last_->y) * last_->width + static_cast<std::size_t>(x - last_->x);
+      return index < last_->data->size() ? (*last_->data)[index].get<std::uint32_t>() : 0;
+    }
 
-      for (const auto &tile : tsj["tiles"]) {
-        const std::size_t tile_id = tile["id"];
+  private:
+    [[nodiscard]] static std::ptrdiff_t grid_offset(const std::ptrdiff_t value, const std::size_t size)
+    {
+      const auto signed_size = static_cast<std::ptrdiff_t>(size);
+      return ((value % signed_size) + signed_size) % signed_size;
+    }
 
-        bool passable = true;
+    // wraps around for negative coordinates, which still gives every block its own key
+    [[nodiscard]] Point grid_cell(const std::ptrdiff_t x, const std::ptrdiff_t y) const
+    {
+      const auto column = (x - grid_offset(x, block_size_.width)) / static_cast<std::ptrdiff_t>(block_size_.width);
+      const auto row = (y - grid_offset(y, block_size_.height)) / static_cast<std::ptrdiff_t>(block_size_.height);
+      return Point{ static_cast<std::size_t>(column), static_cast<std::size_t>(row) };
+    }
+
+    [[nodiscard]] static bool covers(const Tile_Block &block, const std::ptrdiff_t x, const std::ptrdiff_t y)
+    {
+      return x >= block.x && y >= block.y && x - block.x < static_cast<std::ptrdiff_t>(block.width)
+             && y - block.y < static_cast<std::ptrdiff_t>(block.height);
+    }
+
+    std::vector<Tile_Block> blocks_;
+    Size block_size_{};
+    std::unordered_map<Point, std::size_t> grid_;
+    const Tile_Block *last_ = nullptr;
+  };
+}// namespace
+
+
+Tiled_Map read_tiled_map(const std::filesystem::path &map_json)
+{
+  auto layout = read_tiled_map_layout(map_json);
+
+  auto &assets = Asset_Registry::shared();
+  for (const auto &source : layout.tile_sets) {
+    const auto tile_set = assets.tile_set(source.tsj);
+    layout.map.tile_sets.push_back(Tiled_Map::Tile_Set_Data{ .start_id = source.start_id,
+      .image = assets.image(tile_set->image),
+      .properties = tile_set->properties,
+      .tsj = map_source(map_json, source.tsj),
+      .image_file = map_source(map_json, tile_set->image) });
+  }
+
+  return std::move(layout.map);
+}
+
+
+Tiled_Map::Source_File map_source(const std::filesystem::path &map_json, const std::filesystem::path &file)
+{
+  // the tile sets' paths all start with the map's directory, unless something is absolute
+  auto path = file.lexically_relative(map_json.parent_path());
+  if (path.empty()) { path = std::filesystem::absolute(file); }
+  return Tiled_Map::Source_File{ .path = std::move(path), .modified = std::filesystem::last_write_time(file) };
+}
 
-        if (tile.contains("properties")) {
-          for (const auto &property : tile["properties"]) {
-            // cppcheck-suppress useStlAlgorithm
-            if (property["name"] == "passable") { passable = property["value"]; }
-          }
-        }
 
-        result.back().properties[start_gid + tile_id] = Tile_Set::Tile_Properties{ .passable = passable };
+Tiled_Tile_Set read_tiled_tile_set(const std::filesystem::path &tsj_path)
+{
+  const auto tsj = load_json(tsj_path);
+  const std::filesystem::path tsj_image_path = tsj["image"];
+
+  Tile_Properties properties{ tsj["tilecount"].get<std::size_t>() };
+
+  for (const auto &tile : tsj["tiles"]) {
+    if (!tile.contains("properties")) { continue; }
+
+    const std::size_t tile_id = tile["id"];
+
+    for (const auto &property : tile["properties"]) {
+      const std::string name = property["name"];
+      const std::string type = property.value("type", "string");
+      const auto &value = property["value"];
+
+      if (type == "bool") {
+        properties.set(tile_id, name, value.get<bool>());
+      } else if (type == "int" || type == "object") {
+        properties.set(tile_id, name, value.get<std::int64_t>());
+      } else if (type == "float") {
+        properties.set(tile_id, name, value.get<double>());
+      } else if (type == "string" || type == "color" || type == "file") {
+        properties.set(tile_id, name, value.get<std::string>());
+      } else {
+        spdlog::warn("Ignoring tile property '{}' of unsupported type '{}'", name, type);
       }
     }
-    return result;
-  }();
+  }
+
+  return Tiled_Tile_Set{ .properties = std::make_shared<const Tile_Properties>(std::move(properties)),
+    .image = tsj_path.parent_path() / tsj_image_path };
+}
 
 
-  struct Layer_Info
-  {
-    // cppcheck is simply wrong here
+Tiled_Map_Layout read_tiled_map_layout(const std::filesystem::path &map_json)// NOLINT cognitive complexity
+{
+  const auto parent_path = map_json.parent_path();
+  const auto map_file = load_json(map_json);
+
+  Tiled_Map_Layout layout;
+  auto &result = layout.map;
+  result.tile_size = Size{ map_file["tilewidth"], map_file["tileheight"] };
+  result.map_size = Size{ map_file["width"], map_file["height"] };
 
-    std::size_t tileid;// cppcheck-suppress unusedStructMember
-    bool background;// cppcheck-suppress unusedStructMember
-    bool foreground;// cppcheck-suppress unusedStructMember
+  for (const auto &tileset : map_file["tilesets"]) {
+    const std::filesystem::path tsj_path = tileset["source"];
+    layout.tile_sets.push_back(Tiled_Tile_Set_Source{ tileset["firstgid"].get<std::size_t>(), parent_path / tsj_path });
+  }
+
+  const auto is_visible_tile_layer = [](const nlohmann::json &layer) {
+    return layer["type"] == "tilelayer" && layer["visible"] == true;
   };
 
-  std::map<Point, std::vector<Layer_Info>> points;
+  // Infinite maps store each layer as chunks that can be anywhere, including negative coordinates.
+  // The map covers the bounds of every chunk of every layer.
+  const bool infinite = map_file.value("infinite", false);
+  std::ptrdiff_t min_x = 0;
+  std::ptrdiff_t min_y = 0;
+
+  std::vector<Layer_Blocks> layer_blocks;
 
   for (const auto &layer : map_file["layers"]) {
-    if (layer["type"] == "tilelayer" && layer["visible"] == true) {
-      // std::size_t x = layer["x"];
-      // std::size_t y = layer["y"];
-      const std::size_t width = layer["width"];
-      // std::size_t height = layer["height"];
-
-      bool background = false;
-      bool foreground = false;
-
-      if (layer.contains("properties")) {
-        for (const auto &property : layer["properties"]) {
-          if (property["name"] == "foreground") {
-            foreground = property["value"];
-          } else if (property["name"] == "background") {
-            background = property["value"];
-          }
+    if (!is_visible_tile_layer(layer)) { continue; }
+
+    auto &tile_layer = result.layers.emplace_back();
+    if (layer.contains("properties")) {
+      for (const auto &property : layer["properties"]) {
+        if (property["name"] == "foreground") {
+          tile_layer.foreground = property["value"];
+        } else if (property["name"] == "background") {
+          tile_layer.background = property["value"];
         }
       }
+    }
+
+    std::vector<Tile_Block> blocks;
+    if (infinite) {
+      for (const auto &chunk : layer["chunks"]) {
+        blocks.push_back(Tile_Block{ .x = chunk["x"],
+          .y = chunk["y"],
+          .width = chunk["width"],
+          .height = chunk["height"],
+          .data = &chunk["data"] });
+      }
+    } else {
+      blocks.push_back(
+        Tile_Block{ .x = 0, .y = 0, .width = layer["width"], .height = layer["height"], .data = &layer["data"] });
+    }
+    layer_blocks.emplace_back(std::move(blocks));
+  }
+
+  if (infinite) {
+    std::ptrdiff_t max_x = 0;
+    std::ptrdiff_t max_y = 0;
+    bool first_block = true;
+
+    for (const auto &blocks : layer_blocks) {
+      for (const auto &block : blocks.blocks()) {
+        const auto width = static_cast<std::ptrdiff_t>(block.width);
+        const auto height = static_cast<std::ptrdiff_t>(block.height);
+        min_x = first_block ? block.x : std::min(min_x, block.x);
+        min_y = first_block ? block.y : std::min(min_y, block.y);
+        max_x = first_block ? block.x + width : std::max(max_x, block.x + width);
+        max_y = first_block ? block.y + height : std::max(max_y, block.y + height);
+        first_block = false;
+      }
+    }
+
+    result.map_size = Size{ static_cast<std::size_t>(max_x - min_x), static_cast<std::size_t>(max_y - min_y) };
+  }
+
+  // Most cells share the same stack of tiles, each unique stack is only kept once
+  std::map<std::vector<std::uint32_t>, std::uint32_t> stack_ids;
+  std::vector<std::uint32_t> stack(layer_blocks.size());
+  result.cells = Chunk_Runs::encode(result.map_size, [&](const Point cell) {
+    for (std::size_t layer = 0; layer < layer_blocks.size(); ++layer) {
+      stack[layer] = layer_blocks[layer].gid(
+        static_cast<std::ptrdiff_t>(cell.x) + min_x, static_cast<std::ptrdiff_t>(cell.y) + min_y);
+    }
 
-      std::size_t cur_x = 0;
-      std::size_t cur_y = 0;
-      for (const auto &tile : layer["data"]) {
+    const auto [stack_id, added] = stack_ids.try_emplace(stack, static_cast<std::uint32_t>(result.stacks.size()));
+    if (added) { result.stacks.push_back(stack); }
+    return stack_id->second;
+  });
 
-        const std::size_t tileid = tile;
+  return layout;
+}
 
-        points[Point{ cur_x, cur_y }].push_back(
-          Layer_Info{ .tileid = tileid, .background = background, .foreground = foreground });
 
-        ++cur_x;
-        if (cur_x == width) {
-          cur_x = 0;
-          ++cur_y;
-        }
+Game_Map load_tiled_map(const std::filesystem::path &map_json) { return make_game_map(read_tiled_map(map_json)); }
+
+
+Game_Map make_game_map(Tiled_Map tiled_map)
+{
+  const auto tile_size = tiled_map.tile_size;
+  const auto map_size = tiled_map.map_size;
+
+  Game_Map map{ map_size };
+
+  for (auto &tile_set : tiled_map.tile_sets) {
+    map.tile_sets.emplace_back(std::move(tile_set.image), tile_size, tile_set.start_id, std::move(tile_set.properties));
+  }
+
+  // composites all of the layers of a stack of tiles once, so drawing the cell is a single copy / blend
+  const auto make_tile_stack = [&](const std::vector<std::uint32_t> &gids) {
+    const auto &tile_set = map.tile_sets[0];
+    Tile_Stack result{ tile_size };
+    bool passable = true;
+
+    for (std::size_t layer = 0; layer < std::min(gids.size(), tiled_map.layers.size()); ++layer) {
+      const auto gid = gids[layer];
+      if (gid == 0) { continue; }
+
+      const auto &tile_layer = tiled_map.layers[layer];
+      const auto tile_pixels = tile_set.at(gid);
+      if (tile_layer.foreground) {
+        blend_span(result.foreground, tile_pixels);
+        result.has_foreground = true;
+      } else if (!result.has_background) {
+        copy_rows(tile_pixels, result.background);
+        result.has_background = true;
+      } else {
+        blend_span(result.background, tile_pixels);
       }
+
+      if (!tile_layer.foreground && !tile_layer.background) { passable = passable && tile_set.passable(gid); }
     }
-  }
 
+    result.passable = passable;
+    result.build_mip_levels();
 
-  for (const auto &[point, tile_data] : points) {
-    map.locations.at(point).draw = [tiles = tile_data](
-                                     Vector2D_Span<Color> &pixels, const Game &game, Point, Layer layer) {
-      const auto &tile_sets = game.get_current_map().tile_sets;
-      bool first_tile = true;
-      for (const auto &tile : tiles) {
-        if (tile.tileid == 0) { continue; }
-
-        if ((layer == Layer::Background && !tile.foreground) || (layer == Layer::Foreground && tile.foreground)) {
-          const auto &tile_pixels = tile_sets[0].at(tile.tileid);
-          for (std::size_t cur_y = 0; cur_y < pixels.size().height; ++cur_y) {
-            for (std::size_t cur_x = 0; cur_x < pixels.size().width; ++cur_x) {
-              const Point current_pixel{ cur_x, cur_y };
-
-              if (first_tile && !tile.foreground) {
-                pixels.at(current_pixel) = tile_pixels.at(current_pixel);
-              } else {
-                pixels.at(current_pixel) += tile_pixels.at(current_pixel);
-              }
-            }
-          }
-          first_tile = false;
-        }
+    return result;
+  };
+
+  // every stack is made up front, so `tile_stacks` never changes while chunks are being loaded
+  map.tile_stacks.reserve(tiled_map.stacks.size());
+  for (const auto &stack : tiled_map.stacks) { map.tile_stacks.push_back(make_tile_stack(stack)); }
+
+  // the cells themselves are only expanded when their chunk is loaded
+  map.tiles = Map_Chunks{ map_size,
+    [cells = std::move(tiled_map.cells), stack_count = map.tile_stacks.size()](
+      const Point origin, Map_Chunks::Chunk &chunk) {
+      cells.expand(Point{ origin.x / Map_Chunks::chunk_size, origin.y / Map_Chunks::chunk_size }, chunk);
+
+      // a damaged compiled map can name stacks that don't exist
+      for (auto row : chunk.rows()) {
+        std::replace_if(
+          row.begin(), row.end(), [&](const auto cell) { return cell >= stack_count; }, Map_Chunks::empty_cell);
       }
-    };
+    } };
+
+  return map;
+}
 
+void Tile_Stack::build_mip_levels()
+{
+  Vector2D<Color> composited{ background.size() };
+  if (has_background) { copy_rows(background, composited); }
+  if (has_foreground) { blend_span(composited, foreground); }
+
+  mip_levels.clear();
+  auto level_size = composited.size();
+  for (std::size_t level = 0; level < mip_level_count; ++level) {
+    level_size = Size{ std::max(level_size.width / 2, std::size_t{ 1 }), std::max(level_size.height / 2, std::size_t{ 1 }) };
+    box_filter(composited, mip_levels.emplace_back(level_size));
+  }
+}
 
-    map.locations.at(point).can_enter = [tiles = tile_data](const Game &game, Point, Direction) {
-      const auto &tile_sets = game.get_current_map().tile_sets;
-      return std::all_of(tiles.begin(), tiles.end(), [&](const auto &tile) {
-        return tile.foreground || tile.background || tile.tileid == 0
-               || tile_sets[0].properties.at(tile.tileid).passable;
-      });
-    };
+void Game_Map::draw(Vector2D_Span<Color> &pixels,
+  const Game &game,
+  Point location,
+  std::uint32_t stack_id,
+  Layer layer) const
+{
+  if (const auto *script = locations.find(location); script != nullptr && script->draw) {
+    script->draw(pixels, game, location, layer);
+    return;
   }
 
-  return map;
+  if (stack_id == no_tile_stack) { return; }
+
+  const auto &stack = tile_stacks[stack_id];
+  if (layer == Layer::Background && stack.has_background) {
+    copy_rows(stack.background, pixels);
+  } else if (layer == Layer::Foreground && stack.has_foreground) {
+    blend_span(pixels, stack.foreground);
+  }
+}
+
+bool move_player(Game &game, const Direction direction)
+{
+  auto location = game.player.map_location;
+  const auto last_location = location;
+
+  // the side of the new cell the player enters it from
+  Direction from{};
+
+  switch (direction) {
+  case Direction::North:
+    --location.y;
+    from = Direction::South;
+    break;
+  case Direction::South:
+    ++location.y;
+    from = Direction::North;
+    break;
+  case Direction::West:
+    --location.x;
+    from = Direction::East;
+    break;
+  case Direction::East:
+    ++location.x;
+    from = Direction::West;
+    break;
+  }
+
+  if (!game.maps.at(game.current_map).can_enter_from(game, location, from)) { return false; }
+
+  // the actions are copied out because they can change the map, and looked up through a const map
+  // so that cells without a script don't get an empty one added
+  auto exit_action = std::as_const(game).get_current_map().locations.at(last_location).exit_action;
+  if (exit_action) { exit_action(game, last_location, from); }
+
+  game.player.map_location = location;
+
+  spdlog::trace("Moved to: {}, {}", location.x, location.y);
+
+  auto enter_action = std::as_const(game).get_current_map().locations.at(location).enter_action;
+  if (enter_action) { enter_action(game, location, from); }
+
+  return true;
 }
 
 Menu::MenuItem::MenuItem(std::string text_,
@@ -191,8 +448,8 @@ Menu::MenuItem set_flag(std::string text, std::string message, variable var)
 {
   return { std::move(text), [message = std::move(message), var = std::move(var)](Game &game) {
             game.popup_message = message;
-            if (game.variables[var.name] != Variable{ true }) {
-              game.variables[var.name] = true;
+            if (game.variables[var.slot] != Variable{ true }) {
+              game.variables[var.slot] = true;
               game.set_menu(game.get_menu());
             }
           } };
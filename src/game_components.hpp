@@ -1,16 +1,22 @@
 #ifndef AWESOME_GAME_GAME_COMPONENTS_HPP
 #define AWESOME_GAME_GAME_COMPONENTS_HPP
 
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <fmt/format.h>
 #include <functional>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <optional>
+#include <unordered_map>
 #include <variant>
 
 #include "color.hpp"
+#include "map_chunks.hpp"
 #include "tile_set.hpp"
+#include "variables.hpp"
 #include "vector2d.hpp"
 
 namespace lefticus::travels {
@@ -20,12 +26,23 @@ struct Game;
 enum struct Direction { North, South, East, West };
 enum struct Layer { Background, Foreground };
 
+// The scripted behavior of one map cell. Any member that is empty falls back to the cell's tiles.
 struct Location
 {
   std::function<void(Game &, Point, Direction)> enter_action;
   std::function<void(Game &, Point, Direction)> exit_action;
+  // May be called for several cells at once from different threads (see `Viewport_Tracker::pool`).
+  // It must only write to its pixels and only read the game. Only the cells in view of the map are
+  // guaranteed to be loaded, any other cell has to be read with `Map_Chunks::resident_at`, since
+  // loading it isn't safe from several threads. Any other state it shares needs its own
+  // synchronization.
   std::function<void(Vector2D_Span<Color> &, const Game &, Point, Layer)> draw;
   std::function<bool(const Game &, Point, Direction)> can_enter;
+
+  // true if `draw` only ever depends on the map location, and not on the clock or other game state.
+  // Static locations are only redrawn when something moves over them or the view changes.
+  // Cells without a `draw` are always static.
+  bool static_draw = false;
 };
 
 struct Character
@@ -35,55 +52,263 @@ struct Character
 };
 
 
+// The layers of one unique stack of tiles from a Tiled map, composited at load time.
+// Cells with identical stacks share a single Tile_Stack.
+struct Tile_Stack
+{
+  explicit Tile_Stack(const Size tile_size) : background{ tile_size }, foreground{ tile_size } {}
+
+  Vector2D<Color> background;
+  Vector2D<Color> foreground;
+  bool has_background = false;
+  bool has_foreground = false;
+  bool passable = true;
+
+  // Box filtered reductions of both layers composited, for drawing the map zoomed out.
+  // Each level is half the size of the one before, the first is half of the tile size.
+  static constexpr std::size_t mip_level_count = 3;
+  std::vector<Vector2D<Color>> mip_levels;
+
+  // call once the layers are complete
+  void build_mip_levels();
+};
+
+// The scripted cells of a map. Only a handful of cells have scripts, so they are kept
+// in a hash map instead of taking up space in every cell.
+class Map_Locations
+{
+public:
+  explicit Map_Locations(const Size size) : size_{ size } {}
+
+  [[nodiscard]] Size size() const noexcept { return size_; }
+
+  // the script of the cell at `point`, an empty one is added if it doesn't have one yet
+  [[nodiscard]] Location &at(const Point point)
+  {
+    validate_position(point);
+    return locations_[point];
+  }
+
+  // an empty Location if the cell at `point` has no script
+  [[nodiscard]] const Location &at(const Point point) const
+  {
+    validate_position(point);
+    const auto *location = find(point);
+    return location != nullptr ? *location : empty_location;
+  }
+
+  // nullptr if the cell at `point` has no script
+  [[nodiscard]] const Location *find(const Point point) const noexcept
+  {
+    const auto location = locations_.find(point);
+    return location != locations_.end() ? &location->second : nullptr;
+  }
+
+  [[nodiscard]] std::size_t scripted_count() const noexcept { return locations_.size(); }
+
+private:
+  void validate_position(const Point point) const
+  {
+    if (point.x >= size_.width || point.y >= size_.height) {
+      throw std::range_error(fmt::format("index out of range, got: ({},{}), allowed ({}, {})",
+        point.x,
+        point.y,
+        size_.width - 1,
+        size_.height - 1));
+    }
+  }
+
+  inline static const Location empty_location{};
+
+  Size size_;
+  std::unordered_map<Point, Location> locations_;
+};
+
+// gives every cell of the map the same script
+inline void fill(Map_Locations &locations, const Location &value)
+{
+  for (std::size_t y = 0; y < locations.size().height; ++y) {
+    for (std::size_t x = 0; x < locations.size().width; ++x) { locations.at(Point{ x, y }) = value; }
+  }
+}
+
 struct Game_Map
 {
-  explicit Game_Map(const Size size) : locations{ size } {}
-  Vector2D<Location> locations;
+  static constexpr std::uint32_t no_tile_stack = Map_Chunks::empty_cell;
+
+  explicit Game_Map(const Size size) : tiles{ size }, locations{ size } {}
+
+  // the index into `tile_stacks` for each cell, or `no_tile_stack`
+  Map_Chunks tiles;
+
+  // scripts for individual cells, which take precedence over their tiles
+  Map_Locations locations;
 
   std::vector<Tile_Set> tile_sets;
+  std::vector<Tile_Stack> tile_stacks;
+
+  [[nodiscard]] Size size() const noexcept { return tiles.size(); }
 
   [[nodiscard]] bool can_enter_from(const Game &game, Point location, Direction from) const
   {
-    const auto &map_location = locations.at(location);
-    if (map_location.can_enter) {
-      return map_location.can_enter(game, location, from);
-    } else {
-      return true;
+    if (const auto *script = locations.find(location); script != nullptr && script->can_enter) {
+      return script->can_enter(game, location, from);
     }
+
+    const auto stack = tiles.at(location);
+    return stack == no_tile_stack || tile_stacks[stack].passable;
+  }
+
+  // draws one layer of the cell at `location`
+  void draw(Vector2D_Span<Color> &pixels, const Game &game, Point location, Layer layer) const
+  {
+    draw(pixels, game, location, tiles.at(location), layer);
+  }
+
+  // the same, with the cell's value in `tiles` already read, so it doesn't touch `tiles` at all
+  void draw(Vector2D_Span<Color> &pixels, const Game &game, Point location, std::uint32_t stack_id, Layer layer) const;
+
+  // see `Location::static_draw`
+  [[nodiscard]] bool static_draw(const Point location) const noexcept
+  {
+    const auto *script = locations.find(location);
+    return script == nullptr || !script->draw || script->static_draw;
   }
 };
 
+// Everything a Game_Map is built from: a Tiled map with its tilesets and their decoded images.
+// Comes either from the Tiled JSON files or from a compiled map, see compiled_map.hpp
+struct Tiled_Map
+{
+  // one of the files the map was read from, besides the map itself
+  struct Source_File
+  {
+    std::filesystem::path path;// relative to the map's directory
+    std::filesystem::file_time_type modified{};// as it was when the map was read
+  };
+
+  struct Tile_Set_Data
+  {
+    std::size_t start_id = 0;
+    // shared with every other map using the same files, see Asset_Registry
+    std::shared_ptr<const Vector2D<Color>> image = std::make_shared<const Vector2D<Color>>(Size{ 0, 0 });
+    std::shared_ptr<const Tile_Properties> properties = std::make_shared<const Tile_Properties>();
+    // empty paths for a tile set that wasn't read from files
+    Source_File tsj;
+    Source_File image_file;
+  };
+
+  struct Tile_Layer
+  {
+    bool background = false;
+    bool foreground = false;
+  };
+
+  Size tile_size{};
+  Size map_size{};
+  std::vector<Tile_Set_Data> tile_sets;
+  std::vector<Tile_Layer> layers;// only the visible tile layers
+
+  // every distinct stack of gids on the map, one gid for each of `layers`, 0 where a layer has no tile
+  std::vector<std::vector<std::uint32_t>> stacks;
+  // the index in `stacks` of each cell
+  Chunk_Runs cells;
+};
+
+Tiled_Map read_tiled_map(const std::filesystem::path &map_json);
+
+// The steps of `read_tiled_map`, separately, so that they can run in parallel (see Asset_Loader)
+
+struct Tiled_Tile_Set_Source
+{
+  std::size_t start_id = 0;
+  std::filesystem::path tsj;
+};
+
+struct Tiled_Map_Layout
+{
+  Tiled_Map map;// without tile sets
+  std::vector<Tiled_Tile_Set_Source> tile_sets;
+};
+
+struct Tiled_Tile_Set
+{
+  std::shared_ptr<const Tile_Properties> properties;
+  std::filesystem::path image;// not loaded
+};
+
+Tiled_Map_Layout read_tiled_map_layout(const std::filesystem::path &map_json);
+Tiled_Tile_Set read_tiled_tile_set(const std::filesystem::path &tsj);
+
+// `file`, one of the files the map in `map_json` is read from, as it is now
+// throws std::filesystem::filesystem_error if it doesn't exist
+Tiled_Map::Source_File map_source(const std::filesystem::path &map_json, const std::filesystem::path &file);
+
+// Only the tile stacks are made up front, the cells of each chunk are expanded when it is loaded
+Game_Map make_game_map(Tiled_Map tiled_map);
+
 Game_Map load_tiled_map(const std::filesystem::path &map_json, const std::vector<std::filesystem::path> &search_paths);
 Game_Map load_tiled_map(const std::filesystem::path &map_json);
 
 
-using Variable = std::variant<double, std::int64_t, std::string, bool>;
+[[nodiscard]] const Variables &variables_of(const Game &game);
 
+// A condition on the game's variables.
+//
+// The result is cached until one of the variables in `inputs` changes. The cache is shared by
+// every copy, so a condition that is used in several others is still only evaluated once per change.
 template<typename Comparitor> struct Variable_Comparison
 {
+  Variable_Comparison(Comparitor comparitor_, std::vector<Variable_Slot> inputs_)
+    : comparitor{ std::move(comparitor_) }, inputs{ std::move(inputs_) }
+  {}
+
   Comparitor comparitor;
+  std::vector<Variable_Slot> inputs;// sorted, every variable `comparitor` can read
+  std::shared_ptr<Condition_Cache> cache = std::make_shared<Condition_Cache>();
 
-  bool operator()(const Game &game) const { return comparitor(game); }
+  bool operator()(const Game &game) const
+  {
+    return cache->get(variables_of(game), inputs, [&] { return comparitor(game); });
+  }
 };
 
-template<typename T> Variable_Comparison(T t) -> Variable_Comparison<T>;
+template<typename T> Variable_Comparison(T t, std::vector<Variable_Slot>) -> Variable_Comparison<T>;
 
+inline std::vector<Variable_Slot> combined_inputs(const std::vector<Variable_Slot> &lhs,
+  const std::vector<Variable_Slot> &rhs)
+{
+  std::vector<Variable_Slot> result;
+  std::ranges::set_union(lhs, rhs, std::back_inserter(result));
+  return result;
+}
 
+
+// both sides keep their own cache, so only the side whose inputs changed is evaluated again
 template<typename LHS, typename RHS> auto operator&&(Variable_Comparison<LHS> lhs, Variable_Comparison<RHS> rhs)
 {
-  return Variable_Comparison{ [lhs = std::move(lhs.comparitor), rhs = std::move(rhs.comparitor)](
-                                const Game &game) { return lhs(game) && rhs(game); } };
+  auto inputs = combined_inputs(lhs.inputs, rhs.inputs);
+  return Variable_Comparison{
+    [lhs = std::move(lhs), rhs = std::move(rhs)](const Game &game) { return lhs(game) && rhs(game); },
+    std::move(inputs)
+  };
 }
 
 template<typename LHS, typename RHS> auto operator||(Variable_Comparison<LHS> lhs, Variable_Comparison<RHS> rhs)
 {
-  return Variable_Comparison{ [lhs = std::move(lhs.comparitor), rhs = std::move(rhs.comparitor)](
-                                const Game &game) { return lhs(game) || rhs(game); } };
+  auto inputs = combined_inputs(lhs.inputs, rhs.inputs);
+  return Variable_Comparison{
+    [lhs = std::move(lhs), rhs = std::move(rhs)](const Game &game) { return lhs(game) || rhs(game); },
+    std::move(inputs)
+  };
 }
 
+// names a game variable in a condition, the name is interned when the condition is built
 struct variable
 {
-  std::string name;
+  explicit variable(const std::string_view name) : slot{ Variable_Slot::intern(name) } {}
+
+  Variable_Slot slot;
 };
 
 
@@ -103,14 +328,14 @@ struct Menu
 
     template<typename Compare>
     MenuItem(std::string text_, std::string message_, Variable_Comparison<Compare> comp)
-      : MenuItem(std::move(text_), std::move(message_), std::function<bool(const Game &)>(std::move(comp.comparitor)))
+      : MenuItem(std::move(text_), std::move(message_), std::function<bool(const Game &)>(std::move(comp)))
     {}
 
     MenuItem(std::string text_, std::function<void(Game &)> action_, std::function<bool(const Game &)> visible_ = {});
 
     template<typename Compare>
     MenuItem(std::string text_, std::function<void(Game &)> action_, Variable_Comparison<Compare> comp)
-      : MenuItem(std::move(text_), std::move(action_), std::function<bool(const Game &)>(std::move(comp.comparitor)))
+      : MenuItem(std::move(text_), std::move(action_), std::function<bool(const Game &)>(std::move(comp)))
     {}
   };
 
@@ -128,8 +353,7 @@ struct Game
   Character player;
   std::function<void(Game &)> start_game;
 
-  // enable transparent comparators for std::string
-  std::map<std::string, Variable, std::less<>> variables;
+  Variables variables;
   std::vector<std::string> display_variables;
   std::string current_map;
   std::chrono::milliseconds clock;
@@ -160,6 +384,9 @@ struct Game
     }
   }
 
+  // the menu, without marking it as shown like `get_menu` does
+  [[nodiscard]] const std::optional<Menu> &peek_menu() const noexcept { return menu; }
+
   void set_menu(Menu menu_)
   {
     menu_is_new = true;
@@ -177,81 +404,87 @@ private:
   bool menu_is_new = false;
 };
 
+inline const Variables &variables_of(const Game &game) { return game.variables; }
+
+// Takes one step in `direction`, running the exit action of the cell left and the enter action
+// of the cell entered. Returns false, without moving, if the way is blocked.
+bool move_player(Game &game, Direction direction);
+
 // cppcheck is wrong about these wanting to be passed by const &.
 // that is because these are sinks
 
 template<typename Value> auto operator==(variable var, Value value)
 {
-  return Variable_Comparison{ [name = std::move(var).name, value = Variable{ std::move(value) }](
-                                const Game &game) { return game.variables.at(name) == value; } };
+  return Variable_Comparison{ [slot = var.slot, value = Variable{ std::move(value) }](
+                                const Game &game) { return game.variables.at(slot) == value; }, { var.slot } };
 }
 
 template<typename Value> auto operator==(Value value, variable var)
 {
-  return Variable_Comparison{ [name = std::move(var).name, value = Variable{ std::move(value) }](
-                                const Game &game) { return value == game.variables.at(name); } };
+  return Variable_Comparison{ [slot = var.slot, value = Variable{ std::move(value) }](
+                                const Game &game) { return value == game.variables.at(slot); }, { var.slot } };
 }
 
 
 template<typename Value> auto operator!=(variable var, Value value)
 {
-  return Variable_Comparison{ [name = std::move(var).name, value = Variable{ std::move(value) }](
-                                const Game &game) { return game.variables.at(name) != value; } };
+  return Variable_Comparison{ [slot = var.slot, value = Variable{ std::move(value) }](
+                                const Game &game) { return game.variables.at(slot) != value; }, { var.slot } };
 }
 
 template<typename Value> auto operator!=(Value value, variable var)
 {
-  return Variable_Comparison{ [name = std::move(var).name, value = Variable{ std::move(value) }](
-                                const Game &game) { return value != game.variables.at(name); } };
+  return Variable_Comparison{ [slot = var.slot, value = Variable{ std::move(value) }](
+                                const Game &game) { return value != game.variables.at(slot); }, { var.slot } };
 }
 
 template<typename Value> auto operator<(variable var, Value value)
 {
-  return Variable_Comparison{ [name = std::move(var).name, value = Variable{ std::move(value) }](
-                                const Game &game) { return game.variables.at(name) < value; } };
+  return Variable_Comparison{ [slot = var.slot, value = Variable{ std::move(value) }](
+                                const Game &game) { return game.variables.at(slot) < value; }, { var.slot } };
 }
 
 template<typename Value> auto operator<(Value value, variable var)
 {
-  return Variable_Comparison{ [name = std::move(var).name, value = Variable{ std::move(value) }](
-                                const Game &game) { return value < game.variables.at(name); } };
+  return Variable_Comparison{ [slot = var.slot, value = Variable{ std::move(value) }](
+                                const Game &game) { return value < game.variables.at(slot); }, { var.slot } };
 }
 
 
 template<typename Value> auto operator<=(variable var, Value value)
 {
-  return Variable_Comparison{ [name = std::move(var).name, value = Variable{ std::move(value) }](
-                                const Game &game) { return game.variables.at(name) <= value; } };
+  return Variable_Comparison{ [slot = var.slot, value = Variable{ std::move(value) }](
+                                const Game &game) { return game.variables.at(slot) <= value; }, { var.slot } };
 }
 
 template<typename Value> auto operator<=(Value value, variable var)
 {
-  return Variable_Comparison{ [name = std::move(var).name, value = Variable{ std::move(value) }](
-                                const Game &game) { return value <= game.variables.at(name); } };
+  return Variable_Comparison{ [slot = var.slot, value = Variable{ std::move(value) }](
+                                const Game &game) { return value <= game.variables.at(slot); }, { var.slot } };
 }
 
 template<typename Value> auto operator>(variable var, Value value)
 {
-  return Variable_Comparison{ [name = std::move(var).name, value = Variable{ std::move(value) }](
-                                const Game &game) { return game.variables.at(name) > value; } };
+  return Variable_Comparison{ [slot = var.slot, value = Variable{ std::move(value) }](
+                                const Game &game) { return game.variables.at(slot) > value; }, { var.slot } };
 }
 
 template<typename Value> auto operator>(Value value, variable var)
 {
-  return Variable_Comparison{ [name = std::move(var).name, value = Variable{ std::move(value) }](
-                                const Game &game) { return value > game.variables.at(name); } };
+  return Variable_Comparison{ [slot = var.slot, value = Variable{ std::move(value) }](
+                                const Game &game) { return value > game.variables.at(slot); }, { var.slot } };
 }
 
 template<typename Value> auto operator>=(variable var, Value value)
 {
-  return Variable_Comparison{ [name = std::move(var).name, value = Variable{ std::move(value) }](
-                                const Game &game) { return game.variables.at(name) >= value; } };
+  return Variable_Comparison{ [slot = var.slot, value = Variable{ std::move(value) }](
+                                const Game &game) { return game.variables.at(slot) >= value; }, { var.slot } };
 }
 
 template<typename Value> auto operator>=(Value value, variable var)
 {
-  return Variable_Comparison{ [name = std::move(var).name, value = Variable{ std::move(value) }](
-                                const Game &game) { return value >= game.variables.at(name); } };
+  return Variable_Comparison{ [slot = var.slot, value = Variable{ std::move(value) }](
+                                const Game &game) { return value >= game.variables.at(slot); }, { var.slot } };
 }
 
 Menu::MenuItem exit_menu();
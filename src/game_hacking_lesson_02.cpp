@@ -1,6 +1,7 @@
 #include "game_hacking_lesson_02.hpp"
 #include "bitmap.hpp"
 #include "game_components.hpp"
+#include <mutex>
 #include <set>
 
 namespace lefticus::travels::hacking::lesson_02 {
@@ -9,7 +10,14 @@ Game_Map make_map()// NOLINT cognitive complexity
 {
   Game_Map map{ Size{ 10, 10 } };// NOLINT magic numbers
 
-  auto colors_used = std::make_shared<std::set<Color>>();
+  // `draw` can run for several cells at once, see `Location::draw`
+  struct Colors_Used
+  {
+    std::mutex mutex;
+    std::set<Color> colors;
+  };
+
+  auto colors_used = std::make_shared<Colors_Used>();
 
   auto empty_draw = [](Vector2D_Span<Color> &pixels,
                       [[maybe_unused]] const Game &game,
@@ -72,7 +80,10 @@ Game_Map make_map()// NOLINT cognitive complexity
       // When you add a new color, try to not use // NOLINT!
     }
 
-    colors_used->insert(pixels.at(Point{ 3, 3 }));
+    {
+      const std::scoped_lock lock{ colors_used->mutex };
+      colors_used->colors.insert(pixels.at(Point{ 3, 3 }));
+    }
 
 
     if (!game.maps.at(game.current_map).can_enter_from(game, map_location, Direction::East)) {
@@ -116,8 +127,7 @@ Game_Map make_map()// NOLINT cognitive complexity
   static constexpr auto test_and_set =
     [](Game &game, const std::string &key_to_test, const std::string &key_to_set) -> bool// NOLINT easily swappable
   {
-    if (const auto &value = game.variables.find(key_to_test);
-        value != game.variables.end() && std::get<bool>(value->second)) {
+    if (const auto *value = game.variables.find(key_to_test); value != nullptr && std::get<bool>(*value)) {
       game.variables[key_to_set] = true;
       return true;
     } else {
@@ -182,7 +192,8 @@ Game_Map make_map()// NOLINT cognitive complexity
   map.locations.at(special_location) = Flashing_Tile;
   map.locations.at(special_location).can_enter =
     [colors_used]([[maybe_unused]] const Game &game, Point, [[maybe_unused]] Direction direction) {
-      return colors_used->size() > 2;
+      const std::scoped_lock lock{ colors_used->mutex };
+      return colors_used->colors.size() > 2;
     };
 
   map.locations.at(special_location).enter_action = [](Game &game, Point, Direction) {
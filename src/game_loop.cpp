@@ -0,0 +1,62 @@
+#include "game_loop.hpp"
+
+namespace lefticus::travels {
+
+bool move_player(Game &game, const Input_Command command)
+{
+  switch (command) {
+  case Input_Command::Move_North:
+    return move_player(game, Direction::North);
+  case Input_Command::Move_South:
+    return move_player(game, Direction::South);
+  case Input_Command::Move_West:
+    return move_player(game, Direction::West);
+  case Input_Command::Move_East:
+    return move_player(game, Direction::East);
+  case Input_Command::Show_Log:
+  case Input_Command::Toggle_Timings:
+  case Input_Command::Toggle_Minimap:
+  case Input_Command::Choose_Menu_Item:
+  case Input_Command::Dismiss_Popup:
+  case Input_Command::Close_Menu:
+    return false;
+  }
+
+  return false;
+}
+
+bool answer(Game &game, const Input_Command command, const std::uint32_t menu_item)
+{
+  switch (command) {
+  case Input_Command::Choose_Menu_Item: {
+    const auto &menu = game.peek_menu();
+    if (!menu || menu_item >= menu->items.size()) { return false; }
+
+    // a copy, the action may well replace the menu it is in
+    const auto item = menu->items[menu_item];
+    if (item.visible && !item.visible(game)) { return false; }
+    item.action(game);
+    return true;
+  }
+  case Input_Command::Dismiss_Popup:
+    if (!game.has_popup_message()) { return false; }
+    game.popup_message.clear();
+    return true;
+  case Input_Command::Close_Menu:
+    if (!game.has_menu()) { return false; }
+    game.clear_menu();
+    return true;
+  case Input_Command::Move_North:
+  case Input_Command::Move_South:
+  case Input_Command::Move_West:
+  case Input_Command::Move_East:
+  case Input_Command::Show_Log:
+  case Input_Command::Toggle_Timings:
+  case Input_Command::Toggle_Minimap:
+    return false;
+  }
+
+  return false;
+}
+
+}// namespace lefticus::travels
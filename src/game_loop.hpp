@@ -0,0 +1,22 @@
+#ifndef AWESOME_GAME_GAME_LOOP_HPP
+#define AWESOME_GAME_GAME_LOOP_HPP
+
+#include <cstdint>
+
+#include "game_components.hpp"
+#include "input_queue.hpp"
+
+namespace lefticus::travels {
+
+// One step of the player for a movement command, returns false if the way was blocked or
+// `command` doesn't move the player
+bool move_player(Game &game, Input_Command command);
+
+// Runs the action of `menu_item`, an index into the items of the game's menu, for Choose_Menu_Item,
+// or clears the popup or the menu for Dismiss_Popup and Close_Menu. Returns false, without doing
+// anything, if there is no such menu item or popup, the item is hidden, or `command` is another one.
+bool answer(Game &game, Input_Command command, std::uint32_t menu_item = 0);
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_GAME_LOOP_HPP
@@ -0,0 +1,208 @@
+#include "headless.hpp"
+#include "ansi_encoder.hpp"
+#include "bitmap.hpp"
+#include "fixed_timestep.hpp"
+#include "game_loop.hpp"
+#include "thread_pool.hpp"
+#include "viewport.hpp"
+
+#include <cmath>
+#include <fmt/format.h>
+#include <limits>
+#include <stdexcept>
+
+#ifdef _MSC_VER
+#pragma warning(disable : 4189)
+#endif
+#include <spdlog/spdlog.h>
+#ifdef _MSC_VER
+#pragma warning(default : 4189)
+#endif
+
+namespace lefticus::travels {
+
+std::vector<std::optional<Input_Command>> parse_input_script(const std::string_view script)
+{
+  std::vector<std::optional<Input_Command>> result;
+  result.reserve(script.size());
+
+  for (const auto character : script) {
+    switch (character) {
+    case 'n':
+      result.emplace_back(Input_Command::Move_North);
+      break;
+    case 's':
+      result.emplace_back(Input_Command::Move_South);
+      break;
+    case 'e':
+      result.emplace_back(Input_Command::Move_East);
+      break;
+    case 'w':
+      result.emplace_back(Input_Command::Move_West);
+      break;
+    case '.':
+      result.emplace_back(std::nullopt);
+      break;
+    default:
+      throw std::invalid_argument(fmt::format("Unknown input '{}' in input script, expected one of 'nsew.'", character));
+    }
+  }
+
+  return result;
+}
+
+double Headless_Report::frames_per_second() const noexcept
+{
+  const auto seconds = std::chrono::duration<double>(wall_time).count();
+  return seconds > 0 ? static_cast<double>(frames.size()) / seconds : 0.0;
+}
+
+double Headless_Report::encoded_bytes_per_frame() const noexcept
+{
+  if (frames.empty()) { return 0.0; }
+
+  std::size_t total = 0;
+  for (const auto &frame : frames) { total += frame.encoded_bytes; }
+  return static_cast<double>(total) / static_cast<double>(frames.size());
+}
+
+std::vector<std::string> Headless_Report::summary_lines() const
+{
+  std::vector<std::string> lines;
+  lines.push_back(fmt::format("Frames: {} in {:.3f}s ({:.1f} fps)",
+    frames.size(),
+    std::chrono::duration<double>(wall_time).count(),
+    frames_per_second()));
+  lines.push_back(fmt::format("Ticks: {}", ticks));
+  if (!frames.empty()) {
+    lines.push_back(fmt::format("Viewport output: {:.1f} bytes/frame, {} for the first frame",
+      encoded_bytes_per_frame(),
+      frames.front().encoded_bytes));
+  }
+
+  for (auto &line : timings.summary_lines()) { lines.push_back(std::move(line)); }
+  return lines;
+}
+
+Headless_Report run_headless(Game &game, const Headless_Options &options)
+{
+  using clock = std::chrono::steady_clock;
+
+  const auto seconds_to_duration = [](const double seconds) {
+    return std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(seconds));
+  };
+
+  const auto frame_length = seconds_to_duration(1.0 / options.render_rate);
+  const auto start = clock::time_point{};
+
+  const auto &replay = options.replay;
+  const auto tick_rate = replay ? replay->tick_rate : options.tick_rate;
+
+  // frame `n` has run `n * tick_rate / render_rate` ticks, plus one frame to draw the end result
+  const auto frames = replay ? static_cast<std::size_t>(std::ceil(static_cast<double>(replay->ticks)
+                                                                   * options.render_rate / tick_rate))
+                                 + 1
+                             : options.frames;
+
+  Headless_Report report;
+  report.frames.reserve(frames);
+  report.recording.tick_rate = tick_rate;
+
+  // nothing can fall behind in simulated time, so there is no limit on catching up
+  Fixed_Timestep simulation{ seconds_to_duration(1.0 / tick_rate),
+    std::numeric_limits<std::size_t>::max(),
+    start,
+    report.timings.tick_jitter };
+
+  Input_Queue input_queue;
+  Bitmap viewport{ options.viewport };
+  Ansi_Encoder encoder;
+  const auto draw_threads = std::min(options.draw_threads, max_draw_bands(options.viewport, game.tile_size) - 1);
+  std::optional<Thread_Pool> draw_pool;
+  if (draw_threads > 0) { draw_pool.emplace(draw_threads); }
+
+  Viewport_Tracker tracker;
+  tracker.pool = draw_pool ? &*draw_pool : nullptr;
+
+  std::size_t next_replayed = 0;
+
+  const auto run = [&](const Input_Command command, const std::size_t count, const std::uint32_t menu_item) {
+    report.recording.inputs.push_back(Input_Recording::Input{ .tick = simulation.ticks(),
+      .command = command,
+      .count = static_cast<std::uint32_t>(count),
+      .menu_item = menu_item });
+
+    if (command == Input_Command::Choose_Menu_Item || command == Input_Command::Dismiss_Popup
+        || command == Input_Command::Close_Menu) {
+      if (!answer(game, command, menu_item)) {
+        spdlog::warn("Tick {}: there is no menu item {} or popup to answer, the replay has gone its own way",
+          simulation.ticks(),
+          menu_item);
+      }
+      return;
+    }
+
+    for (std::size_t step = 0; step < count; ++step) {
+      if (!move_player(game, command)) { break; }
+    }
+  };
+
+  const auto run_start = clock::now();
+  auto last_frame_start = run_start;
+
+  for (std::size_t frame = 0; frame < frames; ++frame) {
+    const auto frame_start = clock::now();
+    if (frame != 0) { report.timings.frame.add(frame_start - last_frame_start); }
+    last_frame_start = frame_start;
+
+    const auto now = start + frame_length * static_cast<clock::rep>(frame);
+
+    // a replay answers them the way the recording did, on the same tick
+    if (!replay) {
+      if (game.has_popup_message()) { run(Input_Command::Dismiss_Popup, 1, 0); }
+      if (game.has_menu()) { run(Input_Command::Close_Menu, 1, 0); }
+    }
+
+    if (!replay && frame < options.input.size() && options.input[frame]) {
+      input_queue.push(*options.input[frame], now);
+    }
+
+    Headless_Report::Frame result;
+
+    {
+      const Scoped_Timer timer{ report.timings.events };
+      simulation.update(now, [&] {
+        game.clock = std::chrono::duration_cast<std::chrono::milliseconds>(simulation.simulated_time());
+
+        if (replay) {
+          const auto &inputs = replay->inputs;
+          for (; next_replayed < inputs.size() && inputs[next_replayed].tick <= simulation.ticks(); ++next_replayed) {
+            run(inputs[next_replayed].command, inputs[next_replayed].count, inputs[next_replayed].menu_item);
+          }
+        } else {
+          input_queue.drain(now, [&](const Input_Command command, const std::size_t count) { run(command, count, 0); });
+        }
+      });
+      result.simulation = clock::now() - frame_start;
+    }
+
+    {
+      const auto draw_start = clock::now();
+      const Scoped_Timer timer{ report.timings.draw };
+      draw(viewport, game, tracker);
+      result.draw = clock::now() - draw_start;
+    }
+
+    result.hash = content_hash(viewport.pixels);
+    result.encoded_bytes = encoder.encode(viewport.pixels).size();
+    report.frames.push_back(result);
+  }
+
+  report.wall_time = clock::now() - run_start;
+  report.ticks = simulation.ticks();
+  report.recording.ticks = report.ticks;
+
+  return report;
+}
+
+}// namespace lefticus::travels
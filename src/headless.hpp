@@ -0,0 +1,77 @@
+#ifndef AWESOME_GAME_HEADLESS_HPP
+#define AWESOME_GAME_HEADLESS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "frame_timings.hpp"
+#include "game_components.hpp"
+#include "input_queue.hpp"
+#include "input_recording.hpp"
+#include "size.hpp"
+
+namespace lefticus::travels {
+
+// Runs the game loop without a terminal: simulation and drawing into an off screen bitmap,
+// for measuring throughput and checking that a run is reproducible.
+//
+// Time is simulated, frame `n` happens exactly `n / render_rate` seconds after the start no
+// matter how long the frames take, so the same game and input always produce the same frames.
+// Popups and menus are dismissed as soon as they appear, there is no one to answer them, unless
+// a replay answers them as they were answered in the recording.
+struct Headless_Options
+{
+  std::size_t frames = 600;// NOLINT magic number
+  double tick_rate = 60;// NOLINT magic number
+  double render_rate = 30;// NOLINT magic number
+  Size viewport{ 64, 40 };// NOLINT magic numbers
+
+  // the input for each frame, in order, frames after the last one have no input
+  std::vector<std::optional<Input_Command>> input{};
+
+  // if set, replaces `input`: each recorded command runs on the tick it was recorded on, at the
+  // recording's tick rate, and `frames` is however many it takes to reach the end of the recording
+  std::optional<Input_Recording> replay{};
+
+  // threads helping to draw each frame, see `Viewport_Tracker::pool`
+  std::size_t draw_threads = 0;
+};
+
+// One character per frame: `n`, `s`, `e` and `w` move, `.` is no input.
+// throws std::invalid_argument for anything else
+[[nodiscard]] std::vector<std::optional<Input_Command>> parse_input_script(std::string_view script);
+
+struct Headless_Report
+{
+  struct Frame
+  {
+    std::chrono::steady_clock::duration simulation{};
+    std::chrono::steady_clock::duration draw{};
+    std::uint64_t hash = 0;// `content_hash` of the viewport
+    std::size_t encoded_bytes = 0;// the viewport's changes as Ansi_Encoder output, nothing is written
+  };
+
+  std::vector<Frame> frames;
+  Frame_Timings timings;
+  std::chrono::steady_clock::duration wall_time{};
+  std::uint64_t ticks = 0;
+  // the input as it was run, replaying it reproduces the same frames
+  Input_Recording recording;
+
+  [[nodiscard]] double frames_per_second() const noexcept;
+
+  [[nodiscard]] double encoded_bytes_per_frame() const noexcept;
+
+  // the totals, then the timing summary
+  [[nodiscard]] std::vector<std::string> summary_lines() const;
+};
+
+Headless_Report run_headless(Game &game, const Headless_Options &options);
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_HEADLESS_HPP
@@ -0,0 +1,118 @@
+#ifndef AWESOME_GAME_INPUT_QUEUE_HPP
+#define AWESOME_GAME_INPUT_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+namespace lefticus::travels {
+
+// Bounded, lock-free, single producer / single consumer queue.
+// `try_push` may only be called from one thread, and `try_pop` from one (other) thread.
+template<typename Contained, std::size_t Capacity> class SPSC_Queue
+{
+  static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+public:
+  // returns false if the queue is full
+  [[nodiscard]] bool try_push(const Contained &value) noexcept
+  {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == Capacity) { return false; }
+
+    buffer_[tail & (Capacity - 1)] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  [[nodiscard]] std::optional<Contained> try_pop() noexcept
+  {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) { return std::nullopt; }
+
+    auto value = buffer_[head & (Capacity - 1)];
+    head_.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  // only a snapshot if the other thread is active
+  [[nodiscard]] bool empty() const noexcept
+  {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+private:
+  std::array<Contained, Capacity> buffer_{};
+  alignas(64) std::atomic<std::size_t> head_{ 0 };// NOLINT magic number, cache line size
+  alignas(64) std::atomic<std::size_t> tail_{ 0 };// NOLINT magic number, cache line size
+};
+
+// The inputs the game reacts to. The last three answer the game's menu and popup, they come from
+// their buttons rather than from keys, so they are never queued.
+enum struct Input_Command {
+  Move_North,
+  Move_South,
+  Move_East,
+  Move_West,
+  Show_Log,
+  Toggle_Timings,
+  Toggle_Minimap,
+  Choose_Menu_Item,
+  Dismiss_Popup,
+  Close_Menu
+};
+
+struct Input
+{
+  Input_Command command{};
+  std::chrono::steady_clock::time_point time{};
+};
+
+// Queues timestamped input between the UI event handler and the game loop.
+//
+// Runs of identical commands (held down arrow keys) are handed to the game loop as a single
+// command with a repeat count. Repeats older than `max_repeat_age` are dropped so that a
+// slow frame can't build up a backlog of movement that plays out for seconds afterwards.
+template<std::size_t Capacity = 256> class Basic_Input_Queue
+{
+public:
+  static constexpr auto max_repeat_age = std::chrono::milliseconds{ 500 };
+
+  // returns false if the input had to be dropped because the queue is full
+  bool push(const Input_Command command, const std::chrono::steady_clock::time_point time) noexcept
+  {
+    return queue_.try_push(Input{ command, time });
+  }
+
+  // calls `on_run(Input_Command, std::size_t count)` for each run of identical commands, in order
+  template<typename Function> void drain(const std::chrono::steady_clock::time_point now, Function &&on_run)
+  {
+    std::optional<Input_Command> current;
+    std::size_t count = 0;
+
+    while (const auto input = queue_.try_pop()) {
+      if (current && *current != input->command) {
+        on_run(*current, count);
+        count = 0;
+      }
+
+      current = input->command;
+
+      // the first of each run always counts
+      if (count == 0 || now - input->time <= max_repeat_age) { ++count; }
+    }
+
+    if (current) { on_run(*current, count); }
+  }
+
+private:
+  SPSC_Queue<Input, Capacity> queue_;
+};
+
+using Input_Queue = Basic_Input_Queue<>;
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_INPUT_QUEUE_HPP
@@ -0,0 +1,133 @@
+#include "input_recording.hpp"
+#include "fixed_timestep.hpp"
+
+#include <array>
+#include <bit>
+#include <fmt/format.h>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace lefticus::travels {
+
+namespace {
+  constexpr std::string_view magic{ "TRVLINP\0", 8 };// NOLINT magic numbers
+
+  constexpr auto last_command = Input_Command::Close_Menu;
+
+  void write_fixed(std::ostream &output, std::uint64_t value, const std::size_t bytes)
+  {
+    for (std::size_t byte = 0; byte < bytes; ++byte) {
+      output.put(static_cast<char>(value & 0xFFU));// NOLINT magic numbers
+      value >>= 8U;// NOLINT magic numbers
+    }
+  }
+
+  void write_varint(std::ostream &output, std::uint64_t value)
+  {
+    while (value >= 0x80U) {// NOLINT magic numbers
+      output.put(static_cast<char>((value & 0x7FU) | 0x80U));// NOLINT magic numbers
+      value >>= 7U;// NOLINT magic numbers
+    }
+    output.put(static_cast<char>(value));
+  }
+
+  std::uint8_t read_byte(std::istream &input)
+  {
+    const auto value = input.get();
+    if (value == std::istream::traits_type::eof()) { throw std::runtime_error("Input recording is truncated"); }
+    return static_cast<std::uint8_t>(value);
+  }
+
+  std::uint64_t read_fixed(std::istream &input, const std::size_t bytes)
+  {
+    std::uint64_t value = 0;
+    for (std::size_t byte = 0; byte < bytes; ++byte) {
+      value |= std::uint64_t{ read_byte(input) } << (byte * 8);// NOLINT magic numbers
+    }
+    return value;
+  }
+
+  std::uint64_t read_varint(std::istream &input)
+  {
+    std::uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {// NOLINT magic numbers
+      const auto byte = read_byte(input);
+      value |= std::uint64_t{ byte & 0x7FU } << shift;// NOLINT magic numbers
+      if ((byte & 0x80U) == 0) { return value; }// NOLINT magic numbers
+    }
+    throw std::runtime_error("Input recording has an invalid number");
+  }
+}// namespace
+
+
+void write_input_recording(const Input_Recording &recording, std::ostream &output)
+{
+  output.write(magic.data(), static_cast<std::streamsize>(magic.size()));
+  write_fixed(output, input_recording::version, sizeof(std::uint32_t));
+  write_fixed(output, std::bit_cast<std::uint64_t>(recording.tick_rate), sizeof(std::uint64_t));
+  write_varint(output, recording.ticks);
+  write_varint(output, recording.inputs.size());
+
+  std::uint64_t last_tick = 0;
+  for (const auto &input : recording.inputs) {
+    write_varint(output, input.tick - last_tick);
+    write_varint(output, static_cast<std::uint64_t>(input.command));
+    write_varint(output, input.count);
+    if (input.command == Input_Command::Choose_Menu_Item) { write_varint(output, input.menu_item); }
+    last_tick = input.tick;
+  }
+
+  if (!output.good()) { throw std::runtime_error("Unable to write input recording"); }
+}
+
+Input_Recording read_input_recording(std::istream &input)
+{
+  std::array<char, magic.size()> header{};
+  input.read(header.data(), static_cast<std::streamsize>(header.size()));
+  if (!input.good() || std::string_view{ header.data(), header.size() } != magic) {
+    throw std::runtime_error("Not an input recording");
+  }
+
+  if (const auto version = read_fixed(input, sizeof(std::uint32_t)); version != input_recording::version) {
+    throw std::runtime_error(
+      fmt::format("Input recording is version {}, expected version {}", version, input_recording::version));
+  }
+
+  Input_Recording recording;
+  recording.tick_rate = std::bit_cast<double>(read_fixed(input, sizeof(std::uint64_t)));
+  if (!(recording.tick_rate >= Fixed_Timestep::min_rate && recording.tick_rate <= Fixed_Timestep::max_rate)) {
+    throw std::runtime_error(fmt::format("Input recording has an invalid tick rate: {}", recording.tick_rate));
+  }
+
+  recording.ticks = read_varint(input);
+
+  const auto count = read_varint(input);
+  std::uint64_t tick = 0;
+  for (std::uint64_t index = 0; index < count; ++index) {
+    tick += read_varint(input);
+
+    const auto command = read_varint(input);
+    if (command > static_cast<std::uint64_t>(last_command)) {
+      throw std::runtime_error(fmt::format("Input recording has an unknown command {}", command));
+    }
+
+    auto &recorded = recording.inputs.emplace_back(Input_Recording::Input{ .tick = tick,
+      .command = static_cast<Input_Command>(command),
+      .count = static_cast<std::uint32_t>(read_varint(input)) });
+    if (recorded.command == Input_Command::Choose_Menu_Item) {
+      recorded.menu_item = static_cast<std::uint32_t>(read_varint(input));
+    }
+  }
+
+  return recording;
+}
+
+Input_Recording read_input_recording(const std::filesystem::path &file)
+{
+  std::ifstream input(file, std::ios::binary);
+  if (!input.good()) { throw std::runtime_error(fmt::format("Unable to open input recording '{}'", file.string())); }
+  return read_input_recording(input);
+}
+
+}// namespace lefticus::travels
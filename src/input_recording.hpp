@@ -0,0 +1,50 @@
+#ifndef AWESOME_GAME_INPUT_RECORDING_HPP
+#define AWESOME_GAME_INPUT_RECORDING_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "input_queue.hpp"
+
+namespace lefticus::travels {
+
+// The input of a play session, by the simulation tick it was run on. That includes the menu items
+// chosen and the popups and menus dismissed, they are recorded on the last tick run before them.
+//
+// Game time only depends on the tick, so running the same game with the same input on the same
+// ticks reproduces the session exactly, however fast or slow the replay runs.
+struct Input_Recording
+{
+  struct Input
+  {
+    std::uint64_t tick = 0;// as counted by Fixed_Timestep::ticks, the first tick is 1
+    Input_Command command{};
+    std::uint32_t count = 1;// repeats, as handed out by Input_Queue::drain
+    std::uint32_t menu_item = 0;// for Choose_Menu_Item, the index of the item in `Menu::items`
+  };
+
+  double tick_rate = 60;// NOLINT magic number
+  std::uint64_t ticks = 0;// length of the session
+  std::vector<Input> inputs;// in order
+};
+
+// Layout: magic "TRVLINP\0", version and the tick rate as little endian 32 and 64 bit fields,
+// then the tick count, the input count and for each input the ticks since the previous input,
+// the command, the count and for Choose_Menu_Item the menu item, all as LEB128 varints. A typical
+// input is 3 bytes.
+namespace input_recording {
+  inline constexpr std::uint32_t version = 2;
+}// namespace input_recording
+
+void write_input_recording(const Input_Recording &recording, std::ostream &output);
+
+// throws std::runtime_error if `input` is not a complete recording of the current version
+Input_Recording read_input_recording(std::istream &input);
+Input_Recording read_input_recording(const std::filesystem::path &file);
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_INPUT_RECORDING_HPP
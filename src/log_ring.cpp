@@ -0,0 +1,121 @@
+#include "log_ring.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace lefticus::travels {
+
+namespace {
+  template<std::size_t Words>
+  std::uint32_t pack(std::array<std::atomic<std::uint64_t>, Words> &words, const std::string_view text) noexcept
+  {
+    const auto length = std::min(text.size(), Words * 8);
+
+    for (std::size_t word = 0; word < Words && word * 8 < length; ++word) {
+      std::uint64_t value = 0;
+      for (std::size_t byte = 0; byte < 8 && word * 8 + byte < length; ++byte) {// NOLINT magic numbers
+        value |= std::uint64_t{ static_cast<unsigned char>(text[word * 8 + byte]) } << (byte * 8);// NOLINT
+      }
+      words[word].store(value, std::memory_order_relaxed);
+    }
+
+    return static_cast<std::uint32_t>(length);
+  }
+
+  template<std::size_t Words>
+  std::string unpack(const std::array<std::atomic<std::uint64_t>, Words> &words, std::size_t length)
+  {
+    // a record that is being overwritten can have any length
+    length = std::min(length, Words * 8);
+
+    std::string result;
+    result.reserve(length);
+
+    for (std::size_t word = 0; word < Words && word * 8 < length; ++word) {
+      const auto value = words[word].load(std::memory_order_relaxed);
+      for (std::size_t byte = 0; byte < 8 && word * 8 + byte < length; ++byte) {// NOLINT magic numbers
+        result.push_back(static_cast<char>((value >> (byte * 8)) & 0xFFU));// NOLINT magic numbers
+      }
+    }
+
+    return result;
+  }
+}// namespace
+
+
+Log_Ring::Log_Ring(const std::size_t capacity)
+  : capacity_{ capacity }, slots_{ std::make_unique<Slot[]>(capacity) }// NOLINT arrays of atomics
+{
+  if (capacity == 0) { throw std::invalid_argument("Log_Ring needs room for at least one record"); }
+}
+
+void Log_Ring::push(const std::chrono::system_clock::time_point time,
+  const int level,
+  const std::size_t thread_id,
+  const std::string_view logger_name,
+  const std::string_view payload) noexcept
+{
+  const auto ticket = next_.fetch_add(1, std::memory_order_relaxed);
+  auto &slot = slots_[ticket % capacity_];
+  const auto lap = ticket / capacity_;
+
+  // the writer of the previous lap has to be done with the slot, only ever a wait if the ring
+  // wrapped all the way around while it was writing
+  auto expected = 2 * lap;
+  while (!slot.sequence.compare_exchange_weak(
+    expected, 2 * lap + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+    expected = 2 * lap;
+    std::this_thread::yield();
+  }
+  // the odd sequence number has to be visible before any of the new contents are
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot.time.store(time.time_since_epoch().count(), std::memory_order_relaxed);
+  slot.level.store(level, std::memory_order_relaxed);
+  slot.thread_id.store(thread_id, std::memory_order_relaxed);
+  slot.logger_name_length.store(pack(slot.logger_name, logger_name), std::memory_order_relaxed);
+  slot.payload_length.store(pack(slot.payload, payload), std::memory_order_relaxed);
+
+  slot.sequence.store(2 * lap + 2, std::memory_order_release);
+}
+
+std::vector<Log_Ring::Entry> Log_Ring::newest(const std::size_t skip, const std::size_t count) const
+{
+  const auto total = next_.load(std::memory_order_acquire);
+  const auto available = std::min<std::uint64_t>(total, capacity_);
+
+  std::vector<Entry> result;
+  if (skip >= available) { return result; }
+  result.reserve(std::min<std::uint64_t>(count, available - skip));
+
+  for (std::uint64_t back = skip; back < available && result.size() < count; ++back) {
+    const auto ticket = total - 1 - back;
+    const auto &slot = slots_[ticket % capacity_];
+    const auto published = 2 * (ticket / capacity_) + 2;
+
+    // not finished yet, or already overwritten by a newer record
+    if (slot.sequence.load(std::memory_order_acquire) != published) { continue; }
+
+    Entry entry{ .time = std::chrono::system_clock::time_point{ std::chrono::system_clock::duration{
+                   slot.time.load(std::memory_order_relaxed) } },
+      .level = slot.level.load(std::memory_order_relaxed),
+      .thread_id = slot.thread_id.load(std::memory_order_relaxed),
+      .logger_name = unpack(slot.logger_name, slot.logger_name_length.load(std::memory_order_relaxed)),
+      .payload = unpack(slot.payload, slot.payload_length.load(std::memory_order_relaxed)) };
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != published) { continue; }
+
+    result.push_back(std::move(entry));
+  }
+
+  return result;
+}
+
+std::size_t Log_Ring::size() const noexcept
+{
+  return static_cast<std::size_t>(std::min<std::uint64_t>(next_.load(std::memory_order_acquire), capacity_));
+}
+
+}// namespace lefticus::travels
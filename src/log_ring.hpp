@@ -0,0 +1,85 @@
+#ifndef AWESOME_GAME_LOG_RING_HPP
+#define AWESOME_GAME_LOG_RING_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lefticus::travels {
+
+// The most recent `capacity` log records, kept raw so that only the ones someone looks at are
+// ever formatted. Older records are overwritten.
+//
+// Appending never takes a lock: a writer claims the next slot with one atomic increment and
+// publishes the record through the slot's sequence number. It only has to wait if the ring has
+// wrapped all the way around onto a slot that another writer is still filling. Readers copy a
+// record and check its sequence number again afterwards, records overwritten in the meantime
+// are left out.
+//
+// Messages longer than `max_payload` bytes and logger names longer than `max_logger_name` bytes
+// are cut off.
+class Log_Ring
+{
+public:
+  static constexpr std::size_t max_payload = 192;
+  static constexpr std::size_t max_logger_name = 16;
+
+  explicit Log_Ring(std::size_t capacity);
+
+  struct Entry
+  {
+    std::chrono::system_clock::time_point time;
+    int level = 0;
+    std::size_t thread_id = 0;
+    std::string logger_name;
+    std::string payload;
+  };
+
+  void push(std::chrono::system_clock::time_point time,
+    int level,
+    std::size_t thread_id,
+    std::string_view logger_name,
+    std::string_view payload) noexcept;
+
+  // Up to `count` records, newest first, starting `skip` records back from the newest.
+  [[nodiscard]] std::vector<Entry> newest(std::size_t skip, std::size_t count) const;
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
+
+  // records that can still be read
+  [[nodiscard]] std::size_t size() const noexcept;
+
+  // records ever pushed
+  [[nodiscard]] std::uint64_t total() const noexcept { return next_.load(std::memory_order_acquire); }
+
+private:
+  // everything in a slot is atomic, so reading one while it is being overwritten is only a
+  // wasted copy, not a data race
+  template<std::size_t Bytes> using Packed_String = std::array<std::atomic<std::uint64_t>, (Bytes + 7) / 8>;
+
+  struct Slot
+  {
+    // 2 * the number of records written to this slot, odd while one is being written
+    std::atomic<std::uint64_t> sequence{ 0 };
+    std::atomic<std::int64_t> time{ 0 };// system_clock ticks
+    std::atomic<int> level{ 0 };
+    std::atomic<std::size_t> thread_id{ 0 };
+    std::atomic<std::uint32_t> logger_name_length{ 0 };
+    std::atomic<std::uint32_t> payload_length{ 0 };
+    Packed_String<max_logger_name> logger_name{};
+    Packed_String<max_payload> payload{};
+  };
+
+  std::size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;// NOLINT arrays of atomics can't go in a vector
+  std::atomic<std::uint64_t> next_{ 0 };
+};
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_LOG_RING_HPP
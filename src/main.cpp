@@ -1,12 +1,15 @@
 #include <array>
 #include <filesystem>
+#include <fstream>
 #include <functional>
 #include <iostream>
+#include <utility>
 
 #include <CLI/CLI.hpp>
 #include <ftxui/component/component.hpp>// for Slider
 #include <ftxui/component/screen_interactive.hpp>// for ScreenInteractive
 
+#include <spdlog/details/null_mutex.h>
 #include <spdlog/sinks/base_sink.h>
 
 #include <spdlog/spdlog.h>
@@ -14,13 +17,24 @@
 
 #include "bitmap.hpp"
 #include "color.hpp"
+#include "fixed_timestep.hpp"
+#include "frame_timings.hpp"
 #include "game.hpp"
 #include "game_components.hpp"
+#include "game_loop.hpp"
+#include "headless.hpp"
 #include "game_hacking_lesson_00.hpp"
 #include "game_hacking_lesson_01.hpp"
 #include "game_hacking_lesson_02.hpp"
+#include "input_queue.hpp"
+#include "input_recording.hpp"
+#include "log_ring.hpp"
+#include "minimap.hpp"
+#include "palette.hpp"
 #include "point.hpp"
 #include "size.hpp"
+#include "thread_pool.hpp"
+#include "viewport.hpp"
 
 // This file will be generated automatically when you run the CMake
 // configuration step. It creates a namespace called `travels`. You can modify
@@ -31,61 +45,6 @@
 namespace lefticus::travels {
 
 
-void draw(Bitmap &viewport, Point map_center, const Game &game, const Game_Map &map)
-{
-  const auto num_wide = viewport.pixels.size().width / game.tile_size.width;
-  const auto num_high = viewport.pixels.size().height / game.tile_size.height;
-
-  const auto x_offset = num_wide / 2;
-  const auto y_offset = num_high / 2;
-
-  const auto min_x = x_offset;
-  const auto min_y = y_offset;
-
-  const auto max_x = map.locations.size().width - x_offset - (num_wide % 2);
-  const auto max_y = map.locations.size().height - y_offset - (num_high % 2);
-
-  const auto center_map_location =
-    Point{ std::clamp(map_center.x, min_x, max_x), std::clamp(map_center.y, min_y, max_y) };
-
-  const auto upper_left_map_location = center_map_location - Point{ min_x, min_y };
-
-  for (std::size_t cur_x = 0; cur_x < num_wide; ++cur_x) {
-    for (std::size_t cur_y = 0; cur_y < num_high; ++cur_y) {
-      auto span = Vector2D_Span<Color>(
-        Point{ cur_x * game.tile_size.width, cur_y * game.tile_size.width }, game.tile_size, viewport.pixels);
-      const auto map_location = Point{ cur_x, cur_y } + upper_left_map_location;
-      map.locations.at(map_location).draw(span, game, map_location, Layer::Background);
-    }
-  }
-
-  const auto character_relative_location = game.player.map_location - upper_left_map_location;
-
-  const auto character_location = Point{ character_relative_location.x * game.tile_size.width,
-    character_relative_location.y * game.tile_size.height };
-
-  auto character_span = Vector2D_Span<Color>(character_location, game.tile_size, viewport.pixels);
-
-  game.player.draw(character_span, game, game.player.map_location);
-
-
-  for (std::size_t cur_x = 0; cur_x < num_wide; ++cur_x) {
-    for (std::size_t cur_y = 0; cur_y < num_high; ++cur_y) {
-      auto span = Vector2D_Span<Color>(
-        Point{ cur_x * game.tile_size.width, cur_y * game.tile_size.width }, game.tile_size, viewport.pixels);
-      const auto map_location = Point{ cur_x, cur_y } + upper_left_map_location;
-      map.locations.at(map_location).draw(span, game, map_location, Layer::Foreground);
-    }
-  }
-}
-
-void draw(Bitmap &viewport, const Game &game)
-{
-  if (game.maps.contains(game.current_map)) {
-    draw(viewport, game.player.map_location, game, game.maps.at(game.current_map));
-  }
-}
-
 ftxui::ButtonOption Animated(ftxui::Color background,// NOLINT
   ftxui::Color foreground,// NOLINT
   ftxui::Color background_active,// NOLINT
@@ -111,14 +70,17 @@ ftxui::ButtonOption Animated()
 }
 struct Displayed_Menu
 {
-  Displayed_Menu(Menu menu_, Game &game) : menu{ std::move(menu_) }
+  // `choose` is called with the index of the item whose button was pressed
+  Displayed_Menu(Menu menu_, const Game &game, const std::function<void(std::uint32_t)> &choose)
+    : menu{ std::move(menu_) }
   {
     ftxui::Components menu_lines;
 
-    for (const auto &item : menu.items) {
+    for (std::size_t index = 0; index < menu.items.size(); ++index) {
+      const auto &item = menu.items[index];
       if (!item.visible || item.visible(game)) {
         menu_lines.push_back(ftxui::Button(
-          item.text, [&game, &item]() { item.action(game); }, Animated()));
+          item.text, [choose, index]() { choose(static_cast<std::uint32_t>(index)); }, Animated()));
       }
     }
 
@@ -130,21 +92,54 @@ struct Displayed_Menu
 };
 
 
+// Keeps the most recent messages in a Log_Ring, which doesn't need a lock to append to, so this
+// is meant to be used with spdlog's null_mutex. Messages are only formatted when they're shown.
 template<typename Mutex> class log_sink : public spdlog::sinks::base_sink<Mutex>
 {
 public:
-  log_sink() = default;
-  std::vector<std::string> event_log;
+  static constexpr std::size_t default_capacity = 4096;
+
+  explicit log_sink(const std::size_t capacity = default_capacity) : records_{ capacity } {}
+
+  [[nodiscard]] std::size_t size() const noexcept { return records_.size(); }
+
+  // Up to `count` formatted messages, newest first, starting `skip` messages back from the newest.
+  // Only call this from one thread, formatters aren't thread safe.
+  [[nodiscard]] std::vector<std::string> lines(const std::size_t skip, const std::size_t count)
+  {
+    std::vector<std::string> result;
+    for (const auto &entry : records_.newest(skip, count)) {
+      spdlog::details::log_msg msg{ entry.time,
+        spdlog::source_loc{},
+        entry.logger_name,
+        static_cast<spdlog::level::level_enum>(entry.level),
+        entry.payload };
+      msg.thread_id = entry.thread_id;
+
+      spdlog::memory_buf_t formatted;
+      spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted);
+
+      auto line = fmt::to_string(formatted);
+      while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) { line.pop_back(); }
+      result.push_back(std::move(line));
+    }
+    return result;
+  }
 
 protected:
   void sink_it_(const spdlog::details::log_msg &msg) override
   {
-    spdlog::memory_buf_t formatted;
-    spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted);
-    event_log.insert(event_log.begin(), fmt::to_string(formatted));
+    records_.push(msg.time,
+      static_cast<int>(msg.level),
+      msg.thread_id,
+      std::string_view{ msg.logger_name.data(), msg.logger_name.size() },
+      std::string_view{ msg.payload.data(), msg.payload.size() });
   }
 
   void flush_() override {}
+
+private:
+  Log_Ring records_;
 };
 
 
@@ -178,26 +173,117 @@ ftxui::Component CatchEvent(ftxui::Component child, std::function<bool(ftxui::Ev
   return out;
 }
 
+// Records how long FTXUI takes to render an element (and its children) into the screen
+class Timed_Render : public ftxui::Node
+{
+public:
+  Timed_Render(ftxui::Element child, Timing_Histogram &histogram)
+    : ftxui::Node({ std::move(child) }), histogram_{ histogram }
+  {}
 
-void play_game(Game &game, std::shared_ptr<log_sink<std::mutex>> log_sink)// NOLINT cognitive complexity
+  void ComputeRequirement() override
+  {
+    ftxui::Node::ComputeRequirement();
+    requirement_ = children_.front()->requirement();
+  }
+
+  void SetBox(ftxui::Box box) override
+  {
+    ftxui::Node::SetBox(box);
+    children_.front()->SetBox(box);
+  }
+
+  void Render(ftxui::Screen &screen) override
+  {
+    const Scoped_Timer timer{ histogram_ };
+    ftxui::Node::Render(screen);
+  }
+
+private:
+  Timing_Histogram &histogram_;
+};
+
+
+struct Play_Options
+{
+  // simulation ticks per second, `Game::clock` advances by exactly 1/tick_rate per tick
+  double tick_rate = 60;// NOLINT magic number
+  // frames drawn per second
+  double render_rate = 30;// NOLINT magic number
+  // if not empty, where to write the frame timing statistics on exit
+  std::filesystem::path timings_file;
+  // if not empty, where to write the input of the session on exit, for `--replay-input`
+  std::filesystem::path record_input_file;
+  // threads helping the main thread draw the map, 0 to draw it on the main thread only
+  std::size_t draw_threads = Thread_Pool::default_thread_count() - 1;
+  // the colors the terminal supports, detected at startup if not set
+  std::optional<Color_Depth> color_depth;
+  // dither the palette colors, if the terminal doesn't support true color
+  bool dither = false;
+};
+
+void play_game(Game &game,// NOLINT cognitive complexity
+  std::shared_ptr<log_sink<spdlog::details::null_mutex>> log_sink,
+  const Play_Options &options)
 {
 
-  Displayed_Menu current_menu{ Menu{}, game };
   bool show_log = false;
+  std::size_t log_scroll = 0;// messages back from the newest
+  bool show_timings = false;
+  bool show_minimap = false;
 
-  auto clear_popup_button = ftxui::Button("OK", [&]() { game.popup_message.clear(); });
   auto close_log = ftxui::Button("Close", [&] { show_log = false; });
 
   // this should probably have a `bitmap` helper function that does what you expect
   // similar to the other parts of FTXUI
   auto bm = std::make_shared<Bitmap>(Size{ 64, 40 });// NOLINT magic numbers
-  auto small_bm = std::make_shared<Bitmap>(Size{ 6, 6 });// NOLINT magic numbers
+  auto small_bm = std::make_shared<Bitmap>(Size{ 64, 40 });// NOLINT magic numbers
+
+  if (const auto depth = options.color_depth.value_or(detect_color_depth()); depth != Color_Depth::True_Color) {
+    spdlog::info("Drawing with the {} color palette", depth == Color_Depth::Palette_256 ? 256 : 16);// NOLINT
+    bm->palette.emplace(depth, options.dither);
+    small_bm->palette.emplace(depth, options.dither);
+  }
+
+  // a pool that the viewport is too small to hand work to would only cost threads
+  const auto draw_threads = std::min(options.draw_threads, max_draw_bands(bm->pixels.size(), game.tile_size) - 1);
+  std::optional<Thread_Pool> draw_pool;
+  if (draw_threads > 0) { draw_pool.emplace(draw_threads); }
+
+  Viewport_Tracker viewport_tracker;
+  viewport_tracker.pool = draw_pool ? &*draw_pool : nullptr;
+  Minimap_Tracker minimap_tracker;
+  Frame_Timings timings;
 
   double fps = 0;
   auto start_time = std::chrono::steady_clock::now();
 
-  std::vector<ftxui::Event> events;
+  const auto seconds_to_duration = [](const double seconds) {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+  };
+
+  // if the game falls further behind than this, the simulation slows down instead
+  static constexpr std::size_t max_catch_up_ticks = 10;
+
+  Fixed_Timestep simulation{
+    seconds_to_duration(1.0 / options.tick_rate), max_catch_up_ticks, start_time, timings.tick_jitter
+  };
 
+  Input_Queue input_queue;
+  Input_Recording recording{ .tick_rate = options.tick_rate, .ticks = 0, .inputs = {} };
+
+  // menus and popups are answered right away, between ticks, and recorded on the last tick run
+  const auto answer_dialog = [&](const Input_Command command, const std::uint32_t menu_item) {
+    recording.inputs.push_back(
+      Input_Recording::Input{ .tick = simulation.ticks(), .command = command, .count = 1, .menu_item = menu_item });
+    answer(game, command, menu_item);
+  };
+  const auto choose_menu_item = [answer_dialog](const std::uint32_t menu_item) {
+    answer_dialog(Input_Command::Choose_Menu_Item, menu_item);
+  };
+
+  Displayed_Menu current_menu{ Menu{}, game, choose_menu_item };
+  auto clear_popup_button = ftxui::Button("OK", [answer_dialog]() { answer_dialog(Input_Command::Dismiss_Popup, 0); });
 
   // to do, add total game time clock also, not just current elapsed time
   auto game_iteration = [&](const std::chrono::steady_clock::duration elapsed_time) {
@@ -208,57 +294,37 @@ void play_game(Game &game, std::shared_ptr<log_sink<std::mutex>> log_sink)// NOL
           / (static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed_time).count())
              / 1'000'000.0);// NOLINT magic numbers
 
-    const auto game_clock =
-      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time);
-
-    game.clock = game_clock;
-
-    while (!events.empty()) {
-      const auto current_event = events.front();
-      events.erase(events.begin());
-
-      [&] {
-        auto location = game.player.map_location;
-        const auto last_location = location;
-
-        Direction from{};
-
-        if (current_event.is_character() && current_event.character() == "l") {
-          show_log = true;
-          return;
-        } else if (current_event == ftxui::Event::ArrowUp) {
-          --location.y;
-          from = Direction::South;
-        } else if (current_event == ftxui::Event::ArrowDown) {
-          ++location.y;
-          from = Direction::North;
-        } else if (current_event == ftxui::Event::ArrowLeft) {
-          --location.x;
-          from = Direction::East;
-        } else if (current_event == ftxui::Event::ArrowRight) {
-          ++location.x;
-          from = Direction::West;
-        } else {
-          return;
-        }
-
-
-        if (game.maps.at(game.current_map).can_enter_from(game, location, from)) {
-          auto exit_action = game.maps.at(game.current_map).locations.at(last_location).exit_action;
-          if (exit_action) { exit_action(game, last_location, from); }
-
-          game.player.map_location = location;
-
-          spdlog::trace("Moved to: {}, {}", location.x, location.y);
-
-          auto enter_action = game.maps.at(game.current_map).locations.at(location).enter_action;
-          if (enter_action) { enter_action(game, location, from); }
-        }
-      }();
+    {
+      const Scoped_Timer events_timer{ timings.events };
+      simulation.update(std::chrono::steady_clock::now(), [&] {
+        game.clock = std::chrono::duration_cast<std::chrono::milliseconds>(simulation.simulated_time());
+
+        input_queue.drain(std::chrono::steady_clock::now(), [&](const Input_Command command, const std::size_t count) {
+          recording.inputs.push_back(Input_Recording::Input{
+            .tick = simulation.ticks(), .command = command, .count = static_cast<std::uint32_t>(count) });
+
+          if (command == Input_Command::Show_Log) {
+            show_log = true;
+            log_scroll = 0;
+          } else if (command == Input_Command::Toggle_Timings) {
+            if (count % 2 == 1) { show_timings = !show_timings; }
+          } else if (command == Input_Command::Toggle_Minimap) {
+            if (count % 2 == 1) { show_minimap = !show_minimap; }
+          } else {
+            // held down arrow keys arrive as one run, stop at the first step that is blocked
+            for (std::size_t step = 0; step < count; ++step) {
+              if (!move_player(game, command)) { break; }
+            }
+          }
+        });
+      });
     }
 
-
-    draw(*bm, game);
+    {
+      const Scoped_Timer draw_timer{ timings.draw };
+      draw(*bm, game, viewport_tracker);
+      if (show_minimap) { draw_minimap(*small_bm, game, minimap_tracker); }
+    }
   };
 
   auto screen = ftxui::ScreenInteractive::TerminalOutput();
@@ -270,7 +336,21 @@ void play_game(Game &game, std::shared_ptr<log_sink<std::mutex>> log_sink)// NOL
   auto container = ftxui::Container::Vertical({});
 
   auto key_press = lefticus::travels::CatchEvent(container, [&](const ftxui::Event &event) {
-    events.push_back(event);
+    const auto command = [&]() -> std::optional<Input_Command> {
+      if (event == ftxui::Event::ArrowUp) { return Input_Command::Move_North; }
+      if (event == ftxui::Event::ArrowDown) { return Input_Command::Move_South; }
+      if (event == ftxui::Event::ArrowLeft) { return Input_Command::Move_West; }
+      if (event == ftxui::Event::ArrowRight) { return Input_Command::Move_East; }
+      if (event.is_character() && event.character() == "l") { return Input_Command::Show_Log; }
+      if (event.is_character() && event.character() == "p") { return Input_Command::Toggle_Timings; }
+      if (event.is_character() && event.character() == "m") { return Input_Command::Toggle_Minimap; }
+      return std::nullopt;
+    }();
+
+    if (command && !input_queue.push(*command, std::chrono::steady_clock::now())) {
+      spdlog::warn("Input queue full, dropping input");
+    }
+
     return false;
   });
 
@@ -296,23 +376,46 @@ void play_game(Game &game, std::shared_ptr<log_sink<std::mutex>> log_sink)// NOL
       spdlog::critical(message);
     }
 
+    timings.frame.add(new_time - last_time);
     last_time = new_time;
 
+    const Scoped_Timer layout_timer{ timings.layout };
 
     ftxui::Elements text_components;
     text_components.push_back(ftxui::text("Frame: " + std::to_string(counter)));
+    text_components.push_back(ftxui::text(fmt::format("Tiles drawn: {}", viewport_tracker.tiles_drawn)));
+    text_components.push_back(ftxui::text(fmt::format("Cells updated: {}", bm->cells_updated)));
+    if (game.maps.contains(game.current_map)) {
+      const auto &chunk_stats = game.get_current_map().tiles.stats();
+      text_components.push_back(ftxui::text(
+        fmt::format("Chunks: {} ({} evicted)", chunk_stats.resident_chunks, chunk_stats.evictions)));
+    }
     text_components.push_back(
       ftxui::text(fmt::format("Location: {{{},{}}}", game.player.map_location.x, game.player.map_location.y)));
 
+    // read only, a non const lookup would count as a change to the variable
+    const auto &variables = std::as_const(game).variables;
     for (const auto &variable : game.display_variables) {
-      if (game.variables.contains(variable)) {
-        text_components.push_back(ftxui::text(fmt::format("{}: {}", variable, to_string(game.variables.at(variable)))));
+      if (const auto *value = variables.find(variable); value != nullptr) {
+        text_components.push_back(ftxui::text(fmt::format("{}: {}", variable, to_string(*value))));
       }
     }
 
+    ftxui::Elements hud{ bm | ftxui::border };
+    if (show_minimap) { hud.push_back(small_bm | ftxui::border); }
+    hud.push_back(ftxui::vbox(std::move(text_components)) | ftxui::border);
+
+    if (show_timings) {
+      ftxui::Elements timing_lines;
+      timing_lines.push_back(ftxui::text(fmt::format("FPS: {:.1f}", fps)));
+      timing_lines.push_back(
+        ftxui::text(fmt::format("Ticks: {} ({} dropped)", simulation.ticks(), simulation.dropped_ticks())));
+      for (auto &line : timings.summary_lines()) { timing_lines.push_back(ftxui::text(std::move(line))); }
+      hud.push_back(ftxui::vbox(std::move(timing_lines)) | ftxui::border);
+    }
+
     // now actually draw the game elements
-    return ftxui::vbox({ ftxui::hbox({ bm | ftxui::border, ftxui::vbox(std::move(text_components)) | ftxui::border }),
-      ftxui::text("Message: " + game.last_message) | ftxui::border });
+    return ftxui::vbox({ ftxui::hbox(std::move(hud)), ftxui::text("Message: " + game.last_message) | ftxui::border });
   };
 
 
@@ -349,14 +452,44 @@ void play_game(Game &game, std::shared_ptr<log_sink<std::mutex>> log_sink)// NOL
     return ftxui::vbox(paragraphs) | ftxui::border;
   });
 
-  int selected_log_entry = 0;
-  auto log_menu = ftxui::Menu(&log_sink->event_log, &selected_log_entry);
+  // only the messages in view are formatted, however long the log is
+  static constexpr std::size_t log_rows = 15;
+
+  auto log_view = lefticus::travels::CatchEvent(ftxui::Renderer([&](const bool focused) {
+    const auto lines = log_sink->lines(log_scroll, log_rows);
+
+    ftxui::Elements rows;
+    for (const auto &line : lines) { rows.push_back(ftxui::text(line)); }
+    if (!rows.empty() && focused) { rows.front() = rows.front() | ftxui::inverted; }
+
+    const auto last = std::min(log_scroll + lines.size(), log_sink->size());
+    rows.push_back(ftxui::separator());
+    rows.push_back(ftxui::text(fmt::format("{}-{} of {}, newest first", log_scroll + 1, last, log_sink->size())));
+    return ftxui::vbox(std::move(rows));
+  }),
+    [&](const ftxui::Event &event) {
+      const auto last_scroll = log_sink->size() > 0 ? log_sink->size() - 1 : 0;
+      // at either end the arrows move the focus instead, so Close can be reached from the keyboard
+      if (event == ftxui::Event::ArrowUp) {
+        if (log_scroll == 0) { return false; }
+        --log_scroll;
+      } else if (event == ftxui::Event::ArrowDown) {
+        if (log_scroll >= last_scroll) { return false; }
+        ++log_scroll;
+      } else if (event == ftxui::Event::PageUp) {
+        log_scroll -= std::min(log_scroll, log_rows);
+      } else if (event == ftxui::Event::PageDown) {
+        log_scroll = std::min(log_scroll + log_rows, last_scroll);
+      } else if (event == ftxui::Event::Home) {
+        log_scroll = 0;
+      } else {
+        return false;
+      }
+      return true;
+    });
 
-  auto log_renderer = ftxui::Renderer(ftxui::Container::Vertical({ log_menu, close_log }), [&] {
-    return ftxui::vbox({ log_menu->Render() | ftxui::vscroll_indicator | ftxui::frame
-                           | ftxui::size(ftxui::HEIGHT, ftxui::LESS_THAN, 15),// NOLINT magic numbers
-             close_log->Render() })
-           | ftxui::border;
+  auto log_renderer = ftxui::Renderer(ftxui::Container::Vertical({ log_view, close_log }), [&] {
+    return ftxui::vbox({ log_view->Render(), close_log->Render() }) | ftxui::border;
   });
 
   int depth = 0;
@@ -375,7 +508,7 @@ void play_game(Game &game, std::shared_ptr<log_sink<std::mutex>> log_sink)// NOL
     }
 
     if (game.has_new_menu()) {
-      current_menu = Displayed_Menu{ game.get_menu(), game };
+      current_menu = Displayed_Menu{ game.get_menu(), game, choose_menu_item };
       menu_renderer->DetachAllChildren();
       menu_renderer->Add(current_menu.buttons);
     }
@@ -398,19 +531,26 @@ void play_game(Game &game, std::shared_ptr<log_sink<std::mutex>> log_sink)// NOL
       document = ftxui::dbox({ document, log_renderer->Render() | ftxui::clear_under | ftxui::center });
     }
 
-    return document;
+    return std::make_shared<Timed_Render>(std::move(document), timings.render);
   });
 
 
   std::atomic<bool> refresh_ui_continue = true;
 
   // This thread exists to make sure that the event queue has an event to
-  // process at approximately a rate of 30 FPS
+  // process at `options.render_rate` frames per second. The simulation catches
+  // up on however many ticks are due each time a frame is drawn.
   std::thread refresh_ui([&] {
+    const auto frame_length = seconds_to_duration(1.0 / options.render_rate);
+    auto next_frame = std::chrono::steady_clock::now() + frame_length;
+
     while (refresh_ui_continue) {
-      using namespace std::chrono_literals;
-      std::this_thread::sleep_for(1.0s / 30.0);// NOLINT magic numbers
+      std::this_thread::sleep_until(next_frame);
       screen.PostEvent(ftxui::Event::Custom);
+
+      next_frame += frame_length;
+      // don't try to make up for frames that were missed
+      if (const auto now = std::chrono::steady_clock::now(); next_frame < now) { next_frame = now + frame_length; }
     }
   });
 
@@ -418,6 +558,23 @@ void play_game(Game &game, std::shared_ptr<log_sink<std::mutex>> log_sink)// NOL
 
   refresh_ui_continue = false;
   refresh_ui.join();
+
+  if (!options.timings_file.empty()) {
+    std::ofstream output(options.timings_file);
+    for (const auto &line : timings.summary_lines()) { output << line << '\n'; }
+    if (!output.good()) { spdlog::error("Unable to write frame timings to '{}'", options.timings_file.string()); }
+  }
+
+  if (!options.record_input_file.empty()) {
+    recording.ticks = simulation.ticks();
+    try {
+      std::ofstream output(options.record_input_file, std::ios::binary);
+      write_input_recording(recording, output);
+    } catch (const std::exception &exception) {
+      spdlog::error(
+        "Unable to write input recording to '{}': {}", options.record_input_file.string(), exception.what());
+    }
+  }
 }
 }// namespace lefticus::travels
 
@@ -448,6 +605,50 @@ int main(int argc, const char **argv)
     bool show_version = false;
     app.add_flag("--version", show_version, "Show version information");
 
+    std::string timings_file;
+    app.add_option("--frame-timings", timings_file, "Write per stage frame timing statistics to this file on exit");
+
+    lefticus::travels::Play_Options play_options;
+    using lefticus::travels::Fixed_Timestep;
+    app.add_option("--tick-rate", play_options.tick_rate, "Simulation ticks per second")
+      ->check(CLI::Range(Fixed_Timestep::min_rate, Fixed_Timestep::max_rate));
+    app.add_option("--render-rate", play_options.render_rate, "Frames drawn per second")
+      ->check(CLI::Range(Fixed_Timestep::min_rate, Fixed_Timestep::max_rate));
+    std::string colors = "auto";
+    app.add_option("--colors", colors, "The colors the terminal supports: auto, truecolor, 256 or 16")
+      ->check(CLI::IsMember({ "auto", "truecolor", "256", "16" }));
+    app.add_flag("--dither", play_options.dither, "Dither colors on terminals without true color");
+
+    app.add_option("--draw-threads",
+      play_options.draw_threads,
+      "Threads helping to draw the map, in addition to the main thread, 0 to draw on the main thread only");
+
+    std::size_t map_memory_budget =
+      lefticus::travels::Map_Chunks::default_memory_budget / (1024 * 1024);// NOLINT magic numbers
+    app.add_option("--map-memory-budget", map_memory_budget, "Memory for the loaded parts of each map, in MiB")
+      ->check(CLI::PositiveNumber);
+
+    std::size_t headless_frames = 0;
+    app.add_option("--headless",
+      headless_frames,
+      "Run this many frames without a terminal as fast as possible, then print the frame rate, frame timings and a "
+      "hash of each frame");
+
+    std::string input_script;
+    app.add_option("--input-script",
+      input_script,
+      "Input for --headless, one character per frame: n, s, e, w to move, '.' for no input");
+
+    std::string record_input_file;
+    app.add_option("--record-input", record_input_file, "Record the input of the game to this file, for --replay-input");
+
+    std::string replay_input_file;
+    app.add_option("--replay-input",
+      replay_input_file,
+      "Replay input recorded with --record-input without a terminal as fast as possible, like --headless")
+      ->check(CLI::ExistingFile)
+      ->excludes("--headless");
+
     CLI11_PARSE(app, argc, argv);
 
     if (show_version) {
@@ -463,13 +664,57 @@ int main(int argc, const char **argv)
     // and uncomment this line
     // auto game = lefticus::travels::hacking::lesson_02::make_lesson();
 
+    for (auto &[name, map] : game.maps) {
+      map.tiles.set_memory_budget(map_memory_budget * 1024 * 1024);// NOLINT magic numbers
+    }
+
+    if (headless_frames > 0 || !replay_input_file.empty()) {
+      spdlog::set_level(spdlog::level::warn);
+
+      lefticus::travels::Headless_Options headless_options{ .frames = headless_frames,
+        .tick_rate = play_options.tick_rate,
+        .render_rate = play_options.render_rate,
+        .input = lefticus::travels::parse_input_script(input_script),
+        .draw_threads = play_options.draw_threads };
+
+      if (!replay_input_file.empty()) {
+        headless_options.replay = lefticus::travels::read_input_recording(std::filesystem::path{ replay_input_file });
+      }
+
+      const auto report = lefticus::travels::run_headless(game, headless_options);
+
+      for (const auto &line : report.summary_lines()) { fmt::print("{}\n", line); }
+
+      fmt::print("\n{:>6} {:>10} {:>10} {:>8} {:>16}\n", "frame", "sim ms", "draw ms", "bytes", "hash");
+      for (std::size_t frame = 0; frame < report.frames.size(); ++frame) {
+        const auto &result = report.frames[frame];
+        fmt::print("{:>6} {:>10.3f} {:>10.3f} {:>8} {:016x}\n",
+          frame,
+          std::chrono::duration<double, std::milli>(result.simulation).count(),
+          std::chrono::duration<double, std::milli>(result.draw).count(),
+          result.encoded_bytes,
+          result.hash);
+      }
+
+      return EXIT_SUCCESS;
+    }
+
     // we want to take over as the main spdlog sink
-    auto log_sink = std::make_shared<lefticus::travels::log_sink<std::mutex>>();
+    auto log_sink = std::make_shared<lefticus::travels::log_sink<spdlog::details::null_mutex>>();
 
     spdlog::set_default_logger(std::make_shared<spdlog::logger>("default", log_sink));
 
     spdlog::set_level(spdlog::level::trace);
-    lefticus::travels::play_game(game, log_sink);
+    play_options.timings_file = timings_file;
+    play_options.record_input_file = record_input_file;
+    if (colors == "truecolor") {
+      play_options.color_depth = lefticus::travels::Color_Depth::True_Color;
+    } else if (colors == "256") {
+      play_options.color_depth = lefticus::travels::Color_Depth::Palette_256;
+    } else if (colors == "16") {
+      play_options.color_depth = lefticus::travels::Color_Depth::Palette_16;
+    }
+    lefticus::travels::play_game(game, log_sink, play_options);
   } catch (const std::exception &e) {
     fmt::print("Unhandled exception in main: {}", e.what());
   }
@@ -0,0 +1,383 @@
+#include "map_chunks.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <condition_variable>
+#include <deque>
+#include <fmt/format.h>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace lefticus::travels {
+
+namespace {
+  Map_Chunks::Chunk make_chunk(const Map_Chunks::Loader &loader, const Point chunk)
+  {
+    Map_Chunks::Chunk cells{ Size{ Map_Chunks::chunk_size, Map_Chunks::chunk_size } };
+    fill(cells, Map_Chunks::empty_cell);
+    loader(Point{ chunk.x * Map_Chunks::chunk_size, chunk.y * Map_Chunks::chunk_size }, cells);
+    return cells;
+  }
+
+  std::uint64_t read_u64(const std::span<const std::byte> data, const std::size_t index)
+  {
+    std::uint64_t result = 0;
+    for (std::size_t byte = 0; byte < sizeof(result); ++byte) {
+      result |= std::uint64_t{ std::to_integer<std::uint8_t>(data[index * sizeof(result) + byte]) } << (byte * 8);
+    }
+    return result;
+  }
+
+  std::uint32_t read_u32(const std::span<const std::byte> data, const std::size_t index)
+  {
+    std::uint32_t result = 0;
+    for (std::size_t byte = 0; byte < sizeof(result); ++byte) {
+      result |= std::uint32_t{ std::to_integer<std::uint8_t>(data[index * sizeof(result) + byte]) } << (byte * 8);
+    }
+    return result;
+  }
+
+  template<typename Integer> void append(std::vector<std::byte> &data, const Integer value)
+  {
+    for (std::size_t byte = 0; byte < sizeof(value); ++byte) {
+      data.push_back(static_cast<std::byte>((value >> (byte * 8)) & 0xFFU));// NOLINT magic numbers
+    }
+  }
+
+  [[nodiscard]] Size chunks_in(const Size size) noexcept
+  {
+    return Size{ (size.width + Map_Chunks::chunk_size - 1) / Map_Chunks::chunk_size,
+      (size.height + Map_Chunks::chunk_size - 1) / Map_Chunks::chunk_size };
+  }
+
+  // the part of `chunk` that is on the map
+  [[nodiscard]] Size cells_in(const Size size, const Point chunk) noexcept
+  {
+    return Size{ std::min(Map_Chunks::chunk_size, size.width - chunk.x * Map_Chunks::chunk_size),
+      std::min(Map_Chunks::chunk_size, size.height - chunk.y * Map_Chunks::chunk_size) };
+  }
+}// namespace
+
+
+// Loads requested chunks on its own thread, and holds on to them until they are taken
+class Map_Chunks::Streamer
+{
+public:
+  explicit Streamer(Loader loader) : loader_{ std::move(loader) } {}
+
+  Streamer(const Streamer &) = delete;
+  Streamer &operator=(const Streamer &) = delete;
+  Streamer(Streamer &&) = delete;
+  Streamer &operator=(Streamer &&) = delete;
+
+  ~Streamer()
+  {
+    {
+      const std::scoped_lock lock{ mutex_ };
+      stop_ = true;
+    }
+    wake_up_.notify_one();
+    thread_.join();
+  }
+
+  // replaces whatever was still waiting to be loaded, so a moving camera doesn't build up a backlog
+  void request(std::deque<Point> chunks)
+  {
+    {
+      const std::scoped_lock lock{ mutex_ };
+      requests_ = std::move(chunks);
+    }
+    wake_up_.notify_one();
+  }
+
+  [[nodiscard]] std::vector<std::pair<Point, Chunk>> take_loaded()
+  {
+    const std::scoped_lock lock{ mutex_ };
+    return std::exchange(loaded_, {});
+  }
+
+private:
+  void run()
+  {
+    std::unique_lock lock{ mutex_ };
+
+    while (true) {
+      wake_up_.wait(lock, [this] { return stop_ || !requests_.empty(); });
+      if (stop_) { return; }
+
+      const auto chunk = requests_.front();
+      requests_.pop_front();
+
+      lock.unlock();
+      std::optional<Chunk> cells;
+      try {
+        cells = make_chunk(loader_, chunk);
+      } catch (...) {
+        // dropped, if the chunk is needed the blocking load will report the error
+      }
+      lock.lock();
+
+      if (cells) { loaded_.emplace_back(chunk, std::move(*cells)); }
+    }
+  }
+
+  Loader loader_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_up_;
+  std::deque<Point> requests_;
+  std::vector<std::pair<Point, Chunk>> loaded_;
+  bool stop_ = false;
+
+  // last, so that everything it uses exists before it starts
+  std::thread thread_{ [this] { run(); } };
+};
+
+
+Map_Chunks::Map_Chunks(const Size size) : size_{ size } {}
+
+Map_Chunks::Map_Chunks(const Size size, Loader loader, const std::size_t memory_budget)
+  : size_{ size }, loader_{ std::move(loader) }, memory_budget_{ memory_budget }
+{}
+
+Map_Chunks::Map_Chunks(Map_Chunks &&) noexcept = default;
+Map_Chunks &Map_Chunks::operator=(Map_Chunks &&) noexcept = default;
+Map_Chunks::~Map_Chunks() = default;
+
+std::uint32_t Map_Chunks::at(const Point cell) const
+{
+  if (const auto value = resident_at(cell)) { return *value; }
+
+  const auto &chunk = resident(Point{ cell.x / chunk_size, cell.y / chunk_size });
+  return chunk.cells.unchecked_at(Point{ cell.x % chunk_size, cell.y % chunk_size });
+}
+
+std::optional<std::uint32_t> Map_Chunks::resident_at(const Point cell) const
+{
+  if (cell.x >= size_.width || cell.y >= size_.height) {
+    throw std::range_error(fmt::format(
+      "index out of range, got: ({},{}), allowed ({}, {})", cell.x, cell.y, size_.width - 1, size_.height - 1));
+  }
+
+  if (!loader_) { return empty_cell; }
+
+  const auto resident_chunk = chunks_.find(Point{ cell.x / chunk_size, cell.y / chunk_size });
+  if (resident_chunk == chunks_.end()) { return std::nullopt; }
+  return resident_chunk->second.cells.unchecked_at(Point{ cell.x % chunk_size, cell.y % chunk_size });
+}
+
+void Map_Chunks::prefetch(const Point origin, const Size area, const std::size_t margin) const
+{
+  if (!loader_ || area.width == 0 || area.height == 0) { return; }
+
+  ++generation_;
+  take_loaded();
+
+  const auto last_cell = Point{ std::min(origin.x + area.width, size_.width) - 1,
+    std::min(origin.y + area.height, size_.height) - 1 };
+
+  // the visible chunks have to be there now
+  for (std::size_t chunk_y = origin.y / chunk_size; chunk_y <= last_cell.y / chunk_size; ++chunk_y) {
+    for (std::size_t chunk_x = origin.x / chunk_size; chunk_x <= last_cell.x / chunk_size; ++chunk_x) {
+      auto &resident_chunk = resident(Point{ chunk_x, chunk_y });
+      resident_chunk.generation = generation_;
+      touch(resident_chunk);
+    }
+  }
+
+  // the ones around them are loaded in the background, closest first
+  const auto margin_first = Point{ (origin.x - std::min(margin, origin.x)) / chunk_size,
+    (origin.y - std::min(margin, origin.y)) / chunk_size };
+  const auto margin_last = Point{ (std::min(last_cell.x + margin, size_.width - 1)) / chunk_size,
+    (std::min(last_cell.y + margin, size_.height - 1)) / chunk_size };
+
+  std::deque<Point> requests;
+  for (std::size_t chunk_y = margin_first.y; chunk_y <= margin_last.y; ++chunk_y) {
+    for (std::size_t chunk_x = margin_first.x; chunk_x <= margin_last.x; ++chunk_x) {
+      const auto chunk = Point{ chunk_x, chunk_y };
+      if (!chunks_.contains(chunk)) { requests.push_back(chunk); }
+    }
+  }
+
+  const auto center = Point{ (origin.x + area.width / 2) / chunk_size, (origin.y + area.height / 2) / chunk_size };
+  const auto distance = [center](const Point chunk) {
+    const auto delta = [](const std::size_t lhs, const std::size_t rhs) { return lhs > rhs ? lhs - rhs : rhs - lhs; };
+    return std::max(delta(chunk.x, center.x), delta(chunk.y, center.y));
+  };
+  std::ranges::stable_sort(
+    requests, [&](const Point lhs, const Point rhs) { return distance(lhs) < distance(rhs); });
+
+  if (!requests.empty() && !streamer_) { streamer_ = std::make_unique<Streamer>(loader_); }
+  if (streamer_) { streamer_->request(std::move(requests)); }
+
+  evict();
+}
+
+void Map_Chunks::set_memory_budget(const std::size_t bytes)
+{
+  memory_budget_ = bytes;
+  evict();
+}
+
+Map_Chunks::Chunk Map_Chunks::load(const Point chunk) const { return make_chunk(loader_, chunk); }
+
+Map_Chunks::Resident_Chunk &Map_Chunks::resident(const Point chunk) const
+{
+  if (const auto resident_chunk = chunks_.find(chunk); resident_chunk != chunks_.end()) {
+    return resident_chunk->second;
+  }
+
+  ++stats_.blocking_loads;
+  auto &result = insert(chunk, load(chunk));
+  evict(chunk);
+  return result;
+}
+
+Map_Chunks::Resident_Chunk &Map_Chunks::insert(const Point chunk, Chunk cells) const
+{
+  least_recently_used_.push_front(chunk);
+  auto &result =
+    chunks_.insert_or_assign(chunk, Resident_Chunk{ std::move(cells), least_recently_used_.begin(), 0 }).first->second;
+  stats_.resident_chunks = chunks_.size();
+  return result;
+}
+
+void Map_Chunks::touch(Resident_Chunk &resident_chunk) const
+{
+  if (resident_chunk.last_used != least_recently_used_.begin()) {
+    least_recently_used_.splice(least_recently_used_.begin(), least_recently_used_, resident_chunk.last_used);
+  }
+}
+
+void Map_Chunks::take_loaded() const
+{
+  if (!streamer_) { return; }
+
+  for (auto &[chunk, cells] : streamer_->take_loaded()) {
+    // it might have been needed before the streamer got to it
+    if (chunks_.contains(chunk)) { continue; }
+
+    insert(chunk, std::move(cells));
+    ++stats_.background_loads;
+  }
+}
+
+void Map_Chunks::evict(const std::optional<Point> keep) const
+{
+  static constexpr auto chunk_bytes = chunk_size * chunk_size * sizeof(std::uint32_t);
+
+  auto oldest = least_recently_used_.end();
+  while (chunks_.size() * chunk_bytes > memory_budget_ && oldest != least_recently_used_.begin()) {
+    --oldest;
+
+    // chunks visible at the last `prefetch` are kept, even if that goes over the budget
+    const auto resident_chunk = chunks_.find(*oldest);
+    if (*oldest == keep || resident_chunk->second.generation == generation_) { continue; }
+
+    chunks_.erase(resident_chunk);
+    oldest = least_recently_used_.erase(oldest);
+    ++stats_.evictions;
+  }
+
+  stats_.resident_chunks = chunks_.size();
+}
+
+
+Chunk_Runs::Chunk_Runs(const Size size,
+  const std::span<const std::byte> starts,
+  const std::span<const std::byte> runs,
+  std::shared_ptr<const void> owner)
+  : size_{ size }, starts_{ starts }, runs_{ runs }, owner_{ std::move(owner) }
+{
+  const auto chunks = chunks_in(size_);
+  if (starts_.size() / sizeof(std::uint64_t) != chunks.width * chunks.height + 1) {
+    throw std::runtime_error(fmt::format("Expected run starts for {}x{} chunks", chunks.width, chunks.height));
+  }
+}
+
+Chunk_Runs Chunk_Runs::encode(const Size size, const std::function<std::uint32_t(Point cell)> &cell_value)
+{
+  std::vector<std::byte> runs;
+  std::vector<std::uint64_t> starts;
+  std::size_t run_count = 0;
+
+  const auto chunks = chunks_in(size);
+  for (std::size_t chunk_y = 0; chunk_y < chunks.height; ++chunk_y) {
+    for (std::size_t chunk_x = 0; chunk_x < chunks.width; ++chunk_x) {
+      starts.push_back(run_count);
+
+      const auto cells = cells_in(size, Point{ chunk_x, chunk_y });
+      std::uint32_t length = 0;
+      std::uint32_t value = 0;
+      for (std::size_t y = 0; y < cells.height; ++y) {
+        for (std::size_t x = 0; x < cells.width; ++x) {
+          const auto next =
+            cell_value(Point{ chunk_x * Map_Chunks::chunk_size + x, chunk_y * Map_Chunks::chunk_size + y });
+          if (length != 0 && next == value) {
+            ++length;
+            continue;
+          }
+          if (length != 0) {
+            append(runs, length);
+            append(runs, value);
+            ++run_count;
+          }
+          length = 1;
+          value = next;
+        }
+      }
+      if (length != 0) {
+        append(runs, length);
+        append(runs, value);
+        ++run_count;
+      }
+    }
+  }
+  starts.push_back(run_count);
+
+  std::vector<std::byte> starts_and_runs;
+  starts_and_runs.reserve(starts.size() * sizeof(std::uint64_t) + runs.size());
+  for (const auto start : starts) { append(starts_and_runs, start); }
+  starts_and_runs.insert(starts_and_runs.end(), runs.begin(), runs.end());
+  return own(size, std::move(starts_and_runs), starts.size() * sizeof(std::uint64_t));
+}
+
+Chunk_Runs Chunk_Runs::owned() const
+{
+  std::vector<std::byte> starts_and_runs(starts_.begin(), starts_.end());
+  starts_and_runs.insert(starts_and_runs.end(), runs_.begin(), runs_.end());
+  return own(size_, std::move(starts_and_runs), starts_.size());
+}
+
+Chunk_Runs Chunk_Runs::own(const Size size, std::vector<std::byte> starts_and_runs, const std::size_t starts_bytes)
+{
+  auto data = std::make_shared<const std::vector<std::byte>>(std::move(starts_and_runs));
+  const auto bytes = std::span<const std::byte>{ *data };
+  return Chunk_Runs{ size, bytes.first(starts_bytes), bytes.subspan(starts_bytes), std::move(data) };
+}
+
+void Chunk_Runs::expand(const Point chunk, Map_Chunks::Chunk &cells) const
+{
+  const auto chunks = chunks_in(size_);
+  if (chunk.x >= chunks.width || chunk.y >= chunks.height) { return; }
+
+  const auto index = chunk.y * chunks.width + chunk.x;
+  const auto first_run = read_u64(starts_, index);
+  const auto last_run =
+    std::min<std::uint64_t>(read_u64(starts_, index + 1), runs_.size() / (2 * sizeof(std::uint32_t)));
+
+  const auto area = cells_in(size_, chunk);
+  const auto cell_count = area.width * area.height;
+  std::size_t cell = 0;
+  for (auto run = first_run; run < last_run && cell < cell_count; ++run) {
+    const auto value = read_u32(runs_, (2 * run) + 1);
+    const auto end = cell + std::min<std::size_t>(read_u32(runs_, 2 * run), cell_count - cell);
+    for (; cell < end; ++cell) { cells.unchecked_at(Point{ cell % area.width, cell / area.width }) = value; }
+  }
+}
+
+}// namespace lefticus::travels
@@ -0,0 +1,159 @@
+#ifndef AWESOME_GAME_MAP_CHUNKS_HPP
+#define AWESOME_GAME_MAP_CHUNKS_HPP
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "point.hpp"
+#include "size.hpp"
+#include "vector2d.hpp"
+
+namespace lefticus::travels {
+
+// The per cell data of a map, split into square chunks that are loaded on demand.
+//
+// Chunks around the camera are loaded on a background thread by `prefetch`, anything else
+// is loaded the first time it is read. When the resident chunks take up more than the memory
+// budget, the ones that have been out of view the longest are evicted, and loaded again if they
+// are needed later. Only `prefetch` and loads keep track of that, reading a resident cell
+// doesn't change anything.
+//
+// So const members that only read resident chunks, `resident_at`, or `at` on a chunk in view at
+// the last `prefetch`, may be called from several threads at once. Anything that loads a chunk
+// or evicts one must only be done from one thread at a time, apart from its own loading thread.
+class Map_Chunks
+{
+public:
+  static constexpr std::size_t chunk_size = 32;
+  static constexpr std::uint32_t empty_cell = std::numeric_limits<std::uint32_t>::max();
+  static constexpr std::size_t default_memory_budget = std::size_t{ 64 } * 1024 * 1024;// NOLINT magic numbers
+
+  using Chunk = Vector2D<std::uint32_t>;
+
+  // Fills in the cells of `chunk`, whose upper left cell is at `origin`. Cells that are not
+  // written, including those past the edge of the map, stay `empty_cell`.
+  // Called on the loading thread, so it must be safe to call from any thread.
+  using Loader = std::function<void(Point origin, Chunk &chunk)>;
+
+  // a map where every cell is `empty_cell`
+  explicit Map_Chunks(Size size);
+
+  Map_Chunks(Size size, Loader loader, std::size_t memory_budget = default_memory_budget);
+
+  Map_Chunks(const Map_Chunks &) = delete;
+  Map_Chunks &operator=(const Map_Chunks &) = delete;
+  Map_Chunks(Map_Chunks &&) noexcept;
+  Map_Chunks &operator=(Map_Chunks &&) noexcept;
+  ~Map_Chunks();
+
+  [[nodiscard]] Size size() const noexcept { return size_; }
+
+  // loads the chunk holding `cell` right away if it isn't resident
+  // throws std::range_error if `cell` is not on the map
+  [[nodiscard]] std::uint32_t at(Point cell) const;
+
+  // the cell if its chunk is resident, without ever loading it
+  // throws std::range_error if `cell` is not on the map
+  [[nodiscard]] std::optional<std::uint32_t> resident_at(Point cell) const;
+
+  // Makes sure every chunk overlapping the `area` cells starting at `origin` is resident, and
+  // queues any chunk within `margin` cells of it to be loaded in the background. Chunks in `area`
+  // become the most recently used, and are never evicted until the next call.
+  void prefetch(Point origin, Size area, std::size_t margin) const;
+
+  void set_memory_budget(std::size_t bytes);
+
+  struct Stats
+  {
+    std::size_t resident_chunks = 0;
+    std::size_t background_loads = 0;
+    std::size_t blocking_loads = 0;// chunks that had to be loaded while something waited for them
+    std::size_t evictions = 0;
+  };
+
+  [[nodiscard]] const Stats &stats() const noexcept { return stats_; }
+
+private:
+  class Streamer;
+
+  struct Resident_Chunk
+  {
+    Chunk cells;
+    std::list<Point>::iterator last_used;// moved to the front by `prefetch` and loads only
+    std::uint64_t generation = 0;// the last `prefetch` that had this chunk in view
+  };
+
+  [[nodiscard]] Chunk load(Point chunk) const;
+  // loads the chunk if it isn't resident
+  Resident_Chunk &resident(Point chunk) const;
+  Resident_Chunk &insert(Point chunk, Chunk cells) const;
+  void touch(Resident_Chunk &resident_chunk) const;
+  void take_loaded() const;
+  void evict(std::optional<Point> keep = std::nullopt) const;
+
+  Size size_;
+  Loader loader_;
+  std::size_t memory_budget_ = default_memory_budget;
+
+  // all of these are caches, the contents of the map don't change when they do
+  mutable std::unordered_map<Point, Resident_Chunk> chunks_;
+  mutable std::list<Point> least_recently_used_;// most recently used first
+  mutable std::uint64_t generation_ = 1;// chunks that were never in view are generation 0
+  mutable Stats stats_;
+  mutable std::unique_ptr<Streamer> streamer_;
+};
+
+// The value of every cell of a map, run length encoded one chunk at a time so that any chunk can
+// be expanded without reading the others. Maps are mostly long runs of a few tile stacks, so this
+// is a small fraction of the size of one value per cell.
+//
+// The encoding is the same in memory as in a compiled map, little endian std::uint32_t:
+// `starts` has the index of the first run of each chunk, chunks in row order, and one past the
+// last run, each as two fields, low half first. `runs` has { length, value } pairs. The runs of a
+// chunk cover its cells that are on the map, row by row.
+class Chunk_Runs
+{
+public:
+  // a map without cells
+  Chunk_Runs() = default;
+
+  // Views `starts` and `runs`, which `owner` keeps alive.
+  // throws std::runtime_error if `starts` doesn't have an entry for every chunk of a `size` map
+  Chunk_Runs(Size size,
+    std::span<const std::byte> starts,
+    std::span<const std::byte> runs,
+    std::shared_ptr<const void> owner);
+
+  // the value of each cell is `cell_value(cell)`, asked in chunk order
+  [[nodiscard]] static Chunk_Runs encode(Size size, const std::function<std::uint32_t(Point cell)> &cell_value);
+
+  [[nodiscard]] Size size() const noexcept { return size_; }
+  [[nodiscard]] std::span<const std::byte> starts() const noexcept { return starts_; }
+  [[nodiscard]] std::span<const std::byte> runs() const noexcept { return runs_; }
+
+  // the same runs, in memory of its own
+  [[nodiscard]] Chunk_Runs owned() const;
+
+  // Writes the cells of `chunk` that are on the map into `cells`. Runs that don't fit, in
+  // damaged data, are left out.
+  void expand(Point chunk, Map_Chunks::Chunk &cells) const;
+
+private:
+  static Chunk_Runs own(Size size, std::vector<std::byte> starts_and_runs, std::size_t starts_bytes);
+
+  Size size_{};
+  std::span<const std::byte> starts_;
+  std::span<const std::byte> runs_;
+  std::shared_ptr<const void> owner_;
+};
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_MAP_CHUNKS_HPP
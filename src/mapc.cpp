@@ -0,0 +1,43 @@
+#include <CLI/CLI.hpp>
+#include <fmt/format.h>
+#include <fstream>
+
+#include "compiled_map.hpp"
+
+// generated by CMake, see `configured_files/config.hpp.in`
+#include <internal_use_only/config.hpp>
+
+// Compiles a Tiled map and its tilesets into the binary format `load_compiled_map` reads
+int main(int argc, const char **argv)
+{
+  try {
+    CLI::App app{ fmt::format(
+      "travels-mapc, map compiler for {} version {}", travels::cmake::project_name, travels::cmake::project_version) };
+
+    std::string input;
+    app.add_option("map", input, "Tiled map (.tmj) to compile")->required()->check(CLI::ExistingFile);
+
+    std::string output;
+    app.add_option("-o,--output",
+      output,
+      fmt::format("Output file, defaults to the map with a {} extension", lefticus::travels::compiled_map::extension));
+
+    CLI11_PARSE(app, argc, argv);
+
+    std::filesystem::path output_path = output;
+    if (output_path.empty()) {
+      output_path = input;
+      output_path.replace_extension(lefticus::travels::compiled_map::extension);
+    }
+
+    const auto tiled_map = lefticus::travels::read_tiled_map(input);
+
+    std::ofstream output_file(output_path, std::ios::binary);
+    lefticus::travels::write_compiled_map(tiled_map, output_file);
+
+    fmt::print("Compiled '{}' to '{}'\n", input, output_path.string());
+  } catch (const std::exception &e) {
+    fmt::print(stderr, "Error: {}\n", e.what());
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,84 @@
+#include "mapped_file.hpp"
+
+#include <fmt/format.h>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace lefticus::travels {
+
+#ifdef _WIN32
+
+Mapped_File::Mapped_File(const std::filesystem::path &file) : size_{ std::filesystem::file_size(file) }
+{
+  if (size_ == 0) { return; }
+
+  file_ = CreateFileW(
+    file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file_ == INVALID_HANDLE_VALUE) {
+    file_ = nullptr;
+    throw std::runtime_error(fmt::format("Unable to open '{}'", file.string()));
+  }
+
+  mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping_ == nullptr) {
+    CloseHandle(file_);
+    throw std::runtime_error(fmt::format("Unable to map '{}'", file.string()));
+  }
+
+  data_ = static_cast<const std::byte *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  if (data_ == nullptr) {
+    CloseHandle(mapping_);
+    CloseHandle(file_);
+    throw std::runtime_error(fmt::format("Unable to map '{}'", file.string()));
+  }
+}
+
+Mapped_File::~Mapped_File()
+{
+  if (data_ != nullptr) { UnmapViewOfFile(data_); }
+  if (mapping_ != nullptr) { CloseHandle(mapping_); }
+  if (file_ != nullptr) { CloseHandle(file_); }
+}
+
+#else
+
+Mapped_File::Mapped_File(const std::filesystem::path &file) : size_{ std::filesystem::file_size(file) }
+{
+  if (size_ == 0) { return; }
+
+  const int descriptor = ::open(file.c_str(), O_RDONLY);// NOLINT vararg
+  if (descriptor == -1) { throw std::runtime_error(fmt::format("Unable to open '{}'", file.string())); }
+
+  void *mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  // the mapping stays valid after the descriptor is closed
+  ::close(descriptor);
+
+  if (mapping == MAP_FAILED) {// NOLINT C style cast in MAP_FAILED
+    throw std::runtime_error(fmt::format("Unable to map '{}'", file.string()));
+  }
+
+  data_ = static_cast<const std::byte *>(mapping);
+}
+
+Mapped_File::~Mapped_File()
+{
+  // NOLINTNEXTLINE munmap wants a non-const pointer
+  if (data_ != nullptr) { ::munmap(const_cast<std::byte *>(data_), size_); }
+}
+
+#endif
+
+}// namespace lefticus::travels
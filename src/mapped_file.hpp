@@ -0,0 +1,37 @@
+#ifndef AWESOME_GAME_MAPPED_FILE_HPP
+#define AWESOME_GAME_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace lefticus::travels {
+
+// A read only memory mapping of an entire file, unmapped on destruction
+class Mapped_File
+{
+public:
+  // throws std::runtime_error if the file can't be opened or mapped
+  explicit Mapped_File(const std::filesystem::path &file);
+
+  Mapped_File(const Mapped_File &) = delete;
+  Mapped_File &operator=(const Mapped_File &) = delete;
+  Mapped_File(Mapped_File &&) = delete;
+  Mapped_File &operator=(Mapped_File &&) = delete;
+
+  ~Mapped_File();
+
+  [[nodiscard]] std::span<const std::byte> data() const noexcept { return { data_, size_ }; }
+
+private:
+  const std::byte *data_ = nullptr;
+  std::size_t size_ = 0;
+#ifdef _WIN32
+  void *file_ = nullptr;
+  void *mapping_ = nullptr;
+#endif
+};
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_MAPPED_FILE_HPP
@@ -0,0 +1,122 @@
+#include "minimap.hpp"
+#include "color_blend.hpp"
+#include "game_components.hpp"
+
+#include <algorithm>
+
+namespace lefticus::travels {
+
+namespace {
+  // the same sizes as `Tile_Stack::build_mip_levels`
+  Size mip_size(Size size, const std::size_t level)
+  {
+    for (std::size_t step = 0; step <= level; ++step) {
+      size = Size{ std::max(size.width / 2, std::size_t{ 1 }), std::max(size.height / 2, std::size_t{ 1 }) };
+    }
+    return size;
+  }
+
+  Size cells_that_fit(const Size minimap, const Size cell_size)
+  {
+    return Size{ minimap.width / cell_size.width, minimap.height / cell_size.height };
+  }
+}// namespace
+
+
+std::size_t minimap_level(const Size minimap, const Size tile_size, const Size map_size)
+{
+  for (std::size_t level = 0; level < Tile_Stack::mip_level_count; ++level) {
+    const auto cells = cells_that_fit(minimap, mip_size(tile_size, level));
+    if (cells.width >= map_size.width && cells.height >= map_size.height) { return level; }
+  }
+
+  return Tile_Stack::mip_level_count - 1;
+}
+
+void draw_minimap(Bitmap &minimap, const Game &game, const Game_Map &map, Minimap_Tracker &tracker)
+{
+  const auto level = minimap_level(minimap.pixels.size(), game.tile_size, map.size());
+  const auto cell_size = mip_size(game.tile_size, level);
+
+  const auto fit = cells_that_fit(minimap.pixels.size(), cell_size);
+  const auto cells = Size{ std::min(fit.width, map.size().width), std::min(fit.height, map.size().height) };
+  if (cells.width == 0 || cells.height == 0) { return; }
+
+  const auto clamped_start = [](const std::size_t center, const std::size_t visible, const std::size_t total) {
+    return std::min(center - std::min(center, visible / 2), total - visible);
+  };
+
+  const auto upper_left = Point{ clamped_start(game.player.map_location.x, cells.width, map.size().width),
+    clamped_start(game.player.map_location.y, cells.height, map.size().height) };
+
+  const bool redraw_all =
+    tracker.map != &map || tracker.level != level || tracker.cells != cells || tracker.upper_left != upper_left;
+
+  if (redraw_all) {
+    tracker.map = &map;
+    tracker.level = level;
+    tracker.cells = cells;
+    tracker.upper_left = upper_left;
+    tracker.player_cell.reset();
+    // whatever is left over around a small map
+    fill(minimap.pixels, Color{ 0, 0, 0, 255 });// NOLINT magic numbers
+  }
+
+  const auto player_cell = game.player.map_location - upper_left;
+  const auto player_visible = game.player.map_location.x >= upper_left.x && game.player.map_location.y >= upper_left.y
+                              && player_cell.x < cells.width && player_cell.y < cells.height;
+
+  // scripted cells and the player are drawn at full size, then scaled down like the mip levels
+  Vector2D<Color> full_size{ game.tile_size };
+
+  tracker.cells_drawn = 0;
+
+  const auto draw_cell = [&](const Point cell) {
+    const auto map_location = cell + upper_left;
+    auto pixels = Vector2D_Span<Color>(
+      Point{ cell.x * cell_size.width, cell.y * cell_size.height }, cell_size, minimap.pixels);
+
+    const auto *script = map.locations.find(map_location);
+    const bool has_player = player_visible && cell == player_cell;
+    const auto stack_id = map.tiles.at(map_location);
+    // stacks that were put together without `build_mip_levels` are scaled down on the fly
+    const bool has_mip_level = stack_id == Game_Map::no_tile_stack || level < map.tile_stacks[stack_id].mip_levels.size();
+
+    if ((script == nullptr || !script->draw) && !has_player && has_mip_level) {
+      if (stack_id != Game_Map::no_tile_stack) {
+        copy_rows(map.tile_stacks[stack_id].mip_levels[level], pixels);
+      } else {
+        fill(pixels, Color{ 0, 0, 0, 255 });// NOLINT magic numbers
+      }
+    } else {
+      fill(full_size, Color{ 0, 0, 0, 255 });// NOLINT magic numbers
+      auto full_size_span = Vector2D_Span<Color>(Point{ 0, 0 }, game.tile_size, full_size);
+      map.draw(full_size_span, game, map_location, Layer::Background);
+      if (has_player) { game.player.draw(full_size_span, game, game.player.map_location); }
+      map.draw(full_size_span, game, map_location, Layer::Foreground);
+      box_filter(full_size, pixels);
+    }
+
+    ++tracker.cells_drawn;
+  };
+
+  for (std::size_t cur_y = 0; cur_y < cells.height; ++cur_y) {
+    for (std::size_t cur_x = 0; cur_x < cells.width; ++cur_x) {
+      const auto cell = Point{ cur_x, cur_y };
+      const bool player_moved = (tracker.player_cell == cell) || (player_visible && cell == player_cell);
+
+      if (redraw_all || player_moved || !map.static_draw(cell + upper_left)) { draw_cell(cell); }
+    }
+  }
+
+  tracker.player_cell = player_visible ? std::optional{ player_cell } : std::nullopt;
+}
+
+void draw_minimap(Bitmap &minimap, const Game &game, Minimap_Tracker &tracker)
+{
+  if (game.maps.contains(game.current_map)) {
+    draw_minimap(minimap, game, game.maps.at(game.current_map), tracker);
+  }
+}
+
+}// namespace lefticus::travels
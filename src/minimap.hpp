@@ -0,0 +1,48 @@
+#ifndef AWESOME_GAME_MINIMAP_HPP
+#define AWESOME_GAME_MINIMAP_HPP
+
+#include <cstdint>
+#include <optional>
+
+#include "bitmap.hpp"
+#include "point.hpp"
+#include "size.hpp"
+#include "vector2d.hpp"
+
+namespace lefticus::travels {
+
+struct Game;
+struct Game_Map;
+
+// Remembers what was drawn into a minimap on the previous frame, like Viewport_Tracker does for
+// the viewport. Cells are drawn from their tile stack's mip levels, only cells with a scripted
+// `draw` and the player's cell are drawn at full size and then scaled down.
+struct Minimap_Tracker
+{
+  const Game_Map *map = nullptr;
+  std::size_t level = 0;// index into `Tile_Stack::mip_levels`
+  Size cells{ 0, 0 };
+  Point upper_left{};
+  std::optional<Point> player_cell;
+
+  // number of cells redrawn by the last call to `draw_minimap`
+  std::size_t cells_drawn = 0;
+
+  // redraw everything on the next frame
+  void invalidate() noexcept { map = nullptr; }
+};
+
+// The most detailed mip level the whole map fits into `minimap` at, or the least detailed one
+// if it doesn't fit at any of them.
+[[nodiscard]] std::size_t minimap_level(Size minimap, Size tile_size, Size map_size);
+
+// Draws the map zoomed out at `minimap_level`. A map that doesn't fit is drawn as large a part
+// of it as fits, centered on the player. Only the cells that can have changed since the last
+// call with this `tracker` are redrawn.
+void draw_minimap(Bitmap &minimap, const Game &game, const Game_Map &map, Minimap_Tracker &tracker);
+
+void draw_minimap(Bitmap &minimap, const Game &game, Minimap_Tracker &tracker);
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_MINIMAP_HPP
@@ -0,0 +1,152 @@
+#include "palette.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace lefticus::travels {
+
+namespace {
+  // the levels of each channel in the 6x6x6 color cube, entries 16-231
+  constexpr std::array<std::uint8_t, 6> cube_levels{ 0, 95, 135, 175, 215, 255 };// NOLINT magic numbers
+
+  // xterm's defaults for the 16 system colors
+  constexpr std::array<Color, 16> system_colors{// NOLINT magic numbers
+    Color{ 0, 0, 0, 255 },// NOLINT magic numbers
+    Color{ 205, 0, 0, 255 },// NOLINT magic numbers
+    Color{ 0, 205, 0, 255 },// NOLINT magic numbers
+    Color{ 205, 205, 0, 255 },// NOLINT magic numbers
+    Color{ 0, 0, 238, 255 },// NOLINT magic numbers
+    Color{ 205, 0, 205, 255 },// NOLINT magic numbers
+    Color{ 0, 205, 205, 255 },// NOLINT magic numbers
+    Color{ 229, 229, 229, 255 },// NOLINT magic numbers
+    Color{ 127, 127, 127, 255 },// NOLINT magic numbers
+    Color{ 255, 0, 0, 255 },// NOLINT magic numbers
+    Color{ 0, 255, 0, 255 },// NOLINT magic numbers
+    Color{ 255, 255, 0, 255 },// NOLINT magic numbers
+    Color{ 92, 92, 255, 255 },// NOLINT magic numbers
+    Color{ 255, 0, 255, 255 },// NOLINT magic numbers
+    Color{ 0, 255, 255, 255 },// NOLINT magic numbers
+    Color{ 255, 255, 255, 255 } };// NOLINT magic numbers
+
+  constexpr std::size_t first_cube_entry = 16;
+  constexpr std::size_t first_gray_entry = 232;
+
+  Color xterm_color(const std::size_t index) noexcept
+  {
+    if (index < first_cube_entry) { return system_colors[index]; }
+
+    if (index < first_gray_entry) {
+      const auto cube = index - first_cube_entry;
+      return Color{ cube_levels[cube / 36], cube_levels[(cube / 6) % 6], cube_levels[cube % 6], 255 };// NOLINT
+    }
+
+    const auto gray = static_cast<std::uint8_t>(8 + 10 * (index - first_gray_entry));// NOLINT magic numbers
+    return Color{ gray, gray, gray, 255 };// NOLINT magic numbers
+  }
+
+  // squared distance, weighted roughly by how sensitive the eye is to each channel
+  int distance(const Color lhs, const Color rhs) noexcept
+  {
+    const auto red = int{ lhs.R } - int{ rhs.R };
+    const auto green = int{ lhs.G } - int{ rhs.G };
+    const auto blue = int{ lhs.B } - int{ rhs.B };
+    return 2 * red * red + 4 * green * green + 3 * blue * blue;// NOLINT magic numbers
+  }
+
+  std::vector<std::uint8_t> make_table(const std::size_t first_entry, const std::size_t last_entry, const unsigned bits)
+  {
+    const auto levels = std::size_t{ 1 } << bits;
+    const auto shift = 8 - bits;// NOLINT magic number
+
+    // the center of each bin of colors that share an entry
+    const auto center = [&](const std::size_t level) {
+      return static_cast<std::uint8_t>((level << shift) | (std::size_t{ 1 } << (shift - 1)));
+    };
+
+    std::vector<std::uint8_t> table(levels * levels * levels);
+    for (std::size_t red = 0; red < levels; ++red) {
+      for (std::size_t green = 0; green < levels; ++green) {
+        for (std::size_t blue = 0; blue < levels; ++blue) {
+          const auto color = Color{ center(red), center(green), center(blue), 255 };// NOLINT magic number
+
+          auto best = first_entry;
+          auto best_distance = std::numeric_limits<int>::max();
+          for (auto entry = first_entry; entry <= last_entry; ++entry) {
+            if (const auto entry_distance = distance(color, xterm_color(entry)); entry_distance < best_distance) {
+              best = entry;
+              best_distance = entry_distance;
+            }
+          }
+
+          table[(red << (2 * bits)) | (green << bits) | blue] = static_cast<std::uint8_t>(best);
+        }
+      }
+    }
+
+    return table;
+  }
+
+  // 4x4 Bayer matrix
+  constexpr std::array<std::array<int, 4>, 4> dither_matrix{ {// NOLINT magic numbers
+    { 0, 8, 2, 10 },// NOLINT magic numbers
+    { 12, 4, 14, 6 },// NOLINT magic numbers
+    { 3, 11, 1, 9 },// NOLINT magic numbers
+    { 15, 7, 13, 5 } } };// NOLINT magic numbers
+}// namespace
+
+
+Palette_Quantizer::Palette_Quantizer(const Color_Depth depth, const bool dither) : depth_{ depth }, dither_{ dither }
+{
+  switch (depth) {
+  case Color_Depth::Palette_256: {
+    static const auto table = make_table(first_cube_entry, 255, bits);// NOLINT magic number
+    table_ = table;
+    dither_amplitude_ = 40;// NOLINT magic number, the cube's steps
+    break;
+  }
+  case Color_Depth::Palette_16: {
+    static const auto table = make_table(0, first_cube_entry - 1, bits);
+    table_ = table;
+    dither_amplitude_ = 80;// NOLINT magic number
+    break;
+  }
+  case Color_Depth::True_Color:
+  default:
+    throw std::invalid_argument("Palette_Quantizer needs a palette, not true color");
+  }
+}
+
+void Palette_Quantizer::quantize(const Vector2D<Color> &pixels, Vector2D<std::uint8_t> &indices) const noexcept
+{
+  for (std::size_t cur_y = 0; cur_y < pixels.size().height; ++cur_y) {
+    const auto row = pixels.row(cur_y);
+    const auto index_row = indices.row(cur_y);
+
+    if (dither_) {
+      for (std::size_t cur_x = 0; cur_x < row.size(); ++cur_x) {
+        index_row[cur_x] = table_[key(dithered(row[cur_x], Point{ cur_x, cur_y }))];
+      }
+    } else {
+      // no branches or position dependence, the key computation vectorizes, only the loads don't
+      for (std::size_t cur_x = 0; cur_x < row.size(); ++cur_x) { index_row[cur_x] = table_[key(row[cur_x])]; }
+    }
+  }
+}
+
+Color Palette_Quantizer::color(const std::uint8_t index) const noexcept { return xterm_color(index); }
+
+Color Palette_Quantizer::dithered(const Color color, const Point position) const noexcept
+{
+  // centered on 0, from just under -amplitude / 2 to just under amplitude / 2
+  const auto offset = ((dither_matrix[position.y % 4][position.x % 4] * 2 + 1 - 16) * dither_amplitude_) / 32;// NOLINT
+
+  const auto channel = [offset](const std::uint8_t value) {
+    return static_cast<std::uint8_t>(std::clamp(int{ value } + offset, 0, 255));// NOLINT magic number
+  };
+
+  return Color{ channel(color.R), channel(color.G), channel(color.B), color.A };
+}
+
+}// namespace lefticus::travels
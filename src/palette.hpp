@@ -0,0 +1,65 @@
+#ifndef AWESOME_GAME_PALETTE_HPP
+#define AWESOME_GAME_PALETTE_HPP
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "color.hpp"
+#include "vector2d.hpp"
+
+namespace lefticus::travels {
+
+enum struct Color_Depth { True_Color, Palette_256, Palette_16 };
+
+// Maps colors to the nearest entry of the xterm 256 or 16 color palette.
+//
+// Every color is looked up in a table of the nearest palette index for each color at 5 bits per
+// channel, built once per palette, so quantizing is a shift and a load per pixel. The 256 color
+// palette only uses entries 16-255, the cube and the grays, whose colors are standardized; the
+// first 16 are whatever the terminal's theme makes them.
+//
+// With `dither`, a 4x4 ordered dither is added before the lookup, so that gradients between two
+// palette colors come out as a pattern of both instead of bands.
+class Palette_Quantizer
+{
+public:
+  explicit Palette_Quantizer(Color_Depth depth, bool dither = false);
+
+  [[nodiscard]] Color_Depth depth() const noexcept { return depth_; }
+  [[nodiscard]] bool dither() const noexcept { return dither_; }
+
+  // the palette index for `color` at pixel `position`, which only matters with `dither`
+  [[nodiscard]] std::uint8_t index(const Color color, const Point position = {}) const noexcept
+  {
+    if (dither_) { return table_[key(dithered(color, position))]; }
+    return table_[key(color)];
+  }
+
+  // `index` for every pixel, `indices` must be the same size as `pixels`
+  void quantize(const Vector2D<Color> &pixels, Vector2D<std::uint8_t> &indices) const noexcept;
+
+  // the color of a palette entry
+  [[nodiscard]] Color color(std::uint8_t index) const noexcept;
+
+private:
+  static constexpr unsigned bits = 5;
+
+  [[nodiscard]] static constexpr std::size_t key(const Color color) noexcept
+  {
+    constexpr unsigned shift = 8 - bits;
+    return (std::size_t{ color.R } >> shift) << (2 * bits) | (std::size_t{ color.G } >> shift) << bits
+           | (std::size_t{ color.B } >> shift);
+  }
+
+  [[nodiscard]] Color dithered(Color color, Point position) const noexcept;
+
+  Color_Depth depth_;
+  bool dither_;
+  int dither_amplitude_;// how far apart neighboring palette colors are, roughly
+  std::span<const std::uint8_t> table_;
+};
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_PALETTE_HPP
@@ -0,0 +1,920 @@
+#include "pathfinding.hpp"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace lefticus::travels {
+
+namespace {
+  constexpr std::array<Direction, 4> directions{ Direction::North, Direction::South, Direction::East, Direction::West };
+
+  // openings at least this long get a transition at both ends instead of one in the middle
+  constexpr std::size_t long_opening = 6;
+
+  [[nodiscard]] std::uint32_t distance(const Point from, const Point to) noexcept
+  {
+    const auto dx = from.x > to.x ? from.x - to.x : to.x - from.x;
+    const auto dy = from.y > to.y ? from.y - to.y : to.y - from.y;
+    return static_cast<std::uint32_t>(dx + dy);
+  }
+
+  // the direction of the step from `from` to its neighbor `to`
+  [[nodiscard]] Direction direction_between(const Point from, const Point to) noexcept
+  {
+    if (to.x > from.x) { return Direction::East; }
+    if (to.x < from.x) { return Direction::West; }
+    if (to.y > from.y) { return Direction::South; }
+    return Direction::North;
+  }
+
+  // a stamp that no entry has yet, clearing them all only when it wraps around
+  template<typename Entry> std::uint32_t next_stamp(std::vector<Entry> &entries, std::uint32_t &stamp)
+  {
+    if (++stamp == 0) {
+      std::ranges::fill(entries, Entry{});
+      stamp = 1;
+    }
+    return stamp;
+  }
+
+  // The estimates of the remaining cost on the graph between clusters are inflated by this many
+  // quarters. Weighted A* like that searches far less of the graph, for paths that are at most
+  // a quarter longer than the best one through it.
+  constexpr std::uint32_t node_estimate_quarters = 5;
+
+  [[nodiscard]] bool one_way(const std::uint8_t mask) noexcept
+  {
+    return mask != 0 && mask != Passability_Grid::all_sides;
+  }
+
+  [[nodiscard]] Direction step_into(const auto &steps, const std::size_t cell) noexcept
+  {
+    return static_cast<Direction>((steps[cell / 4] >> (cell % 4 * 2)) & 3U);// NOLINT magic numbers
+  }
+
+  void set_step_into(auto &steps, const std::size_t cell, const Direction direction) noexcept
+  {
+    const auto shift = cell % 4 * 2;// NOLINT magic numbers
+    steps[cell / 4] = static_cast<std::uint8_t>(
+      (steps[cell / 4] & ~(3U << shift)) | (static_cast<unsigned>(direction) << shift));// NOLINT magic numbers
+  }
+
+  // the open list is a min heap on the estimate, preferring the entry that got further on ties
+  constexpr auto worse = [](const auto &lhs, const auto &rhs) {
+    return lhs.estimate > rhs.estimate || (lhs.estimate == rhs.estimate && lhs.cost < rhs.cost);
+  };
+}// namespace
+
+std::uint8_t entry_mask(const Game &game, const Game_Map &map, const Point cell)
+{
+  // only a script can make a difference between the sides
+  if (const auto *script = map.locations.find(cell); script != nullptr && script->can_enter) {
+    std::uint8_t mask = 0;
+    for (const auto side : directions) {
+      if (map.can_enter_from(game, cell, side)) { mask |= side_bit(side); }
+    }
+    return mask;
+  }
+
+  return map.can_enter_from(game, cell, Direction::North) ? Passability_Grid::all_sides : std::uint8_t{ 0 };
+}
+
+Passability_Grid::Passability_Grid(const Game &game, const Game_Map &map) : masks_{ map.size() }
+{
+  for (std::size_t cur_y = 0; cur_y < size().height; ++cur_y) {
+    for (std::size_t cur_x = 0; cur_x < size().width; ++cur_x) {
+      const auto cell = Point{ cur_x, cur_y };
+      masks_.unchecked_at(cell) = lefticus::travels::entry_mask(game, map, cell);
+    }
+  }
+}
+
+Path_Finder::Path_Finder(Passability_Grid grid)
+  : grid_{ std::move(grid) }, clusters_{ (grid_.size().width + cluster_size - 1) / cluster_size,
+                                (grid_.size().height + cluster_size - 1) / cluster_size },
+    regions_{ grid_.size() }
+{
+  const auto count = clusters_.width * clusters_.height;
+  cluster_list_.resize(count);
+  east_edges_.resize(count);
+  south_edges_.resize(count);
+
+  for (std::size_t index = 0; index < count; ++index) {
+    auto &cluster = cluster_list_[index];
+    cluster.origin = Point{ (index % clusters_.width) * cluster_size, (index / clusters_.width) * cluster_size };
+    cluster.size = Size{ std::min(cluster_size, grid_.size().width - cluster.origin.x),
+      std::min(cluster_size, grid_.size().height - cluster.origin.y) };
+  }
+
+  cluster_distances_.resize(cluster_size * cluster_size);
+
+  for (std::size_t cur_y = 0; cur_y < grid_.size().height; ++cur_y) {
+    for (std::size_t cur_x = 0; cur_x < grid_.size().width; ++cur_x) {
+      if (one_way(grid_.unchecked_entry_mask(Point{ cur_x, cur_y }))) { ++one_way_cells_; }
+    }
+  }
+
+  // the edges need the regions on both sides
+  for (std::size_t index = 0; index < count; ++index) { build_regions(index); }
+  for (std::size_t index = 0; index < count; ++index) {
+    build_edge(index, Direction::East);
+    build_edge(index, Direction::South);
+  }
+
+  // the nodes of a cluster come from the transitions of its neighbors too
+  for (std::size_t index = 0; index < count; ++index) { build_nodes(index); }
+  for (std::size_t index = 0; index < count; ++index) { build_crossings(index); }
+
+  cell_search_.resize(grid_.size().width * grid_.size().height);
+  node_search_.resize(count * max_cluster_nodes + 2);
+  label_components();
+  place_landmarks();
+}
+
+void Path_Finder::set_entry_mask(const Point cell, std::uint8_t mask)
+{
+  mask &= Passability_Grid::all_sides;
+  const auto previous = grid_.entry_mask(cell);
+  if (previous == mask) { return; }
+  grid_.set_entry_mask(cell, mask);
+
+  if (one_way(previous)) { --one_way_cells_; }
+  if (one_way(mask)) { ++one_way_cells_; }
+
+  // a new way through can make nodes much closer than the landmarks make them out to be
+  if ((mask & ~previous) != 0) { landmarks_valid_ = false; }
+
+  // the cell can only be on the edges of its own cluster
+  const auto index = cluster_index(cell);
+  const auto cluster_x = index % clusters_.width;
+  const auto cluster_y = index / clusters_.width;
+
+  build_regions(index);
+  const auto east = build_edge(index, Direction::East);
+  const auto south = build_edge(index, Direction::South);
+  const auto west = cluster_x > 0 && build_edge(index - 1, Direction::East);
+  const auto north = cluster_y > 0 && build_edge(index - clusters_.width, Direction::South);
+
+  // a neighbor's nodes only change with the transitions on the edge they share
+  build_nodes(index);
+  if (west) { build_nodes(index - 1); }
+  if (east && cluster_x + 1 < clusters_.width) { build_nodes(index + 1); }
+  if (north) { build_nodes(index - clusters_.width); }
+  if (south && cluster_y + 1 < clusters_.height) { build_nodes(index + clusters_.width); }
+
+  // which nodes the crossings of their neighbors lead to can have changed with them
+  for (std::size_t cur_y = cluster_y > 1 ? cluster_y - 2 : 0; cur_y <= std::min(cluster_y + 2, clusters_.height - 1);
+       ++cur_y) {
+    for (std::size_t cur_x = cluster_x > 1 ? cluster_x - 2 : 0; cur_x <= std::min(cluster_x + 2, clusters_.width - 1);
+         ++cur_x) {
+      build_crossings(cur_y * clusters_.width + cur_x);
+    }
+  }
+
+  components_dirty_ = true;
+}
+
+std::uint32_t Path_Finder::component(const Point cell)
+{
+  static_cast<void>(grid_.entry_mask(cell));// range check
+  if (components_dirty_) { label_components(); }
+  return region_components_[first_region_[cluster_index(cell)] + regions_.unchecked_at(cell)];
+}
+
+std::optional<std::vector<Direction>> Path_Finder::find_path(const Point from, const Point to)
+{
+  static_cast<void>(grid_.entry_mask(to));// range check
+
+  cells_expanded_ = 0;
+  nodes_expanded_ = 0;
+  hierarchical_ = false;
+
+  if (from == to || grid_.entry_mask(from) != 0) { return route(from, to); }
+
+  // The components don't know where a cell that can't be entered leads, but it can't be entered
+  // again once it's left either. So the path is the shortest from any of its neighbors.
+  std::optional<std::vector<Direction>> best;
+  for (const auto direction : directions) {
+    if (!grid_.can_step(from, direction)) { continue; }
+
+    auto rest = route(step(from, direction), to);
+    if (rest && (!best || rest->size() + 1 < best->size())) {
+      rest->insert(rest->begin(), direction);
+      best = std::move(rest);
+    }
+  }
+  return best;
+}
+
+std::optional<std::vector<Direction>> Path_Finder::route(const Point from, const Point to)
+{
+  if (from == to) { return std::vector<Direction>{}; }
+  if (grid_.unchecked_entry_mask(to) == 0 || component(from) != component(to)) { return std::nullopt; }
+
+  if (distance(from, to) <= direct_search_distance) {
+    std::vector<Direction> path;
+    if (search_cells(from, to, Point{ 0, 0 }, grid_.size(), direct_search_budget, path)) { return path; }
+  }
+
+  return find_hierarchical_path(from, to);
+}
+
+std::optional<std::vector<Direction>>
+  Path_Finder::find_shortest_path(const Point from, const Point to, const std::size_t budget)
+{
+  static_cast<void>(grid_.entry_mask(from));// range checks
+  static_cast<void>(grid_.entry_mask(to));
+
+  cells_expanded_ = 0;
+  nodes_expanded_ = 0;
+  hierarchical_ = false;
+
+  std::vector<Direction> path;
+  if (!search_cells(from, to, Point{ 0, 0 }, grid_.size(), budget, path)) { return std::nullopt; }
+  return path;
+}
+
+Path_Finder::Stats Path_Finder::stats() const noexcept
+{
+  return Stats{ .clusters = cluster_list_.size(),
+    .nodes = node_count_,
+    .cells_expanded = cells_expanded_,
+    .nodes_expanded = nodes_expanded_,
+    .hierarchical = hierarchical_,
+    .landmarks = landmarks_valid_ };
+}
+
+std::size_t Path_Finder::cluster_index(const Point cell) const noexcept
+{
+  return (cell.y / cluster_size) * clusters_.width + cell.x / cluster_size;
+}
+
+bool Path_Finder::linked(const Point cell, const Direction direction) const noexcept
+{
+  // off the map wraps around to a huge coordinate
+  const auto neighbor = step(cell, direction);
+  if (neighbor.x >= grid_.size().width || neighbor.y >= grid_.size().height) { return false; }
+
+  return (grid_.unchecked_entry_mask(cell) != 0 && grid_.can_step(cell, direction))
+         || (grid_.unchecked_entry_mask(neighbor) != 0 && grid_.can_step(neighbor, opposite(direction)));
+}
+
+bool Path_Finder::two_way(const Point cell, const Direction direction) const noexcept
+{
+  return grid_.can_step(cell, direction) && grid_.can_step(step(cell, direction), opposite(direction));
+}
+
+void Path_Finder::build_regions(const std::size_t cluster)
+{
+  auto &current = cluster_list_[cluster];
+  const auto local = [&current](const Point cell) {
+    return (cell.y - current.origin.y) * cluster_size + (cell.x - current.origin.x);
+  };
+  const auto inside = [&current](const Point cell) {
+    return cell.x - current.origin.x < current.size.width && cell.y - current.origin.y < current.size.height;
+  };
+
+  std::array<bool, cluster_size * cluster_size> labeled{};
+  std::array<Point, cluster_size * cluster_size> pending{};
+  std::size_t region = 0;
+  std::optional<std::uint8_t> closed_region;
+
+  for (std::size_t cur_y = 0; cur_y < current.size.height; ++cur_y) {
+    for (std::size_t cur_x = 0; cur_x < current.size.width; ++cur_x) {
+      const auto seed = current.origin + Point{ cur_x, cur_y };
+      if (labeled[local(seed)]) { continue; }
+
+      // nothing is linked to a cell that can't be entered
+      if (grid_.unchecked_entry_mask(seed) == 0) {
+        if (!closed_region) { closed_region = static_cast<std::uint8_t>(region++); }
+        regions_.unchecked_at(seed) = *closed_region;
+        labeled[local(seed)] = true;
+        continue;
+      }
+
+      // flood fill, every cell is pushed once
+      std::size_t pending_count = 0;
+      pending[pending_count++] = seed;
+      labeled[local(seed)] = true;
+
+      while (pending_count > 0) {
+        const auto cell = pending[--pending_count];
+        regions_.unchecked_at(cell) = static_cast<std::uint8_t>(region);
+
+        for (const auto direction : directions) {
+          if (!linked(cell, direction)) { continue; }
+          const auto neighbor = step(cell, direction);
+          if (inside(neighbor) && !labeled[local(neighbor)]) {
+            labeled[local(neighbor)] = true;
+            pending[pending_count++] = neighbor;
+          }
+        }
+      }
+
+      ++region;
+    }
+  }
+
+  current.region_count = region;
+}
+
+bool Path_Finder::build_edge(const std::size_t cluster, const Direction edge)
+{
+  const auto &current = cluster_list_[cluster];
+  const auto east = edge == Direction::East;
+  auto &cluster_edge = east ? east_edges_[cluster] : south_edges_[cluster];
+
+  if (east ? current.origin.x + current.size.width >= grid_.size().width
+           : current.origin.y + current.size.height >= grid_.size().height) {
+    return false;
+  }
+
+  auto previous_transitions = std::move(cluster_edge.transitions);
+  auto &transitions = cluster_edge.transitions;
+  transitions.clear();
+  cluster_edge.joins.clear();
+
+  // the cells along the edge on this cluster's side
+  const auto along = east ? Direction::South : Direction::East;
+  const auto length = east ? current.size.height : current.size.width;
+  const auto edge_cell = [&](const std::size_t position) {
+    return east ? Point{ current.origin.x + current.size.width - 1, current.origin.y + position }
+                : Point{ current.origin.x + position, current.origin.y + current.size.height - 1 };
+  };
+  const auto add = [&](const std::size_t position) {
+    transitions.push_back(Transition{ edge_cell(position), step(edge_cell(position), edge) });
+  };
+
+  // An opening is a run of cells that can be crossed both ways and that can be walked along both
+  // ways on either side, so one or two transitions stand in for all of it. Cells that can only be
+  // crossed one way get a transition each.
+  std::size_t run_start = 0;
+  std::size_t run_length = 0;
+  const auto end_run = [&] {
+    if (run_length == 0) { return; }
+    if (run_length < long_opening) {
+      add(run_start + run_length / 2);
+    } else {
+      add(run_start);
+      add(run_start + run_length - 1);
+    }
+    run_length = 0;
+  };
+
+  for (std::size_t position = 0; position < length; ++position) {
+    const auto cell = edge_cell(position);
+
+    if (linked(cell, edge)) {
+      const auto join = std::pair{ regions_.unchecked_at(cell), regions_.unchecked_at(step(cell, edge)) };
+      if (std::ranges::find(cluster_edge.joins, join) == cluster_edge.joins.end()) {
+        cluster_edge.joins.push_back(join);
+      }
+    }
+
+    if (two_way(cell, edge)) {
+      if (run_length > 0) {
+        const auto previous = edge_cell(position - 1);
+        if (!two_way(previous, along) || !two_way(step(previous, edge), along)) { end_run(); }
+      }
+      if (run_length == 0) { run_start = position; }
+      ++run_length;
+    } else {
+      end_run();
+      if (linked(cell, edge)) { add(position); }
+    }
+  }
+
+  end_run();
+
+  return transitions != previous_transitions;
+}
+
+void Path_Finder::build_nodes(const std::size_t cluster)
+{
+  auto &current = cluster_list_[cluster];
+  const auto previous = std::move(current.nodes);
+  current.nodes.clear();
+  node_count_ -= previous.size();
+
+  const auto add = [&current, &previous](const Point cell) {
+    const auto same_cell = [cell](const Node &node) { return node.cell == cell; };
+    if (std::ranges::any_of(current.nodes, same_cell)) { return; }
+
+    auto &node = current.nodes.emplace_back(Node{ cell, {}, {}, {}, {} });
+    // a node that was already there keeps its distances from the landmarks
+    if (const auto found = std::ranges::find_if(previous, same_cell); found != previous.end()) {
+      node.landmark_costs = found->landmark_costs;
+    } else {
+      node.landmark_costs.fill(unreached);
+    }
+  };
+
+  for (const auto &transition : east_edges_[cluster].transitions) { add(transition.inside); }
+  for (const auto &transition : south_edges_[cluster].transitions) { add(transition.inside); }
+  if (cluster % clusters_.width > 0) {
+    for (const auto &transition : east_edges_[cluster - 1].transitions) { add(transition.outside); }
+  }
+  if (cluster >= clusters_.width) {
+    for (const auto &transition : south_edges_[cluster - clusters_.width].transitions) { add(transition.outside); }
+  }
+
+  const auto count = current.nodes.size();
+  node_count_ += count;
+  std::vector<std::uint32_t> costs(count * count);// from each node to each other one
+
+  const auto moves = cluster_moves(cluster, false);
+  for (std::size_t node = 0; node < count; ++node) {
+    search_cluster(moves, local_index(cluster, current.nodes[node].cell));
+    current.nodes[node].steps = cluster_steps_;
+    for (std::size_t other = 0; other < count; ++other) {
+      costs[node * count + other] = cluster_distances_[local_index(cluster, current.nodes[other].cell)];
+    }
+  }
+
+  // An edge that is only as short as going through another node of the cluster is left out, the
+  // way through that node stands in for it. The search relaxes far fewer edges that way.
+  const auto through = [&](const std::size_t from, const std::size_t via, const std::size_t to) {
+    const auto first = costs[from * count + via];
+    const auto second = costs[via * count + to];
+    return first != unreached && second != unreached && first + second == costs[from * count + to];
+  };
+
+  for (std::size_t node = 0; node < count; ++node) {
+    for (std::size_t other = 0; other < count; ++other) {
+      const auto cost = costs[node * count + other];
+      if (other == node || cost == unreached) { continue; }
+
+      bool redundant = false;
+      for (std::size_t via = 0; via < count && !redundant; ++via) {
+        redundant = via != node && via != other && through(node, via, other);
+      }
+      if (!redundant) {
+        current.nodes[node].edges.push_back(
+          Edge{ static_cast<std::uint32_t>(cluster * max_cluster_nodes + other), cost });
+      }
+    }
+  }
+}
+
+void Path_Finder::build_crossings(const std::size_t cluster)
+{
+  for (auto &node : cluster_list_[cluster].nodes) {
+    node.crossings.clear();
+
+    for (const auto direction : directions) {
+      if (!grid_.can_step(node.cell, direction)) { continue; }
+      const auto neighbor = step(node.cell, direction);
+      const auto neighbor_cluster = cluster_index(neighbor);
+      if (neighbor_cluster == cluster) { continue; }
+
+      const auto &neighbor_nodes = cluster_list_[neighbor_cluster].nodes;
+      const auto found =
+        std::ranges::find_if(neighbor_nodes, [neighbor](const Node &other) { return other.cell == neighbor; });
+      if (found != neighbor_nodes.end()) {
+        const auto index = static_cast<std::size_t>(std::distance(neighbor_nodes.begin(), found));
+        node.crossings.push_back(Edge{ static_cast<std::uint32_t>(neighbor_cluster * max_cluster_nodes + index), 1 });
+      }
+    }
+  }
+}
+
+void Path_Finder::label_components()
+{
+  first_region_.resize(cluster_list_.size());
+  std::size_t total = 0;
+  for (std::size_t index = 0; index < cluster_list_.size(); ++index) {
+    first_region_[index] = static_cast<std::uint32_t>(total);
+    total += cluster_list_[index].region_count;
+  }
+
+  // union find over the regions of all clusters, joined wherever two of them touch across an edge
+  region_components_.resize(total);
+  std::iota(region_components_.begin(), region_components_.end(), std::uint32_t{ 0 });
+
+  const auto find = [this](std::uint32_t region) {
+    while (region_components_[region] != region) {
+      region_components_[region] = region_components_[region_components_[region]];
+      region = region_components_[region];
+    }
+    return region;
+  };
+
+  const auto join = [&](const std::uint32_t lhs_region, const std::uint32_t rhs_region) {
+    const auto lhs = find(lhs_region);
+    const auto rhs = find(rhs_region);
+    region_components_[std::max(lhs, rhs)] = std::min(lhs, rhs);
+  };
+
+  for (std::size_t index = 0; index < cluster_list_.size(); ++index) {
+    for (const auto &[inside, outside] : east_edges_[index].joins) {
+      join(first_region_[index] + inside, first_region_[index + 1] + outside);
+    }
+    for (const auto &[inside, outside] : south_edges_[index].joins) {
+      join(first_region_[index] + inside, first_region_[index + clusters_.width] + outside);
+    }
+  }
+
+  for (std::uint32_t region = 0; region < region_components_.size(); ++region) {
+    region_components_[region] = find(region);
+  }
+
+  components_dirty_ = false;
+}
+
+void Path_Finder::place_landmarks()
+{
+  for (auto &cluster : cluster_list_) {
+    for (auto &node : cluster.nodes) { node.landmark_costs.fill(unreached); }
+  }
+  landmarks_valid_ = true;
+
+  // the landmarks are all in the component with the most nodes, the others do without
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> node_components;// component, node
+  for (std::size_t cluster = 0; cluster < cluster_list_.size(); ++cluster) {
+    const auto &nodes = cluster_list_[cluster].nodes;
+    for (std::size_t node = 0; node < nodes.size(); ++node) {
+      node_components.emplace_back(component(nodes[node].cell), cluster * max_cluster_nodes + node);
+    }
+  }
+  if (node_components.empty()) { return; }
+  std::ranges::sort(node_components);
+
+  std::size_t largest = 0;
+  std::uint32_t start = 0;
+  for (std::size_t first = 0; first < node_components.size();) {
+    auto last = first;
+    while (last < node_components.size() && node_components[last].first == node_components[first].first) { ++last; }
+    if (last - first > largest) {
+      largest = last - first;
+      start = node_components[first].second;
+    }
+    first = last;
+  }
+  measure_landmark(0, start);
+
+  // Each landmark is the node furthest from the ones before it, the first one the furthest from
+  // an arbitrary node. Landmarks on the far edges of the map tell the most about the nodes between.
+  for (std::size_t landmark = 0; landmark < landmark_count; ++landmark) {
+    const auto measured = std::max<std::size_t>(landmark, 1);
+    std::uint32_t furthest_cost = 0;
+    std::uint32_t furthest = 0;
+
+    for (std::size_t cluster = 0; cluster < cluster_list_.size(); ++cluster) {
+      const auto &nodes = cluster_list_[cluster].nodes;
+      for (std::size_t node = 0; node < nodes.size(); ++node) {
+        const auto &costs = nodes[node].landmark_costs;
+        const auto nearest =
+          *std::min_element(costs.begin(), std::next(costs.begin(), static_cast<std::ptrdiff_t>(measured)));
+        if (nearest != unreached && nearest > furthest_cost) {
+          furthest_cost = nearest;
+          furthest = static_cast<std::uint32_t>(cluster * max_cluster_nodes + node);
+        }
+      }
+    }
+
+    if (furthest_cost == 0) { break; }
+    measure_landmark(landmark, furthest);
+  }
+}
+
+void Path_Finder::measure_landmark(const std::size_t landmark, const std::uint32_t origin)
+{
+  const auto stamp = next_stamp(node_search_, node_stamp_);
+  open_.clear();
+
+  const auto relax = [&](const std::uint32_t node, const std::uint32_t cost) {
+    auto &entry = node_search_[node];
+    if (entry.stamp == stamp && entry.cost <= cost) { return; }
+    entry = Node_Entry{ stamp, cost, 0, 0 };
+    open_.push_back(Open_Entry{ cost, cost, node });
+    std::ranges::push_heap(open_, worse);
+  };
+
+  relax(origin, 0);
+  while (!open_.empty()) {
+    std::ranges::pop_heap(open_, worse);
+    const auto current = open_.back();
+    open_.pop_back();
+
+    if (current.cost != node_search_[current.index].cost) { continue; }
+
+    auto &node = cluster_list_[current.index / max_cluster_nodes].nodes[current.index % max_cluster_nodes];
+    node.landmark_costs[landmark] = current.cost;
+    for (const auto &edges : { &node.edges, &node.crossings }) {
+      for (const auto &edge : *edges) { relax(edge.to, current.cost + edge.cost); }
+    }
+  }
+}
+
+Path_Finder::Cluster_Moves Path_Finder::cluster_moves(const std::size_t cluster, const bool reverse) const noexcept
+{
+  const auto &current = cluster_list_[cluster];
+  const auto inside = [&current](const Point cell) {
+    return cell.x - current.origin.x < current.size.width && cell.y - current.origin.y < current.size.height;
+  };
+
+  Cluster_Moves moves{};
+  for (std::size_t cur_y = 0; cur_y < current.size.height; ++cur_y) {
+    for (std::size_t cur_x = 0; cur_x < current.size.width; ++cur_x) {
+      const auto cell = current.origin + Point{ cur_x, cur_y };
+      auto &cell_moves = moves[cur_y * cluster_size + cur_x];
+
+      // a step into a cell only depends on the side of that cell it comes in from
+      for (const auto direction : directions) {
+        const auto neighbor = step(cell, direction);
+        if (!inside(neighbor)) { continue; }
+        const auto entered = reverse ? grid_.unchecked_entry_mask(cell) & side_bit(direction)
+                                     : grid_.unchecked_entry_mask(neighbor) & side_bit(opposite(direction));
+        if (entered != 0) { cell_moves |= side_bit(direction); }
+      }
+    }
+  }
+  return moves;
+}
+
+std::size_t Path_Finder::local_index(const std::size_t cluster, const Point cell) const noexcept
+{
+  const auto &current = cluster_list_[cluster];
+  return (cell.y - current.origin.y) * cluster_size + (cell.x - current.origin.x);
+}
+
+std::size_t Path_Finder::search_cluster(const Cluster_Moves &moves, const std::size_t origin)
+{
+  std::ranges::fill(cluster_distances_, unreached);
+
+  std::array<std::uint16_t, cluster_size * cluster_size> queue;// NOLINT only read where written
+  std::size_t head = 0;
+  std::size_t tail = 0;
+  queue[tail++] = static_cast<std::uint16_t>(origin);
+  cluster_distances_[origin] = 0;
+
+  const auto visit = [&](const std::size_t cell, const std::uint32_t cost, const Direction direction) {
+    if (cluster_distances_[cell] == unreached) {
+      cluster_distances_[cell] = cost;
+      set_step_into(cluster_steps_, cell, direction);
+      queue[tail++] = static_cast<std::uint16_t>(cell);
+    }
+  };
+
+  while (head < tail) {
+    const std::size_t cell = queue[head++];
+    const auto cost = cluster_distances_[cell] + 1;
+    const auto cell_moves = moves[cell];
+
+    if ((cell_moves & side_bit(Direction::North)) != 0) { visit(cell - cluster_size, cost, Direction::North); }
+    if ((cell_moves & side_bit(Direction::South)) != 0) { visit(cell + cluster_size, cost, Direction::South); }
+    if ((cell_moves & side_bit(Direction::East)) != 0) { visit(cell + 1, cost, Direction::East); }
+    if ((cell_moves & side_bit(Direction::West)) != 0) { visit(cell - 1, cost, Direction::West); }
+  }
+
+  return tail;
+}
+
+void Path_Finder::trace_from(const std::size_t cluster,
+  const Cluster_Steps &steps,
+  const Point origin,
+  const Point cell,
+  std::vector<Direction> &path) const
+{
+  const auto first_step = path.size();
+  for (auto current = cell; current != origin;) {
+    const auto direction = step_into(steps, local_index(cluster, current));
+    path.push_back(direction);
+    current = step(current, opposite(direction));
+  }
+  std::reverse(std::next(path.begin(), static_cast<std::ptrdiff_t>(first_step)), path.end());
+}
+
+void Path_Finder::trace_to(const std::size_t cluster,
+  const Cluster_Steps &steps,
+  const Point cell,
+  const Point origin,
+  std::vector<Direction> &path) const
+{
+  // the searches on reversed moves step from the cell nearer to `origin` to the one further away
+  for (auto current = cell; current != origin;) {
+    const auto direction = opposite(step_into(steps, local_index(cluster, current)));
+    path.push_back(direction);
+    current = step(current, direction);
+  }
+}
+
+std::optional<std::vector<Direction>> Path_Finder::find_hierarchical_path(const Point from, const Point to)
+{
+  hierarchical_ = true;
+
+  const auto start_cluster = cluster_index(from);
+  const auto goal_cluster = cluster_index(to);
+  const auto &start_nodes = cluster_list_[start_cluster].nodes;
+  const auto &goal_nodes = cluster_list_[goal_cluster].nodes;
+
+  // The start and the goal are joined to the nodes of their clusters for this query only. The
+  // searches that measure those legs also trace them.
+  cells_expanded_ += search_cluster(cluster_moves(goal_cluster, true), local_index(goal_cluster, to));
+  const auto goal_steps = cluster_steps_;
+  goal_costs_.clear();
+  for (const auto &node : goal_nodes) {
+    goal_costs_.push_back(cluster_distances_[local_index(goal_cluster, node.cell)]);
+  }
+  const auto direct_cost =
+    start_cluster == goal_cluster ? cluster_distances_[local_index(goal_cluster, from)] : unreached;
+
+  cells_expanded_ += search_cluster(cluster_moves(start_cluster, false), local_index(start_cluster, from));
+  const auto start_steps = cluster_steps_;
+  start_costs_.clear();
+  for (const auto &node : start_nodes) {
+    start_costs_.push_back(cluster_distances_[local_index(start_cluster, node.cell)]);
+  }
+
+  const auto node_id = [](const std::size_t cluster, const std::size_t node) {
+    return static_cast<std::uint32_t>(cluster * max_cluster_nodes + node);
+  };
+  const auto node_at = [this](const std::uint32_t node) -> const Node & {
+    return cluster_list_[node / max_cluster_nodes].nodes[node % max_cluster_nodes];
+  };
+  const auto start_id = static_cast<std::uint32_t>(node_search_.size() - 2);
+  const auto goal_id = static_cast<std::uint32_t>(node_search_.size() - 1);
+
+  // The distance from each landmark to the goal, through the nodes of its cluster. Unknown if
+  // one of those nodes is new since the landmarks were measured, it could be the closest one.
+  std::array<std::uint32_t, landmark_count> goal_landmark_costs{};
+  goal_landmark_costs.fill(unreached);
+  for (std::size_t landmark = 0; landmarks_valid_ && landmark < landmark_count; ++landmark) {
+    auto &goal_cost = goal_landmark_costs[landmark];
+    for (std::size_t node = 0; node < goal_nodes.size(); ++node) {
+      if (goal_costs_[node] == unreached) { continue; }
+      const auto cost = goal_nodes[node].landmark_costs[landmark];
+      if (cost == unreached) {
+        goal_cost = unreached;
+        break;
+      }
+      goal_cost = std::min(goal_cost, cost + goal_costs_[node]);
+    }
+  }
+
+  // a lower bound of the distance left to the goal, inflated for weighted A*
+  const auto symmetric = one_way_cells_ == 0;
+  const auto estimate = [&](const std::uint32_t node) {
+    if (node == goal_id) { return std::uint32_t{ 0 }; }
+
+    const auto &current = node_at(node);
+    auto remaining = distance(current.cell, to);
+    for (std::size_t landmark = 0; landmark < landmark_count; ++landmark) {
+      const auto goal_cost = goal_landmark_costs[landmark];
+      const auto cost = current.landmark_costs[landmark];
+      if (goal_cost == unreached || cost == unreached) { continue; }
+
+      if (goal_cost > cost) {
+        remaining = std::max(remaining, goal_cost - cost);
+      } else if (symmetric) {
+        remaining = std::max(remaining, cost - goal_cost);
+      }
+    }
+    return remaining * node_estimate_quarters / 4;
+  };
+
+  const auto stamp = next_stamp(node_search_, node_stamp_);
+  open_.clear();
+
+  const auto relax = [&](const std::uint32_t node, const std::uint32_t cost, const std::uint32_t parent) {
+    auto &entry = node_search_[node];
+    if (entry.stamp == stamp && (entry.closed || entry.cost <= cost)) { return; }
+    const auto remaining = entry.stamp == stamp ? entry.estimate : estimate(node);
+    entry = Node_Entry{ stamp, cost, parent, remaining, false };
+    open_.push_back(Open_Entry{ cost + remaining, cost, node });
+    std::ranges::push_heap(open_, worse);
+  };
+
+  node_search_[start_id] = Node_Entry{ stamp, 0, start_id, 0 };
+  for (std::size_t node = 0; node < start_nodes.size(); ++node) {
+    if (start_costs_[node] != unreached) {
+      relax(node_id(start_cluster, node), start_costs_[node], start_id);
+    }
+  }
+  if (direct_cost != unreached) { relax(goal_id, direct_cost, start_id); }
+
+  bool found = false;
+  while (!open_.empty()) {
+    std::ranges::pop_heap(open_, worse);
+    const auto current = open_.back();
+    open_.pop_back();
+
+    if (current.cost != node_search_[current.index].cost) { continue; }// a better way was found since
+    if (current.index == goal_id) {
+      found = true;
+      break;
+    }
+
+    ++nodes_expanded_;
+    node_search_[current.index].closed = true;
+
+    const auto cluster = current.index / max_cluster_nodes;
+    const auto index = current.index % max_cluster_nodes;
+    const auto &node = node_at(current.index);
+
+    for (const auto &edges : { &node.edges, &node.crossings }) {
+      for (const auto &edge : *edges) { relax(edge.to, current.cost + edge.cost, current.index); }
+    }
+
+    if (cluster == goal_cluster && goal_costs_[index] != unreached) {
+      relax(goal_id, current.cost + goal_costs_[index], current.index);
+    }
+  }
+
+  if (!found) { return std::nullopt; }
+
+  // the nodes the path goes through, then the steps between them
+  std::vector<std::uint32_t> nodes;
+  for (auto node = node_search_[goal_id].parent; node != start_id; node = node_search_[node].parent) {
+    nodes.push_back(node);
+  }
+  std::ranges::reverse(nodes);
+
+  std::vector<Direction> path;
+  if (nodes.empty()) {
+    trace_to(goal_cluster, goal_steps, from, to, path);
+    return path;
+  }
+
+  trace_from(start_cluster, start_steps, from, node_at(nodes.front()).cell, path);
+  for (std::size_t node = 1; node < nodes.size(); ++node) {
+    const auto &leg_from = node_at(nodes[node - 1]);
+    const auto &leg_to = node_at(nodes[node]);
+    const auto cluster = nodes[node - 1] / max_cluster_nodes;
+
+    if (cluster != nodes[node] / max_cluster_nodes) {
+      path.push_back(direction_between(leg_from.cell, leg_to.cell));
+    } else {
+      trace_from(cluster, leg_from.steps, leg_from.cell, leg_to.cell, path);
+    }
+  }
+  trace_to(goal_cluster, goal_steps, node_at(nodes.back()).cell, to, path);
+
+  return path;
+}
+
+bool Path_Finder::search_cells(const Point from,
+  const Point to,
+  const Point origin,
+  const Size area,
+  const std::size_t budget,
+  std::vector<Direction> &path)
+{
+  const auto width = grid_.size().width;
+  const auto index = [width](const Point cell) { return static_cast<std::uint32_t>(cell.y * width + cell.x); };
+  const auto inside = [origin, area](const Point cell) {
+    return cell.x - origin.x < area.width && cell.y - origin.y < area.height;
+  };
+
+  const auto stamp = next_stamp(cell_search_, cell_stamp_);
+  open_.clear();
+
+  cell_search_[index(from)] = Cell_Entry{ stamp, 0, {} };
+  open_.push_back(Open_Entry{ distance(from, to), 0, index(from) });
+
+  std::size_t expanded = 0;
+  while (!open_.empty()) {
+    std::ranges::pop_heap(open_, worse);
+    const auto current = open_.back();
+    open_.pop_back();
+
+    if (current.cost != cell_search_[current.index].cost) { continue; }// a better way was found since
+
+    const auto cell = Point{ current.index % width, current.index / width };
+    if (cell == to) {
+      const auto first_step = path.size();
+      for (auto back = to; back != from;) {
+        const auto direction = cell_search_[index(back)].parent;
+        path.push_back(direction);
+        back = step(back, opposite(direction));
+      }
+      std::reverse(std::next(path.begin(), static_cast<std::ptrdiff_t>(first_step)), path.end());
+
+      cells_expanded_ += expanded;
+      return true;
+    }
+
+    if (expanded == budget) { break; }
+    ++expanded;
+
+    for (const auto direction : directions) {
+      if (!grid_.can_step(cell, direction)) { continue; }
+      const auto neighbor = step(cell, direction);
+      if (!inside(neighbor)) { continue; }
+
+      const auto cost = current.cost + 1;
+      auto &entry = cell_search_[index(neighbor)];
+      if (entry.stamp == stamp && entry.cost <= cost) { continue; }
+
+      entry = Cell_Entry{ stamp, cost, direction };
+      open_.push_back(Open_Entry{ cost + distance(neighbor, to), cost, index(neighbor) });
+      std::ranges::push_heap(open_, worse);
+    }
+  }
+
+  cells_expanded_ += expanded;
+  return false;
+}
+
+}// namespace lefticus::travels
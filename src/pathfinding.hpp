@@ -0,0 +1,337 @@
+#ifndef AWESOME_GAME_PATHFINDING_HPP
+#define AWESOME_GAME_PATHFINDING_HPP
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "game_components.hpp"
+#include "point.hpp"
+#include "size.hpp"
+#include "vector2d.hpp"
+
+namespace lefticus::travels {
+
+[[nodiscard]] constexpr std::uint8_t side_bit(const Direction side) noexcept
+{
+  return static_cast<std::uint8_t>(1U << static_cast<unsigned>(side));
+}
+
+[[nodiscard]] constexpr Direction opposite(const Direction direction) noexcept
+{
+  switch (direction) {
+  case Direction::North:
+    return Direction::South;
+  case Direction::South:
+    return Direction::North;
+  case Direction::East:
+    return Direction::West;
+  case Direction::West:
+  default:
+    return Direction::East;
+  }
+}
+
+// the neighboring cell in `direction`, the caller checks that it is on the map
+[[nodiscard]] constexpr Point step(const Point cell, const Direction direction) noexcept
+{
+  switch (direction) {
+  case Direction::North:
+    return Point{ cell.x, cell.y - 1 };
+  case Direction::South:
+    return Point{ cell.x, cell.y + 1 };
+  case Direction::East:
+    return Point{ cell.x + 1, cell.y };
+  case Direction::West:
+  default:
+    return Point{ cell.x - 1, cell.y };
+  }
+}
+
+// The sides of `cell` it can be entered from, as `side_bit`s, asking `Game_Map::can_enter_from`.
+[[nodiscard]] std::uint8_t entry_mask(const Game &game, const Game_Map &map, Point cell);
+
+// A snapshot of which sides each cell of a map can be entered from. Scripted `can_enter`s are
+// only asked when the grid is built or a cell is updated, so a cell whose answer depends on the
+// game state has to be updated when that state changes.
+class Passability_Grid
+{
+public:
+  static constexpr std::uint8_t all_sides = 0xF;
+
+  // every cell can be entered from every side
+  explicit Passability_Grid(const Size size) : masks_{ size } { fill(masks_, all_sides); }
+
+  Passability_Grid(const Game &game, const Game_Map &map);
+
+  [[nodiscard]] Size size() const noexcept { return masks_.size(); }
+
+  // throws std::range_error if `cell` is not on the map
+  [[nodiscard]] std::uint8_t entry_mask(const Point cell) const { return masks_.at(cell); }
+  void set_entry_mask(const Point cell, const std::uint8_t mask) { masks_.at(cell) = mask & all_sides; }
+  [[nodiscard]] std::uint8_t unchecked_entry_mask(const Point cell) const noexcept { return masks_.unchecked_at(cell); }
+
+  // true if the step in `direction` from `cell` stays on the map, and the cell it leads to can
+  // be entered from the side it comes from
+  [[nodiscard]] bool can_step(const Point cell, const Direction direction) const noexcept
+  {
+    switch (direction) {
+    case Direction::North:
+      if (cell.y == 0) { return false; }
+      break;
+    case Direction::South:
+      if (cell.y + 1 >= size().height) { return false; }
+      break;
+    case Direction::East:
+      if (cell.x + 1 >= size().width) { return false; }
+      break;
+    case Direction::West:
+      if (cell.x == 0) { return false; }
+      break;
+    }
+
+    return (masks_.unchecked_at(step(cell, direction)) & side_bit(opposite(direction))) != 0;
+  }
+
+private:
+  Vector2D<std::uint8_t> masks_;
+};
+
+// Finds the steps between two cells of a Passability_Grid.
+//
+// Paths between nearby cells are searched for with A* over the cells. Longer ones are searched
+// for HPA* style: the map is split into clusters of `cluster_size` cells square, the cells on
+// either side of each opening between two clusters become nodes of a much smaller graph, and the
+// distances between the nodes of a cluster are computed up front, along with the steps of the
+// shortest ways between them. A* over that graph finds which openings the path goes through, and
+// the legs inside each cluster are traced from those steps. These paths are usually a few
+// percent longer than the shortest ones.
+//
+// The search through the clusters is steered by the distances from a few landmark nodes, ALT
+// style: by the triangle inequality a node can't be closer to the goal than the difference of
+// their distances from any landmark. Unlike the straight line distance that holds up in maps
+// where the way around walls is much longer than the way through them.
+//
+// Every cell is also labeled with a connected component, so that a query between two cells that
+// can't possibly be connected returns right away instead of searching the whole map.
+//
+// Changing a cell only rebuilds the clusters next to it, the components are labeled again on the
+// next query that needs them. Closing cells off leaves the landmark distances good enough, they
+// can only have grown, but opening cells up turns the landmarks off until `place_landmarks` is
+// called again. A Path_Finder must only be used from one thread at a time.
+class Path_Finder
+{
+public:
+  static constexpr std::size_t cluster_size = 16;
+
+  // paths between cells closer than this are searched for on the cells first
+  static constexpr std::size_t direct_search_distance = 48;
+
+  // the most cells a search on the cells expands before it gives up and goes through the clusters
+  static constexpr std::size_t direct_search_budget = 4096;
+
+  static constexpr std::size_t unlimited = std::numeric_limits<std::size_t>::max();
+
+  static constexpr std::size_t landmark_count = 8;
+
+  explicit Path_Finder(Passability_Grid grid);
+
+  Path_Finder(const Game &game, const Game_Map &map) : Path_Finder(Passability_Grid{ game, map }) {}
+
+  [[nodiscard]] const Passability_Grid &grid() const noexcept { return grid_; }
+
+  // Changes the sides `cell` can be entered from, and rebuilds the clusters around it.
+  // throws std::range_error if `cell` is not on the map
+  void set_entry_mask(Point cell, std::uint8_t mask);
+
+  // reads `cell` from `map` again, for when whether it can be entered changed
+  void update(const Game &game, const Game_Map &map, Point cell) { set_entry_mask(cell, entry_mask(game, map, cell)); }
+
+  // Picks the landmarks and measures the distances from them to every node, a search over the
+  // whole graph between clusters for each landmark. Done on construction, and worth doing again
+  // once cells were opened up, when there is time for it.
+  void place_landmarks();
+
+  // Cells in different components are never connected. Cells in the same component are, unless
+  // some cells can only be entered from some sides. Nothing leads to a cell that can't be entered,
+  // whatever its component.
+  [[nodiscard]] std::uint32_t component(Point cell);
+
+  // The steps that lead from `from` to `to`, none if they are the same cell, or nothing if there
+  // is no way there. throws std::range_error if either cell is not on the map
+  [[nodiscard]] std::optional<std::vector<Direction>> find_path(Point from, Point to);
+
+  // A* over the cells only, always the shortest path. Gives up, returning nothing, once
+  // `budget` cells were expanded.
+  [[nodiscard]] std::optional<std::vector<Direction>>
+    find_shortest_path(Point from, Point to, std::size_t budget = unlimited);
+
+  struct Stats
+  {
+    std::size_t clusters = 0;
+    std::size_t nodes = 0;// of the graph between clusters
+    std::size_t cells_expanded = 0;// by the last query
+    std::size_t nodes_expanded = 0;// by the last query
+    bool hierarchical = false;// if the last query went through the clusters
+    bool landmarks = false;// if the landmarks are up to date enough to be used
+  };
+
+  [[nodiscard]] Stats stats() const noexcept;
+
+private:
+  static constexpr std::uint32_t unreached = std::numeric_limits<std::uint32_t>::max();
+
+  // a cluster can't have more nodes than it has cells on its edges
+  static constexpr std::size_t max_cluster_nodes = 4 * cluster_size;
+
+  struct Edge
+  {
+    std::uint32_t to = 0;// cluster * max_cluster_nodes + index into its `nodes`
+    std::uint32_t cost = 0;
+  };
+
+  // The step that leads into each cell of a cluster on a shortest way between it and some origin,
+  // as 2 bits indexed by `local_index`. Following them back from any cell that was reached traces
+  // the way, without searching again.
+  using Cluster_Steps = std::array<std::uint8_t, cluster_size * cluster_size / 4>;
+
+  struct Node
+  {
+    Point cell;
+    std::vector<Edge> edges;// to the other nodes of the same cluster
+    std::vector<Edge> crossings;// to the nodes of neighboring clusters, one step away
+    std::array<std::uint32_t, landmark_count> landmark_costs;// from each landmark, or `unreached`
+    Cluster_Steps steps;// from `cell` to the rest of its cluster
+  };
+
+  struct Cluster
+  {
+    Point origin;
+    Size size;
+    std::vector<Node> nodes;
+    std::size_t region_count = 0;
+  };
+
+  // the cells on either side of an opening between two clusters, `inside` is in the cluster to
+  // the west or north
+  struct Transition
+  {
+    Point inside;
+    Point outside;
+
+    friend bool operator==(const Transition &, const Transition &) = default;
+  };
+
+  // what is known about the east or south edge of a cluster
+  struct Cluster_Edge
+  {
+    std::vector<Transition> transitions;
+    std::vector<std::pair<std::uint8_t, std::uint8_t>> joins;// regions on either side that touch
+  };
+
+  [[nodiscard]] std::size_t cluster_index(Point cell) const noexcept;
+  // A step is possible between the two cells in at least one direction. Steps out of cells that
+  // can't be entered don't count, those cells can only ever be where a path starts.
+  [[nodiscard]] bool linked(Point cell, Direction direction) const noexcept;
+  // a step is possible between the two cells in both directions
+  [[nodiscard]] bool two_way(Point cell, Direction direction) const noexcept;
+
+  void build_regions(std::size_t cluster);
+  // returns true if the transitions changed
+  bool build_edge(std::size_t cluster, Direction edge);
+  void build_nodes(std::size_t cluster);
+  void build_crossings(std::size_t cluster);
+  void label_components();
+  // Dijkstra over the graph between clusters, from `origin` to every node
+  void measure_landmark(std::size_t landmark, std::uint32_t origin);
+
+  // the steps possible from each cell of a cluster without leaving it, as `side_bit`s, indexed
+  // by `local_index`. With `reverse` the steps that lead into each cell instead.
+  using Cluster_Moves = std::array<std::uint8_t, cluster_size * cluster_size>;
+  [[nodiscard]] Cluster_Moves cluster_moves(std::size_t cluster, bool reverse) const noexcept;
+  [[nodiscard]] std::size_t local_index(std::size_t cluster, Point cell) const noexcept;
+
+  // Breadth first search from `origin` following `moves`, fills `cluster_distances_` and
+  // `cluster_steps_`. Returns the number of cells reached.
+  std::size_t search_cluster(const Cluster_Moves &moves, std::size_t origin);
+
+  // Append the steps from `origin` to `cell`, with `steps` from a search out of `origin`, and the
+  // steps from `cell` to `origin`, with `steps` from a search into `origin` on reversed moves.
+  void trace_from(
+    std::size_t cluster, const Cluster_Steps &steps, Point origin, Point cell, std::vector<Direction> &path) const;
+  void trace_to(
+    std::size_t cluster, const Cluster_Steps &steps, Point cell, Point origin, std::vector<Direction> &path) const;
+
+  [[nodiscard]] std::optional<std::vector<Direction>> route(Point from, Point to);
+  [[nodiscard]] std::optional<std::vector<Direction>> find_hierarchical_path(Point from, Point to);
+
+  // A* over the cells inside of `origin` and `area`, appending the steps to `path`
+  [[nodiscard]] bool
+    search_cells(Point from, Point to, Point origin, Size area, std::size_t budget, std::vector<Direction> &path);
+
+  Passability_Grid grid_;
+  Size clusters_;
+  std::vector<Cluster> cluster_list_;
+  std::size_t node_count_ = 0;
+
+  std::vector<Cluster_Edge> east_edges_;
+  std::vector<Cluster_Edge> south_edges_;
+
+  // Which of its cluster's regions each cell is in, cells of a region are linked without leaving
+  // the cluster. The cells of a cluster that can't be entered share one region.
+  Vector2D<std::uint8_t> regions_;
+
+  std::vector<std::uint32_t> first_region_;// of each cluster, in `region_components_`
+  std::vector<std::uint32_t> region_components_;
+  bool components_dirty_ = true;
+
+  bool landmarks_valid_ = false;
+  // cells that can be entered from some sides but not from others, without them every distance
+  // between nodes is the same both ways
+  std::size_t one_way_cells_ = 0;
+
+  // scratch space reused by every query, entries are only valid if their stamp is the current one
+  struct Cell_Entry
+  {
+    std::uint32_t stamp = 0;
+    std::uint32_t cost = 0;
+    Direction parent{};// the step that led here
+  };
+
+  struct Node_Entry
+  {
+    std::uint32_t stamp = 0;
+    std::uint32_t cost = 0;
+    std::uint32_t parent = 0;
+    std::uint32_t estimate = 0;// of the cost left, it is the same however the node was reached
+    bool closed = false;
+  };
+
+  struct Open_Entry
+  {
+    std::uint32_t estimate;
+    std::uint32_t cost;
+    std::uint32_t index;
+  };
+
+  std::vector<Cell_Entry> cell_search_;
+  std::vector<Node_Entry> node_search_;
+  std::vector<Open_Entry> open_;
+  std::uint32_t cell_stamp_ = 0;
+  std::uint32_t node_stamp_ = 0;
+  std::vector<std::uint32_t> cluster_distances_;
+  Cluster_Steps cluster_steps_{};
+  std::vector<std::uint32_t> start_costs_;// from the start to each node of its cluster
+  std::vector<std::uint32_t> goal_costs_;// from each node of its cluster to the goal
+
+  std::size_t cells_expanded_ = 0;
+  std::size_t nodes_expanded_ = 0;
+  bool hierarchical_ = false;
+};
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_PATHFINDING_HPP
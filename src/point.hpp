@@ -2,6 +2,7 @@
 #define AWESOME_GAME_POINT_HPP
 
 #include <cstdint>
+#include <functional>
 
 namespace lefticus::travels {
 struct Point
@@ -24,4 +25,12 @@ struct Point
 };
 }// namespace lefticus::travels
 
+template<> struct std::hash<lefticus::travels::Point>
+{
+  [[nodiscard]] std::size_t operator()(const lefticus::travels::Point &point) const noexcept
+  {
+    return std::hash<std::size_t>{}(point.x * 73856093U ^ point.y * 19349663U);// NOLINT magic numbers
+  }
+};
+
 #endif// AWESOME_GAME_POINT_HPP
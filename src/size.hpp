@@ -8,6 +8,8 @@ struct Size
 {
   std::size_t width;
   std::size_t height;
+
+  friend bool operator==(const Size &, const Size &) = default;
 };
 }// namespace lefticus::travels
 
@@ -0,0 +1,52 @@
+#include "thread_pool.hpp"
+
+namespace lefticus::travels {
+
+Thread_Pool::Thread_Pool(const std::size_t thread_count)
+{
+  threads_.reserve(thread_count);
+  for (std::size_t thread = 0; thread < thread_count; ++thread) {
+    threads_.emplace_back([this] { run(); });
+  }
+}
+
+Thread_Pool::~Thread_Pool()
+{
+  {
+    const std::scoped_lock lock{ mutex_ };
+    stop_ = true;
+  }
+  wake_up_.notify_all();
+
+  for (auto &thread : threads_) { thread.join(); }
+}
+
+void Thread_Pool::post(std::function<void()> task)
+{
+  {
+    const std::scoped_lock lock{ mutex_ };
+    tasks_.push_back(std::move(task));
+  }
+  wake_up_.notify_one();
+}
+
+void Thread_Pool::run()
+{
+  std::unique_lock lock{ mutex_ };
+
+  while (true) {
+    wake_up_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+
+    // the queue is drained before stopping, a running task can still add to it
+    if (tasks_.empty()) { return; }
+
+    auto task = std::move(tasks_.front());
+    tasks_.pop_front();
+
+    lock.unlock();
+    task();
+    lock.lock();
+  }
+}
+
+}// namespace lefticus::travels
@@ -0,0 +1,71 @@
+#ifndef AWESOME_GAME_THREAD_POOL_HPP
+#define AWESOME_GAME_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace lefticus::travels {
+
+// A fixed set of worker threads running tasks in the order they were submitted.
+//
+// Tasks may submit more tasks, but must not wait on the future of another task of the same
+// pool, that can deadlock once every worker is waiting. Chain the work instead: submit the next
+// step from the end of the previous one.
+//
+// The destructor runs everything that was submitted, including tasks submitted while it waits.
+class Thread_Pool
+{
+public:
+  explicit Thread_Pool(std::size_t thread_count = default_thread_count());
+
+  Thread_Pool(const Thread_Pool &) = delete;
+  Thread_Pool &operator=(const Thread_Pool &) = delete;
+  Thread_Pool(Thread_Pool &&) = delete;
+  Thread_Pool &operator=(Thread_Pool &&) = delete;
+  ~Thread_Pool();
+
+  [[nodiscard]] static std::size_t default_thread_count() noexcept
+  {
+    return std::max(std::size_t{ 1 }, std::size_t{ std::thread::hardware_concurrency() });
+  }
+
+  [[nodiscard]] std::size_t thread_count() const noexcept { return threads_.size(); }
+
+  // `task` must not throw, use `submit` for anything that can fail
+  void post(std::function<void()> task);
+
+  // any exception thrown by `function` is passed on through the future
+  template<typename Function> [[nodiscard]] auto submit(Function function)
+  {
+    using Result = std::invoke_result_t<Function &>;
+
+    // std::function needs a copyable callable, the packaged_task itself is move only
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::move(function));
+    auto result = task->get_future();
+    post([task = std::move(task)] { (*task)(); });
+    return result;
+  }
+
+private:
+  void run();
+
+  std::mutex mutex_;
+  std::condition_variable wake_up_;
+  std::deque<std::function<void()>> tasks_;
+  bool stop_ = false;
+
+  std::vector<std::thread> threads_;
+};
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_THREAD_POOL_HPP
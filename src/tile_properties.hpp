@@ -0,0 +1,108 @@
+#ifndef AWESOME_GAME_TILE_PROPERTIES_HPP
+#define AWESOME_GAME_TILE_PROPERTIES_HPP
+
+#include <cstdint>
+#include <fmt/format.h>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace lefticus::travels {
+
+// The custom properties of every tile in a tile set, indexed by tile id (gid - first gid).
+//
+// Each property name is one dense, typed column with a slot for every tile, so once a column
+// has been looked up by name, reading the property of any tile is a single index.
+class Tile_Properties
+{
+public:
+  using Value = std::variant<bool, std::int64_t, double, std::string>;
+
+  template<typename T> using Column = std::vector<std::optional<T>>;
+  using Any_Column = std::variant<Column<bool>, Column<std::int64_t>, Column<double>, Column<std::string>>;
+
+  explicit Tile_Properties(const std::size_t tile_count = 0) : tile_count_{ tile_count } {}
+
+  [[nodiscard]] std::size_t tile_count() const noexcept { return tile_count_; }
+
+  // throws if `tile` is out of range, or `name` already holds values of a different type
+  void set(const std::size_t tile, const std::string_view name, Value value)
+  {
+    if (tile >= tile_count_) {
+      throw std::out_of_range(fmt::format("Tile {} is out of range for {} tiles", tile, tile_count_));
+    }
+
+    std::visit(
+      [&](auto &&typed_value) {
+        using Type = std::decay_t<decltype(typed_value)>;
+        auto &any_column = find_or_add_column<Type>(name);
+        auto *values = std::get_if<Column<Type>>(&any_column);
+        if (values == nullptr) {
+          throw std::runtime_error(fmt::format("Tile property '{}' has values of more than one type", name));
+        }
+        (*values)[tile] = std::forward<decltype(typed_value)>(typed_value);
+      },
+      std::move(value));
+  }
+
+  // nullptr if no tile has a `name` property of type `T`
+  template<typename T> [[nodiscard]] const Column<T> *column(const std::string_view name) const noexcept
+  {
+    for (const auto &[column_name, any_column] : columns_) {
+      if (column_name == name) { return std::get_if<Column<T>>(&any_column); }
+    }
+    return nullptr;
+  }
+
+  template<typename T> [[nodiscard]] std::optional<T> get(const std::size_t tile, const std::string_view name) const
+  {
+    if (const auto *values = column<T>(name); values != nullptr && tile < values->size()) { return (*values)[tile]; }
+    return std::nullopt;
+  }
+
+  // Where the `name` column of type `T` is, nothing if no tile has that property. Columns never
+  // move, so callers that read the same property a lot look it up once and use `at` after that.
+  template<typename T> [[nodiscard]] std::optional<std::size_t> column_index(const std::string_view name) const noexcept
+  {
+    for (std::size_t index = 0; index < columns_.size(); ++index) {
+      const auto &[column_name, any_column] = columns_[index];
+      if (column_name == name && std::holds_alternative<Column<T>>(any_column)) { return index; }
+    }
+    return std::nullopt;
+  }
+
+  // `column` comes from `column_index<T>`
+  template<typename T> [[nodiscard]] std::optional<T> at(const std::size_t tile, const std::size_t column) const
+  {
+    const auto &values = std::get<Column<T>>(columns_[column].second);
+    if (tile < values.size()) { return values[tile]; }
+    return std::nullopt;
+  }
+
+  // calls `function(std::string_view name, const Any_Column &)` for each property
+  template<typename Function> void for_each_column(Function &&function) const
+  {
+    for (const auto &[name, any_column] : columns_) { function(std::string_view{ name }, any_column); }
+  }
+
+private:
+  template<typename T> Any_Column &find_or_add_column(const std::string_view name)
+  {
+    for (auto &[column_name, any_column] : columns_) {
+      if (column_name == name) { return any_column; }
+    }
+    return columns_.emplace_back(std::string{ name }, Column<T>(tile_count_)).second;
+  }
+
+  std::size_t tile_count_;
+  // there are only ever a handful of distinct property names, a flat list is the fastest lookup
+  std::vector<std::pair<std::string, Any_Column>> columns_;
+};
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_TILE_PROPERTIES_HPP
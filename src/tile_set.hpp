@@ -4,29 +4,42 @@
 
 #include <cassert>
 #include <filesystem>
+#include <memory>
+#include <optional>
 
 #include "bitmap.hpp"
 #include "color.hpp"
+#include "tile_properties.hpp"
 
 
 namespace lefticus::travels {
 
 struct Tile_Set
 {
-  struct Tile_Properties
+  // `image` and `properties` can be shared with other tile sets, see Asset_Registry
+  Tile_Set(std::shared_ptr<const Vector2D<Color>> image,
+    Size tile_size_,
+    std::size_t start_id_,
+    std::shared_ptr<const Tile_Properties> properties_ = nullptr)
+    : properties{ std::move(properties_) }, data{ std::move(image) }, tile_size{ tile_size_ },
+      sheet_size{ data->size().width / tile_size.width, data->size().height / tile_size.height }, start_id{ start_id_ }
   {
-    bool passable = false;
-  };
+    if (!properties) { properties = std::make_shared<const Tile_Properties>(sheet_size.width * sheet_size.height); }
+    passable_column = properties->column_index<bool>("passable");
+  }
+
+  Tile_Set(Vector2D<Color> image, Size tile_size_, std::size_t start_id_)
+    : Tile_Set(std::make_shared<const Vector2D<Color>>(std::move(image)), tile_size_, start_id_)
+  {}
 
   Tile_Set(const std::filesystem::path &image, Size tile_size_, std::size_t start_id_)
-    : data{ load_png(image) }, tile_size{ tile_size_ },
-      sheet_size{ data.size().width / tile_size.width, data.size().height / tile_size.height }, start_id{ start_id_ }
+    : Tile_Set(load_png(image), tile_size_, start_id_)
   {}
 
   // gets a view of the tile at a certain location
   [[nodiscard]] Vector2D_Span<const Color> at(Point point) const
   {
-    return Vector2D_Span<const Color>(Point{ point.x * tile_size.width, point.y * tile_size.height }, tile_size, data);
+    return Vector2D_Span<const Color>(Point{ point.x * tile_size.width, point.y * tile_size.height }, tile_size, *data);
   }
 
   [[nodiscard]] Vector2D_Span<const Color> at(std::size_t id) const
@@ -38,13 +51,38 @@ struct Tile_Set
     return at(Point{ x, y });
   }
 
-  std::map<std::size_t, Tile_Properties> properties;
+  // the tile's custom property `name`, if it has one of type `T`
+  template<typename T> [[nodiscard]] std::optional<T> property(std::size_t id, std::string_view name) const
+  {
+    return properties->get<T>(id - start_id, name);
+  }
+
+  // the same, with a `column` from `property_column<T>` instead of looking the name up every time
+  template<typename T> [[nodiscard]] std::optional<T> property(std::size_t id, std::size_t column) const
+  {
+    return properties->at<T>(id - start_id, column);
+  }
+
+  template<typename T> [[nodiscard]] std::optional<std::size_t> property_column(std::string_view name) const noexcept
+  {
+    return properties->column_index<T>(name);
+  }
+
+  // tiles are passable unless they have a `passable` property saying otherwise
+  [[nodiscard]] bool passable(std::size_t id) const
+  {
+    return !passable_column || property<bool>(id, *passable_column).value_or(true);
+  }
+
+  // indexed by id - start_id
+  std::shared_ptr<const Tile_Properties> properties;
 
 private:
-  Vector2D<Color> data;
+  std::shared_ptr<const Vector2D<Color>> data;
   Size tile_size;
   Size sheet_size;
   std::size_t start_id;
+  std::optional<std::size_t> passable_column;// looked up once, `passable` is on the path of every move
 };
 
 }// namespace lefticus::travels
@@ -0,0 +1,106 @@
+#include "variables.hpp"
+
+#include <atomic>
+#include <deque>
+#include <fmt/format.h>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace lefticus::travels {
+
+namespace {
+  struct String_Hash
+  {
+    using is_transparent = void;
+    [[nodiscard]] std::size_t operator()(const std::string_view name) const noexcept
+    {
+      return std::hash<std::string_view>{}(name);
+    }
+  };
+
+  struct Variable_Names
+  {
+    std::mutex mutex;
+    std::deque<std::string> names;// by slot, a deque never moves its elements
+    std::unordered_map<std::string_view, std::uint32_t, String_Hash, std::equal_to<>> slots;
+  };
+
+  Variable_Names &variable_names()
+  {
+    static Variable_Names names;
+    return names;
+  }
+}// namespace
+
+
+Variable_Slot Variable_Slot::intern(const std::string_view name)
+{
+  auto &names = variable_names();
+  const std::scoped_lock lock{ names.mutex };
+
+  if (const auto slot = names.slots.find(name); slot != names.slots.end()) { return Variable_Slot{ slot->second }; }
+
+  if (names.names.size() >= std::numeric_limits<std::uint32_t>::max()) {
+    throw std::length_error("Too many game variable names");
+  }
+
+  const auto index = static_cast<std::uint32_t>(names.names.size());
+  names.slots.emplace(names.names.emplace_back(name), index);
+  return Variable_Slot{ index };
+}
+
+const std::string &Variable_Slot::name() const
+{
+  auto &names = variable_names();
+  const std::scoped_lock lock{ names.mutex };
+  return names.names[index_];
+}
+
+
+std::uint64_t Variables::next_id() noexcept
+{
+  static std::atomic<std::uint64_t> last_id = 0;
+  return ++last_id;
+}
+
+Variable &Variables::operator[](const Variable_Slot slot)
+{
+  if (slot.index() >= entries_.size()) { entries_.resize(slot.index() + 1); }
+
+  auto &entry = entries_[slot.index()];
+  if (!entry.value) { entry.value.emplace(); }
+  entry.version = ++version_;
+  return *entry.value;
+}
+
+Variable &Variables::at(const Variable_Slot slot)
+{
+  if (auto *value = find(slot); value != nullptr) { return *value; }
+  throw std::out_of_range(fmt::format("No game variable named '{}'", slot.name()));
+}
+
+const Variable &Variables::at(const Variable_Slot slot) const
+{
+  if (const auto *value = find(slot); value != nullptr) { return *value; }
+  throw std::out_of_range(fmt::format("No game variable named '{}'", slot.name()));
+}
+
+Variable *Variables::find(const Variable_Slot slot) noexcept
+{
+  if (slot.index() >= entries_.size() || !entries_[slot.index()].value) { return nullptr; }
+
+  auto &entry = entries_[slot.index()];
+  entry.version = ++version_;
+  return &*entry.value;
+}
+
+const Variable *Variables::find(const Variable_Slot slot) const noexcept
+{
+  if (slot.index() >= entries_.size() || !entries_[slot.index()].value) { return nullptr; }
+  return &*entries_[slot.index()].value;
+}
+
+}// namespace lefticus::travels
@@ -0,0 +1,147 @@
+#ifndef AWESOME_GAME_VARIABLES_HPP
+#define AWESOME_GAME_VARIABLES_HPP
+
+#include <algorithm>
+#include <compare>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace lefticus::travels {
+
+using Variable = std::variant<double, std::int64_t, std::string, bool>;
+
+// A game variable name, interned to a small integer.
+//
+// Every name gets its own slot the first time it is interned, and keeps it for the rest of the
+// run, so conditions can look their variables up once when they are built instead of every time
+// they are checked.
+class Variable_Slot
+{
+public:
+  // thread safe
+  [[nodiscard]] static Variable_Slot intern(std::string_view name);
+
+  [[nodiscard]] std::size_t index() const noexcept { return index_; }
+  [[nodiscard]] const std::string &name() const;
+
+  auto operator<=>(const Variable_Slot &) const = default;
+
+private:
+  explicit Variable_Slot(const std::uint32_t index) noexcept : index_{ index } {}
+
+  std::uint32_t index_;
+};
+
+// The values of a game's variables, stored by slot.
+// Can be used with names, like a map, or with slots, which skips the name lookup.
+//
+// Each variable has a version that changes whenever it might have changed. Any non const access
+// counts as a change, since the variable can be written through the reference it returns.
+class Variables
+{
+public:
+  Variables() = default;
+
+  // a copy is a different set of variables, so it gets its own `id`
+  Variables(const Variables &other) : entries_{ other.entries_ }, version_{ other.version_ } {}
+  Variables(Variables &&other) noexcept : entries_{ std::move(other.entries_) }, version_{ other.version_ } {}
+  Variables &operator=(const Variables &other)
+  {
+    if (this != &other) {
+      entries_ = other.entries_;
+      version_ = other.version_;
+      id_ = next_id();
+    }
+    return *this;
+  }
+  Variables &operator=(Variables &&other) noexcept
+  {
+    entries_ = std::move(other.entries_);
+    version_ = other.version_;
+    id_ = next_id();
+    return *this;
+  }
+  ~Variables() = default;
+
+  // adds the variable, as `Variable{}`, if it doesn't exist yet
+  Variable &operator[](std::string_view name) { return (*this)[Variable_Slot::intern(name)]; }
+  Variable &operator[](Variable_Slot slot);
+
+  // throws std::out_of_range if the variable doesn't exist
+  [[nodiscard]] Variable &at(std::string_view name) { return at(Variable_Slot::intern(name)); }
+  [[nodiscard]] const Variable &at(std::string_view name) const { return at(Variable_Slot::intern(name)); }
+  [[nodiscard]] Variable &at(Variable_Slot slot);
+  [[nodiscard]] const Variable &at(Variable_Slot slot) const;
+
+  // nullptr if the variable doesn't exist
+  [[nodiscard]] Variable *find(std::string_view name) { return find(Variable_Slot::intern(name)); }
+  [[nodiscard]] const Variable *find(std::string_view name) const { return find(Variable_Slot::intern(name)); }
+  [[nodiscard]] Variable *find(Variable_Slot slot) noexcept;
+  [[nodiscard]] const Variable *find(Variable_Slot slot) const noexcept;
+
+  [[nodiscard]] bool contains(std::string_view name) const { return find(name) != nullptr; }
+  [[nodiscard]] bool contains(Variable_Slot slot) const noexcept { return find(slot) != nullptr; }
+
+  // the latest version of any variable, a variable that was never changed is version 0
+  [[nodiscard]] std::uint64_t version() const noexcept { return version_; }
+  [[nodiscard]] std::uint64_t version(const Variable_Slot slot) const noexcept
+  {
+    return slot.index() < entries_.size() ? entries_[slot.index()].version : 0;
+  }
+
+  // unique to this object, versions can only be compared between Variables with the same id
+  [[nodiscard]] std::uint64_t id() const noexcept { return id_; }
+
+private:
+  struct Entry
+  {
+    std::optional<Variable> value;
+    std::uint64_t version = 0;
+  };
+
+  [[nodiscard]] static std::uint64_t next_id() noexcept;
+
+  std::vector<Entry> entries_;// indexed by slot
+  std::uint64_t version_ = 0;
+  std::uint64_t id_ = next_id();
+};
+
+// The result of a condition on some variables, the last time it was evaluated.
+// Not thread safe, a condition must only be evaluated from one thread at a time.
+class Condition_Cache
+{
+public:
+  // `inputs` are all of the variables `evaluate` can read
+  template<typename Evaluate>
+  [[nodiscard]] bool get(const Variables &variables, const std::vector<Variable_Slot> &inputs, Evaluate &&evaluate)
+  {
+    const auto unchanged = [&](const Variable_Slot slot) { return variables.version(slot) <= evaluated_at_; };
+
+    if (!valid_ || variables_id_ != variables.id() || !std::ranges::all_of(inputs, unchanged)) {
+      result_ = std::forward<Evaluate>(evaluate)();
+      valid_ = true;
+      variables_id_ = variables.id();
+      evaluated_at_ = variables.version();
+      ++evaluations_;
+    }
+
+    return result_;
+  }
+
+  [[nodiscard]] std::size_t evaluations() const noexcept { return evaluations_; }
+
+private:
+  bool valid_ = false;
+  bool result_ = false;
+  std::uint64_t variables_id_ = 0;
+  std::uint64_t evaluated_at_ = 0;
+  std::size_t evaluations_ = 0;
+};
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_VARIABLES_HPP
@@ -1,8 +1,13 @@
 #ifndef AWESOME_GAME_VECTOR2D_HPP
 #define AWESOME_GAME_VECTOR2D_HPP
 
+#include <algorithm>
+#include <cassert>
 #include <fmt/format.h>
+#include <iterator>
+#include <span>
 #include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 #include "point.hpp"
@@ -11,6 +16,61 @@
 
 namespace lefticus::travels {
 
+// Iterates the rows of a (possibly strided) 2D region, yielding one contiguous
+// `std::span` per row so inner loops can be written over plain memory
+template<typename Contained> class Vector2D_Rows
+{
+  Contained *first_;
+  std::size_t width_;
+  std::size_t stride_;
+  std::size_t height_;
+
+public:
+  class iterator
+  {
+    Contained *first_ = nullptr;
+    std::size_t width_ = 0;
+    std::size_t stride_ = 0;
+    std::size_t row_ = 0;
+
+  public:
+    using value_type = std::span<Contained>;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+    iterator(Contained *first, std::size_t width, std::size_t stride, std::size_t row) noexcept
+      : first_{ first }, width_{ width }, stride_{ stride }, row_{ row }
+    {}
+
+    [[nodiscard]] value_type operator*() const noexcept { return value_type(first_ + row_ * stride_, width_); }
+
+    iterator &operator++() noexcept
+    {
+      ++row_;
+      return *this;
+    }
+
+    iterator operator++(int) noexcept
+    {
+      auto result = *this;
+      ++row_;
+      return result;
+    }
+
+    [[nodiscard]] friend bool operator==(const iterator &lhs, const iterator &rhs) noexcept
+    {
+      return lhs.row_ == rhs.row_;
+    }
+  };
+
+  Vector2D_Rows(Contained *first, const Size size, const std::size_t stride) noexcept
+    : first_{ first }, width_{ size.width }, stride_{ stride }, height_{ size.height }
+  {}
+
+  [[nodiscard]] iterator begin() const noexcept { return iterator{ first_, width_, stride_, 0 }; }
+  [[nodiscard]] iterator end() const noexcept { return iterator{ first_, width_, stride_, height_ }; }
+};
+
 
 template<typename Contained> class Vector2D
 {
@@ -32,35 +92,94 @@ public:
 
   [[nodiscard]] auto size() const noexcept { return size_; }
 
+  // distance between the start of one row and the start of the next
+  [[nodiscard]] std::size_t stride() const noexcept { return size_.width; }
+
   [[nodiscard]] Contained &at(const Point point)
   {
     validate_position(point);
-    return data_.at(point.y * size_.width + point.x);
+    return data_[point.y * size_.width + point.x];
   }
 
   [[nodiscard]] const Contained &at(const Point point) const
   {
     validate_position(point);
-    return data_.at(point.y * size_.width + point.x);
+    return data_[point.y * size_.width + point.x];
+  }
+
+  // no bounds checking outside of debug builds, for use in inner loops
+  [[nodiscard]] Contained &unchecked_at(const Point point) noexcept
+  {
+    assert(point.x < size_.width && point.y < size_.height);
+    return data_[point.y * size_.width + point.x];
+  }
+
+  [[nodiscard]] const Contained &unchecked_at(const Point point) const noexcept
+  {
+    assert(point.x < size_.width && point.y < size_.height);
+    return data_[point.y * size_.width + point.x];
   }
+
+  [[nodiscard]] std::span<Contained> row(const std::size_t y) noexcept
+  {
+    assert(y < size_.height);
+    return std::span<Contained>(data_.data() + y * size_.width, size_.width);
+  }
+
+  [[nodiscard]] std::span<const Contained> row(const std::size_t y) const noexcept
+  {
+    assert(y < size_.height);
+    return std::span<const Contained>(data_.data() + y * size_.width, size_.width);
+  }
+
+  [[nodiscard]] Vector2D_Rows<Contained> rows() noexcept { return { data_.data(), size_, size_.width }; }
+  [[nodiscard]] Vector2D_Rows<const Contained> rows() const noexcept { return { data_.data(), size_, size_.width }; }
+
+  // the entire contents, row after row
+  [[nodiscard]] std::span<Contained> data() noexcept { return data_; }
+  [[nodiscard]] std::span<const Contained> data() const noexcept { return data_; }
 };
 
+// A rectangular, strided view into a Vector2D.
+// Bounds against the parent are checked once, at construction time.
 template<typename Contained> class Vector2D_Span
 {
-  Point origin_;
   Size size_;
+  std::size_t stride_;
+  Contained *first_;
 
   using reference_type =
     std::conditional_t<std::is_const_v<Contained>, const Vector2D<std::remove_const_t<Contained>>, Vector2D<Contained>>;
 
-  std::reference_wrapper<reference_type> data_;
+  Vector2D_Span(const Size size, const std::size_t stride, Contained *first) noexcept
+    : size_{ size }, stride_{ stride }, first_{ first }
+  {}
+
+  template<typename> friend class Vector2D_Span;
+
+  static void validate_region(const Point origin, const Size size, const Size parent_size)
+  {
+    if (origin.x + size.width > parent_size.width || origin.y + size.height > parent_size.height) {
+      throw std::range_error(fmt::format("span out of range, got: ({},{}) size ({}, {}), allowed ({}, {})",
+        origin.x,
+        origin.y,
+        size.width,
+        size.height,
+        parent_size.width,
+        parent_size.height));
+    }
+  }
 
 public:
   Vector2D_Span(const Point origin, const Size size, reference_type &data)
-    : origin_{ origin }, size_{ size }, data_{ data }
-  {}
+    : size_{ size }, stride_{ data.stride() }, first_{ data.data().data() }
+  {
+    validate_region(origin, size, data.size());
+    first_ += origin.y * stride_ + origin.x;
+  }
 
   [[nodiscard]] Size size() const noexcept { return size_; }
+  [[nodiscard]] std::size_t stride() const noexcept { return stride_; }
 
   void validate_position(const Point point) const
   {
@@ -71,23 +190,60 @@ public:
   [[nodiscard]] const Contained &at(const Point point) const
   {
     validate_position(point);
-    return data_.get().at(point + origin_);
+    return first_[point.y * stride_ + point.x];
   }
 
   [[nodiscard]] Contained &at(const Point point)
   {
     validate_position(point);
-    return data_.get().at(point + origin_);
+    return first_[point.y * stride_ + point.x];
+  }
+
+  // no bounds checking outside of debug builds, for use in inner loops
+  [[nodiscard]] Contained &unchecked_at(const Point point) const noexcept
+  {
+    assert(point.x < size_.width && point.y < size_.height);
+    return first_[point.y * stride_ + point.x];
+  }
+
+  [[nodiscard]] std::span<Contained> row(const std::size_t y) const noexcept
+  {
+    assert(y < size_.height);
+    return std::span<Contained>(first_ + y * stride_, size_.width);
+  }
+
+  [[nodiscard]] Vector2D_Rows<Contained> rows() const noexcept { return { first_, size_, stride_ }; }
+
+  // a view of a region of this view
+  [[nodiscard]] Vector2D_Span subspan(const Point origin, const Size size) const
+  {
+    validate_region(origin, size, size_);
+    return Vector2D_Span{ size, stride_, first_ + origin.y * stride_ + origin.x };
+  }
+
+  // a mutable view can always be seen as a const one
+  // NOLINTNEXTLINE implicit conversion is intended
+  operator Vector2D_Span<const Contained>() const noexcept
+    requires(!std::is_const_v<Contained>)
+  {
+    return Vector2D_Span<const Contained>{ size_, stride_, first_ };
   }
 };
 
 void fill(auto &vector2d, const auto &value)
 {
-  for (std::size_t y = 0; y < vector2d.size().height; ++y) {
-    for (std::size_t x = 0; x < vector2d.size().width; ++x) { vector2d.at(Point{ x, y }) = value; }
-  }
+  for (auto row : vector2d.rows()) { std::fill(row.begin(), row.end(), value); }
 }
 
+// copies `source` into `destination` a row at a time, both must be the same size
+void copy_rows(const auto &source, auto &&destination)
+{
+  assert(source.size().width == destination.size().width && source.size().height == destination.size().height);
+  for (std::size_t cur_y = 0; cur_y < source.size().height; ++cur_y) {
+    const auto row = source.row(cur_y);
+    std::copy(row.begin(), row.end(), destination.row(cur_y).begin());
+  }
+}
 
 void fill_border(auto &vector2d, const auto &value)
 {
@@ -0,0 +1,159 @@
+#include "viewport.hpp"
+#include "game_components.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <vector>
+
+namespace lefticus::travels {
+
+std::size_t max_draw_bands(const Size viewport, const Size tile_size) noexcept
+{
+  const auto num_wide = viewport.width / tile_size.width;
+  const auto num_high = viewport.height / tile_size.height;
+  return std::clamp(num_wide * num_high / min_tiles_per_band, std::size_t{ 1 }, std::max(num_high, std::size_t{ 1 }));
+}
+
+void draw(Bitmap &viewport, Point map_center, const Game &game, const Game_Map &map)
+{
+  Viewport_Tracker tracker;
+  draw(viewport, map_center, game, map, tracker);
+}
+
+void draw(Bitmap &viewport, Point map_center, const Game &game, const Game_Map &map, Viewport_Tracker &tracker)
+{
+  const auto num_wide = viewport.pixels.size().width / game.tile_size.width;
+  const auto num_high = viewport.pixels.size().height / game.tile_size.height;
+
+  const auto x_offset = num_wide / 2;
+  const auto y_offset = num_high / 2;
+
+  const auto min_x = x_offset;
+  const auto min_y = y_offset;
+
+  const auto max_x = map.size().width - x_offset - (num_wide % 2);
+  const auto max_y = map.size().height - y_offset - (num_high % 2);
+
+  const auto center_map_location =
+    Point{ std::clamp(map_center.x, min_x, max_x), std::clamp(map_center.y, min_y, max_y) };
+
+  const auto upper_left_map_location = center_map_location - Point{ min_x, min_y };
+
+  const auto tiles = Size{ num_wide, num_high };
+
+  // everything that is about to be drawn has to be loaded, the chunks around it can stream in
+  map.tiles.prefetch(upper_left_map_location, tiles, Map_Chunks::chunk_size);
+
+  if (tracker.map != &map || tracker.upper_left != upper_left_map_location || tracker.tiles != tiles) {
+    tracker.map = &map;
+    tracker.upper_left = upper_left_map_location;
+    tracker.tiles = tiles;
+    tracker.player_tile.reset();
+    tracker.dirty = Vector2D<std::uint8_t>{ tiles };
+    fill(tracker.dirty, std::uint8_t{ 1 });
+  }
+
+  auto &dirty = tracker.dirty;
+
+  // cells that might be animated or depend on the game state are always redrawn
+  for (std::size_t cur_y = 0; cur_y < num_high; ++cur_y) {
+    for (std::size_t cur_x = 0; cur_x < num_wide; ++cur_x) {
+      const auto map_location = Point{ cur_x, cur_y } + upper_left_map_location;
+      if (!map.static_draw(map_location)) { dirty.unchecked_at(Point{ cur_x, cur_y }) = 1; }
+    }
+  }
+
+  const auto character_relative_location = game.player.map_location - upper_left_map_location;
+
+  // the tile the player was on needs to be restored, the one it is on now needs to be drawn
+  if (tracker.player_tile) { dirty.at(*tracker.player_tile) = 1; }
+  dirty.at(character_relative_location) = 1;
+
+  // Reading a cell can load its chunk, which only this thread may do, so the bands are handed the
+  // tile stacks to draw instead of looking them up.
+  auto &stacks = tracker.stacks;
+  if (stacks.size() != tiles) { stacks = Vector2D<std::uint32_t>{ tiles }; }
+
+  std::size_t tiles_to_draw = 0;
+  for (std::size_t cur_y = 0; cur_y < num_high; ++cur_y) {
+    for (std::size_t cur_x = 0; cur_x < num_wide; ++cur_x) {
+      const auto tile = Point{ cur_x, cur_y };
+      if (dirty.unchecked_at(tile) == 0) { continue; }
+      ++tiles_to_draw;
+      stacks.unchecked_at(tile) = map.tiles.at(tile + upper_left_map_location);
+    }
+  }
+
+  const auto bands = tracker.pool == nullptr ? std::size_t{ 1 }
+                                             : std::clamp(std::min(tracker.pool->thread_count() + 1,
+                                                            tiles_to_draw / min_tiles_per_band),
+                                               std::size_t{ 1 },
+                                               num_high);
+
+  // bands of rows never share any pixels
+  const auto draw_rows = [&](const Layer layer, const std::size_t first_y, const std::size_t last_y) {
+    for (std::size_t cur_y = first_y; cur_y < last_y; ++cur_y) {
+      for (std::size_t cur_x = 0; cur_x < num_wide; ++cur_x) {
+        if (dirty.unchecked_at(Point{ cur_x, cur_y }) == 0) { continue; }
+
+        auto span = Vector2D_Span<Color>(
+          Point{ cur_x * game.tile_size.width, cur_y * game.tile_size.height }, game.tile_size, viewport.pixels);
+        const auto map_location = Point{ cur_x, cur_y } + upper_left_map_location;
+        map.draw(span, game, map_location, stacks.unchecked_at(Point{ cur_x, cur_y }), layer);
+      }
+    }
+  };
+
+  const auto draw_layer = [&](const Layer layer) {
+    const auto band_start = [&](const std::size_t band) { return band * num_high / bands; };
+
+    std::vector<std::future<void>> others;
+    others.reserve(bands - 1);
+    for (std::size_t band = 1; band < bands; ++band) {
+      others.push_back(tracker.pool->submit(
+        [&draw_rows, layer, first = band_start(band), last = band_start(band + 1)] { draw_rows(layer, first, last); }));
+    }
+
+    std::exception_ptr failure;
+    try {
+      draw_rows(layer, 0, band_start(1));
+    } catch (...) {
+      failure = std::current_exception();
+    }
+
+    // every band has to be finished before the next layer goes on top, and before anything
+    // they refer to goes out of scope, even if one of them failed
+    for (auto &other : others) { other.wait(); }
+    if (failure) { std::rethrow_exception(failure); }
+    for (auto &other : others) { other.get(); }
+  };
+  draw_layer(Layer::Background);
+
+  const auto character_location = Point{ character_relative_location.x * game.tile_size.width,
+    character_relative_location.y * game.tile_size.height };
+
+  auto character_span = Vector2D_Span<Color>(character_location, game.tile_size, viewport.pixels);
+
+  game.player.draw(character_span, game, game.player.map_location);
+
+  draw_layer(Layer::Foreground);
+
+  tracker.tiles_drawn = 0;
+  for (auto &tile : dirty.data()) {
+    tracker.tiles_drawn += tile;
+    tile = 0;
+  }
+  tracker.player_tile = character_relative_location;
+  tracker.bands = bands;
+}
+
+void draw(Bitmap &viewport, const Game &game, Viewport_Tracker &tracker)
+{
+  if (game.maps.contains(game.current_map)) {
+    draw(viewport, game.player.map_location, game, game.maps.at(game.current_map), tracker);
+  }
+}
+
+}// namespace lefticus::travels
@@ -0,0 +1,75 @@
+#ifndef AWESOME_GAME_VIEWPORT_HPP
+#define AWESOME_GAME_VIEWPORT_HPP
+
+#include <cstdint>
+#include <optional>
+
+#include "bitmap.hpp"
+#include "point.hpp"
+#include "size.hpp"
+#include "vector2d.hpp"
+
+namespace lefticus::travels {
+
+struct Game;
+struct Game_Map;
+class Thread_Pool;
+
+// Remembers what was drawn into a viewport on the previous frame, so that `draw`
+// only redraws the tiles that can have changed since then.
+//
+// Everything is redrawn when the camera moves, the viewport is resized or the map changes.
+// Otherwise only the tiles under the player's old and new location and the
+// tiles whose `Game_Map::static_draw` is false are redrawn.
+struct Viewport_Tracker
+{
+  const Game_Map *map = nullptr;
+  Size tiles{ 0, 0 };
+  Point upper_left{};
+  std::optional<Point> player_tile;
+  Vector2D<std::uint8_t> dirty{ Size{ 0, 0 } };
+  Vector2D<std::uint32_t> stacks{ Size{ 0, 0 } };// of the dirty tiles, read before the bands are drawn
+
+  // If set, each layer is split into bands of tile rows that are drawn in parallel, one on the
+  // calling thread and the rest on this pool, which must not be the pool `draw` is called from.
+  // See `Location::draw` for what that requires of scripted cells.
+  Thread_Pool *pool = nullptr;
+
+  // number of tiles redrawn by the last call to `draw`
+  std::size_t tiles_drawn = 0;
+  // number of bands each layer was split into by the last call to `draw`
+  std::size_t bands = 0;
+
+  // redraw everything on the next frame
+  void invalidate() noexcept { map = nullptr; }
+
+  // redraw the tile at `map_location` on the next frame, if it is visible
+  void invalidate(const Point map_location)
+  {
+    const auto tile = map_location - upper_left;
+    if (map_location.x >= upper_left.x && map_location.y >= upper_left.y && tile.x < tiles.width
+        && tile.y < tiles.height) {
+      dirty.at(tile) = 1;
+    }
+  }
+};
+
+// Bands are only split off for at least this many tiles each. Below that, handing a band to the
+// pool costs more than drawing it: about 5us against about 150ns a tile.
+inline constexpr std::size_t min_tiles_per_band = 32;
+
+// the most bands a full redraw of a `viewport` sized bitmap is ever split into, a pool with more
+// than one thread fewer than that would never be handed work for all of its threads
+[[nodiscard]] std::size_t max_draw_bands(Size viewport, Size tile_size) noexcept;
+
+// redraws the whole viewport
+void draw(Bitmap &viewport, Point map_center, const Game &game, const Game_Map &map);
+
+// redraws only the parts of the viewport that changed since the last call with this `tracker`
+void draw(Bitmap &viewport, Point map_center, const Game &game, const Game_Map &map, Viewport_Tracker &tracker);
+
+void draw(Bitmap &viewport, const Game &game, Viewport_Tracker &tracker);
+
+}// namespace lefticus::travels
+
+#endif// AWESOME_GAME_VIEWPORT_HPP
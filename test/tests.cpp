@@ -1,4 +1,1168 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "ansi_encoder.hpp"
+#include "asset_registry.hpp"
+#include "color.hpp"
+#include "color_blend.hpp"
+#include "compiled_map.hpp"
+#include "fixed_timestep.hpp"
+#include "frame_timings.hpp"
+#include "game_components.hpp"
+#include "game_hacking_lesson_00.hpp"
+#include "headless.hpp"
+#include "input_queue.hpp"
+#include "input_recording.hpp"
+#include "log_ring.hpp"
+#include "map_chunks.hpp"
+#include "minimap.hpp"
+#include "palette.hpp"
+#include "pathfinding.hpp"
+#include "thread_pool.hpp"
+#include "tile_properties.hpp"
+#include "tile_set.hpp"
+#include "vector2d.hpp"
+#include "viewport.hpp"
+
 
 TEST_CASE("Sample test", "[samples]") { REQUIRE(true); }
+
+TEST_CASE("Vector2D rows are contiguous and match at()", "[vector2d]")
+{
+  using namespace lefticus::travels;
+
+  Vector2D<int> data{ Size{ 4, 3 } };
+  int value = 0;
+  for (auto row : data.rows()) {
+    REQUIRE(row.size() == 4);
+    for (auto &element : row) { element = value++; }
+  }
+
+  REQUIRE(data.at(Point{ 0, 0 }) == 0);
+  REQUIRE(data.at(Point{ 3, 2 }) == 11);
+  REQUIRE(data.unchecked_at(Point{ 1, 1 }) == 5);
+  REQUIRE(data.row(2)[1] == 9);
+  REQUIRE_THROWS_AS(data.at(Point{ 4, 0 }), std::range_error);
+}
+
+TEST_CASE("Vector2D_Span is a strided view", "[vector2d]")
+{
+  using namespace lefticus::travels;
+
+  Vector2D<int> data{ Size{ 5, 5 } };
+  auto span = Vector2D_Span<int>(Point{ 1, 2 }, Size{ 3, 2 }, data);
+  fill(span, 1);
+
+  std::size_t total_rows = 0;
+  for (auto row : span.rows()) {
+    REQUIRE(row.size() == 3);
+    ++total_rows;
+  }
+  REQUIRE(total_rows == 2);
+
+  REQUIRE(data.at(Point{ 0, 2 }) == 0);
+  REQUIRE(data.at(Point{ 1, 2 }) == 1);
+  REQUIRE(data.at(Point{ 3, 3 }) == 1);
+  REQUIRE(data.at(Point{ 4, 3 }) == 0);
+  REQUIRE(data.at(Point{ 1, 4 }) == 0);
+
+  auto sub = span.subspan(Point{ 1, 1 }, Size{ 2, 1 });
+  fill(sub, 2);
+  REQUIRE(data.at(Point{ 2, 3 }) == 2);
+  REQUIRE(data.at(Point{ 3, 3 }) == 2);
+  REQUIRE(data.at(Point{ 2, 2 }) == 1);
+
+  const Vector2D_Span<const int> const_span = span;
+  REQUIRE(const_span.at(Point{ 1, 1 }) == 2);
+
+  REQUIRE_THROWS_AS(Vector2D_Span<int>(Point{ 3, 3 }, Size{ 3, 3 }, data), std::range_error);
+  REQUIRE_THROWS_AS(span.subspan(Point{ 2, 0 }, Size{ 2, 1 }), std::range_error);
+}
+
+namespace {
+// the original floating point implementation of `Basic_Color::operator+=`
+lefticus::travels::Color reference_blend(lefticus::travels::Color under, lefticus::travels::Color over)
+{
+  using namespace lefticus::travels;
+  const auto color1 = color_cast<double>(under);
+  const auto color0 = color_cast<double>(over);
+  auto color01 = Basic_Color<double>{};
+
+  color01.A = (1 - color0.A) * color1.A + color0.A;
+  if (color01.A == 0) { return Color{}; }
+  color01.R = ((1 - color0.A) * color1.A * color1.R + color0.A * color0.R) / color01.A;
+  color01.G = ((1 - color0.A) * color1.A * color1.G + color0.A * color0.G) / color01.A;
+  color01.B = ((1 - color0.A) * color1.A * color1.B + color0.A * color0.B) / color01.A;
+  return color_cast<std::uint8_t>(color01);
+}
+
+bool within_one(std::uint8_t lhs, std::uint8_t rhs) { return (lhs > rhs ? lhs - rhs : rhs - lhs) <= 1; }
+}// namespace
+
+TEST_CASE("Integer blend matches the floating point formula", "[color]")
+{
+  using namespace lefticus::travels;
+
+  for (unsigned over_alpha = 0; over_alpha < 256; over_alpha += 3) {
+    for (unsigned under_alpha = 0; under_alpha < 256; under_alpha += 5) {
+      for (unsigned channel = 0; channel < 256; channel += 17) {
+        const auto under = Color{ static_cast<std::uint8_t>(channel),
+          static_cast<std::uint8_t>(255 - channel),
+          static_cast<std::uint8_t>(channel / 2),
+          static_cast<std::uint8_t>(under_alpha) };
+        const auto over = Color{ static_cast<std::uint8_t>(255 - channel),
+          static_cast<std::uint8_t>(channel),
+          static_cast<std::uint8_t>(channel / 3),
+          static_cast<std::uint8_t>(over_alpha) };
+
+        const auto expected = reference_blend(under, over);
+        const auto result = blend(under, over);
+        REQUIRE(within_one(result.R, expected.R));
+        REQUIRE(within_one(result.G, expected.G));
+        REQUIRE(within_one(result.B, expected.B));
+        REQUIRE(result.A == expected.A);
+      }
+    }
+  }
+
+  REQUIRE(blend(Color{ 1, 2, 3, 0 }, Color{ 4, 5, 6, 0 }) == Color{});
+  REQUIRE(blend(Color{ 1, 2, 3, 4 }, Color{ 4, 5, 6, 255 }) == Color{ 4, 5, 6, 255 });
+  REQUIRE(blend(Color{ 1, 2, 3, 4 }, Color{ 4, 5, 6, 0 }) == Color{ 1, 2, 3, 4 });
+
+  auto color = Color{ 10, 20, 30, 255 };
+  color += Color{ 200, 100, 0, 128 };
+  REQUIRE(color == blend(Color{ 10, 20, 30, 255 }, Color{ 200, 100, 0, 128 }));
+}
+
+TEST_CASE("blend_span is identical to blending one pixel at a time", "[color]")
+{
+  using namespace lefticus::travels;
+
+  constexpr std::size_t width = 37;
+  Vector2D<Color> under{ Size{ width, 3 } };
+  Vector2D<Color> over{ Size{ width, 3 } };
+
+  std::uint32_t seed = 12345;
+  const auto next = [&seed] {
+    seed = seed * 1664525U + 1013904223U;
+    return static_cast<std::uint8_t>(seed >> 24U);
+  };
+
+  for (std::size_t cur_x = 0; cur_x < width; ++cur_x) {
+    // first row: opaque destination (vector path), second: mixed, third: random
+    under.at(Point{ cur_x, 0 }) = Color{ next(), next(), next(), 255 };
+    under.at(Point{ cur_x, 1 }) = Color{ next(), next(), next(), cur_x % 3 == 0 ? next() : std::uint8_t{ 255 } };
+    under.at(Point{ cur_x, 2 }) = Color{ next(), next(), next(), next() };
+    for (std::size_t cur_y = 0; cur_y < 3; ++cur_y) {
+      over.at(Point{ cur_x, cur_y }) = Color{ next(), next(), next(), next() };
+    }
+  }
+
+  auto expected = under;
+  for (std::size_t cur_y = 0; cur_y < 3; ++cur_y) {
+    for (std::size_t cur_x = 0; cur_x < width; ++cur_x) {
+      expected.at(Point{ cur_x, cur_y }) = blend(expected.at(Point{ cur_x, cur_y }), over.at(Point{ cur_x, cur_y }));
+    }
+  }
+
+  blend_span(under, over);
+
+  for (std::size_t cur_y = 0; cur_y < 3; ++cur_y) {
+    for (std::size_t cur_x = 0; cur_x < width; ++cur_x) {
+      REQUIRE(under.at(Point{ cur_x, cur_y }) == expected.at(Point{ cur_x, cur_y }));
+    }
+  }
+}
+
+TEST_CASE("Timing_Histogram keeps a rolling window of samples", "[timings]")
+{
+  using namespace lefticus::travels;
+  using std::chrono::milliseconds;
+
+  Basic_Timing_Histogram<100> histogram;
+  REQUIRE(histogram.summary().samples == 0);
+
+  // the first 50 samples get pushed out of the window
+  for (int sample = 0; sample < 50; ++sample) { histogram.add(milliseconds{ 1000 }); }
+  for (int sample = 1; sample <= 100; ++sample) { histogram.add(milliseconds{ sample }); }
+
+  const auto summary = histogram.summary();
+  REQUIRE(histogram.total() == 150);
+  REQUIRE(summary.samples == 100);
+  REQUIRE(summary.p50 == milliseconds{ 50 });
+  REQUIRE(summary.p95 == milliseconds{ 95 });
+  REQUIRE(summary.p99 == milliseconds{ 99 });
+  REQUIRE(summary.max == milliseconds{ 100 });
+}
+
+TEST_CASE("Input_Queue coalesces repeated commands", "[input]")
+{
+  using namespace lefticus::travels;
+  using namespace std::chrono_literals;
+
+  Basic_Input_Queue<8> queue;
+  const auto now = std::chrono::steady_clock::now();
+
+  REQUIRE(queue.push(Input_Command::Move_North, now - 2s));// stale, but the first of its run
+  REQUIRE(queue.push(Input_Command::Move_North, now - 1s));// stale repeat, dropped
+  REQUIRE(queue.push(Input_Command::Move_North, now));
+  REQUIRE(queue.push(Input_Command::Move_East, now));
+  REQUIRE(queue.push(Input_Command::Move_East, now));
+  REQUIRE(queue.push(Input_Command::Show_Log, now));
+  REQUIRE(queue.push(Input_Command::Move_East, now));
+  REQUIRE(queue.push(Input_Command::Move_East, now));
+  REQUIRE_FALSE(queue.push(Input_Command::Move_East, now));
+
+  std::vector<std::pair<Input_Command, std::size_t>> runs;
+  queue.drain(now, [&](const Input_Command command, const std::size_t count) { runs.emplace_back(command, count); });
+
+  REQUIRE(runs
+          == std::vector<std::pair<Input_Command, std::size_t>>{ { Input_Command::Move_North, 2 },
+            { Input_Command::Move_East, 2 },
+            { Input_Command::Show_Log, 1 },
+            { Input_Command::Move_East, 2 } });
+
+  runs.clear();
+  queue.drain(now, [&](const Input_Command command, const std::size_t count) { runs.emplace_back(command, count); });
+  REQUIRE(runs.empty());
+}
+
+TEST_CASE("Fixed_Timestep runs every due tick and drops the excess", "[timestep]")
+{
+  using namespace lefticus::travels;
+  using namespace std::chrono_literals;
+
+  Timing_Histogram jitter;
+  const auto start = std::chrono::steady_clock::now();
+  Fixed_Timestep timestep{ 10ms, 3, start, jitter };
+  REQUIRE_THROWS_AS((Fixed_Timestep{ 0ms, 3, start, jitter }), std::invalid_argument);
+
+  std::size_t ticks = 0;
+  const auto tick = [&] { ++ticks; };
+
+  REQUIRE(timestep.update(start + 5ms, tick) == 0);
+  REQUIRE(timestep.update(start + 25ms, tick) == 2);
+  REQUIRE(timestep.simulated_time() == 20ms);
+
+  // 10 ticks are due, only 3 are run
+  REQUIRE(timestep.update(start + 125ms, tick) == 3);
+  REQUIRE(timestep.dropped_ticks() == 7);
+  REQUIRE(timestep.ticks() == 5);
+  REQUIRE(ticks == 5);
+
+  // the schedule picks up from the present instead of catching up on the dropped ticks
+  REQUIRE(timestep.update(start + 129ms, tick) == 0);
+  REQUIRE(timestep.update(start + 130ms, tick) == 1);
+  REQUIRE(jitter.total() == 6);
+}
+
+TEST_CASE("Compiled maps round trip", "[compiled_map]")
+{
+  using namespace lefticus::travels;
+
+  Tiled_Map map;
+  map.tile_size = Size{ 2, 2 };
+  map.map_size = Size{ 3, 2 };
+
+  auto &tile_set = map.tile_sets.emplace_back();
+  tile_set.start_id = 1;
+  tile_set.tsj = Tiled_Map::Source_File{ .path = "tiles.tsj",
+    .modified = std::filesystem::file_time_type{ std::filesystem::file_time_type::duration{ 12345 } } };
+  tile_set.image_file = Tiled_Map::Source_File{ .path = "tiles.png",
+    .modified = std::filesystem::file_time_type{ std::filesystem::file_time_type::duration{ -6789 } } };
+  Vector2D<Color> image{ Size{ 4, 2 } };
+  std::uint8_t value = 0;
+  for (auto &pixel : image.data()) {
+    pixel = Color{ value, static_cast<std::uint8_t>(value + 1), static_cast<std::uint8_t>(value + 2), 255 };
+    value += 3;
+  }
+  tile_set.image = std::make_shared<const Vector2D<Color>>(image);
+  Tile_Properties tile_properties{ 2 };
+  tile_properties.set(0, "passable", true);
+  tile_properties.set(1, "passable", false);
+  tile_properties.set(1, "name", std::string{ "wall" });
+  tile_properties.set(0, "cost", std::int64_t{ -3 });
+  tile_properties.set(1, "friction", 0.25);
+  tile_set.properties = std::make_shared<const Tile_Properties>(tile_properties);
+
+  map.layers.push_back(Tiled_Map::Tile_Layer{ .background = true });
+  map.layers.push_back(Tiled_Map::Tile_Layer{ .foreground = true });
+  map.stacks = { { 0, 0 }, { 1, 0 }, { 2, 0 }, { 2, 1 } };
+  const std::array<std::uint32_t, 6> cell_stacks{ 1, 2, 1, 1, 0, 3 };
+  map.cells = Chunk_Runs::encode(map.map_size, [&](const Point cell) { return cell_stacks.at(cell.y * 3 + cell.x); });
+
+  std::stringstream stream;
+  write_compiled_map(map, stream);
+  const auto compiled = stream.str();
+  const auto bytes = std::as_bytes(std::span{ compiled });
+
+  const auto loaded = read_compiled_map(bytes);
+  REQUIRE(loaded.tile_size == map.tile_size);
+  REQUIRE(loaded.map_size == map.map_size);
+  REQUIRE(loaded.tile_sets.size() == 1);
+  REQUIRE(loaded.tile_sets[0].start_id == 1);
+  REQUIRE(loaded.tile_sets[0].tsj.path == "tiles.tsj");
+  REQUIRE(loaded.tile_sets[0].tsj.modified == tile_set.tsj.modified);
+  REQUIRE(loaded.tile_sets[0].image_file.path == "tiles.png");
+  REQUIRE(loaded.tile_sets[0].image_file.modified == tile_set.image_file.modified);
+  const auto sources = read_compiled_map_sources(bytes);
+  REQUIRE(sources.size() == 2);
+  REQUIRE(sources[1].path == "tiles.png");
+  REQUIRE(loaded.tile_sets[0].image->size() == image.size());
+  REQUIRE(std::ranges::equal(loaded.tile_sets[0].image->data(), image.data()));
+  const auto &properties = *loaded.tile_sets[0].properties;
+  REQUIRE(properties.tile_count() == 2);
+  REQUIRE(properties.get<bool>(0, "passable") == true);
+  REQUIRE(properties.get<bool>(1, "passable") == false);
+  REQUIRE(properties.get<std::string>(1, "name") == "wall");
+  REQUIRE(properties.get<std::int64_t>(0, "cost") == -3);
+  REQUIRE(properties.get<double>(1, "friction") == 0.25);
+  REQUIRE_FALSE(properties.get<double>(0, "friction").has_value());
+  REQUIRE(loaded.layers.size() == 2);
+  REQUIRE(loaded.layers[0].background);
+  REQUIRE_FALSE(loaded.layers[0].foreground);
+  REQUIRE(loaded.layers[1].foreground);
+  REQUIRE(loaded.stacks == map.stacks);
+  Map_Chunks::Chunk cells{ Size{ Map_Chunks::chunk_size, Map_Chunks::chunk_size } };
+  loaded.cells.expand(Point{ 0, 0 }, cells);
+  for (std::size_t cell = 0; cell < cell_stacks.size(); ++cell) {
+    REQUIRE(cells.at(Point{ cell % 3, cell / 3 }) == cell_stacks.at(cell));
+  }
+
+  REQUIRE_THROWS_AS(read_compiled_map(bytes.first(bytes.size() - 1)), std::runtime_error);
+
+  // sizes that the rest of the file can't back are rejected before anything is allocated for them
+  const auto patched = [&compiled](const std::size_t offset, const std::uint32_t patch) {
+    auto copy = compiled;
+    for (std::size_t byte = 0; byte < 4; ++byte) {
+      copy[offset + byte] = static_cast<char>((patch >> (byte * 8)) & 0xFFU);
+    }
+    return copy;
+  };
+  const auto no_tile_size = patched(12, 0);// tile width
+  REQUIRE_THROWS_AS(read_compiled_map(std::as_bytes(std::span{ no_tile_size })), std::runtime_error);
+  // the sources take 2 * (4 + 12 + 8) bytes after the 36 byte header, the names are padded to 4 bytes
+  const auto huge_image = patched(88, 0x10000);// tile set image width
+  REQUIRE_THROWS_AS(read_compiled_map(std::as_bytes(std::span{ huge_image })), std::runtime_error);
+  const auto huge_tile_count = patched(96, 0xFFFFFFFF);// tile count of the properties
+  REQUIRE_THROWS_AS(read_compiled_map(std::as_bytes(std::span{ huge_tile_count })), std::runtime_error);
+}
+
+TEST_CASE("Compiled maps are stale once a tile set or its image changes", "[compiled_map]")
+{
+  using namespace lefticus::travels;
+
+  const auto directory = std::filesystem::temp_directory_path() / "travels_compiled_map_test";
+  std::filesystem::create_directories(directory);
+  const auto map_json = directory / "map.tmj";
+  for (const auto *name : { "map.tmj", "tiles.tsj", "tiles.png" }) { std::ofstream{ directory / name } << name; }
+
+  Tiled_Map map;
+  map.tile_size = Size{ 1, 1 };
+  map.map_size = Size{ 1, 1 };
+  auto &tile_set = map.tile_sets.emplace_back();
+  tile_set.start_id = 1;
+  tile_set.tsj = map_source(map_json, directory / "tiles.tsj");
+  tile_set.image_file = map_source(map_json, directory / "tiles.png");
+  tile_set.image = std::make_shared<const Vector2D<Color>>(Size{ 1, 1 });
+  tile_set.properties = std::make_shared<const Tile_Properties>(1);
+  map.stacks = { {} };
+  map.cells = Chunk_Runs::encode(map.map_size, [](const Point) { return std::uint32_t{ 0 }; });
+  REQUIRE(tile_set.tsj.path == "tiles.tsj");
+
+  auto compiled_path = map_json;
+  compiled_path.replace_extension(compiled_map::extension);
+  {
+    std::ofstream output{ compiled_path, std::ios::binary };
+    write_compiled_map(map, output);
+  }
+  std::filesystem::last_write_time(compiled_path, std::filesystem::last_write_time(map_json) + std::chrono::hours{ 1 });
+
+  const auto fresh = up_to_date_compiled_map(map_json);
+  const auto png = directory / "tiles.png";
+  std::filesystem::last_write_time(png, std::filesystem::last_write_time(png) - std::chrono::hours{ 1 });
+  const auto image_changed = up_to_date_compiled_map(map_json);
+  std::filesystem::remove_all(directory);
+
+  REQUIRE(fresh == compiled_path);
+  REQUIRE_FALSE(image_changed.has_value());
+}
+
+TEST_CASE("Asset_Registry stores identical images once", "[asset_registry]")
+{
+  using namespace lefticus::travels;
+
+  Asset_Registry assets;
+
+  Vector2D<Color> image{ Size{ 2, 2 } };
+  image.at(Point{ 1, 0 }) = Color{ 1, 2, 3, 255 };
+  auto different = image;
+  different.at(Point{ 0, 1 }) = Color{ 4, 5, 6, 255 };
+
+  const auto first = assets.image(image);
+  REQUIRE(assets.image(image) == first);
+  REQUIRE(assets.image(different) != first);
+  REQUIRE(assets.stats().reuses == 1);
+
+  // only held while something uses it
+  const std::weak_ptr<const Vector2D<Color>> released = assets.image(Vector2D<Color>{ Size{ 3, 1 } });
+  REQUIRE(released.expired());
+
+  REQUIRE_THROWS(assets.image(std::filesystem::path{ "missing.png" }));
+}
+
+TEST_CASE("Tile_Properties stores one typed column per property", "[tile_properties]")
+{
+  using namespace lefticus::travels;
+
+  Tile_Properties properties{ 4 };
+  properties.set(1, "passable", false);
+  properties.set(3, "passable", true);
+  properties.set(2, "damage", std::int64_t{ 5 });
+
+  const auto *passable = properties.column<bool>("passable");
+  REQUIRE(passable != nullptr);
+  REQUIRE(passable->size() == 4);
+  REQUIRE_FALSE((*passable)[0].has_value());
+  REQUIRE((*passable)[1] == false);
+  REQUIRE((*passable)[3] == true);
+
+  REQUIRE(properties.column<std::int64_t>("passable") == nullptr);
+  REQUIRE(properties.column<bool>("missing") == nullptr);
+  REQUIRE(properties.get<std::int64_t>(2, "damage") == 5);
+  REQUIRE_FALSE(properties.get<std::int64_t>(9, "damage").has_value());
+
+  const auto damage = properties.column_index<std::int64_t>("damage");
+  REQUIRE(damage.has_value());
+  REQUIRE(properties.at<std::int64_t>(2, *damage) == 5);
+  REQUIRE_FALSE(properties.at<std::int64_t>(1, *damage).has_value());
+  REQUIRE_FALSE(properties.column_index<bool>("damage").has_value());
+
+  const Tile_Set tile_set{ Vector2D<Color>{ Size{ 4, 1 } }, Size{ 1, 1 }, 10 };
+  const Tile_Set with_properties{ std::make_shared<const Vector2D<Color>>(Size{ 4, 1 }),
+    Size{ 1, 1 },
+    10,
+    std::make_shared<const Tile_Properties>(properties) };
+  REQUIRE(tile_set.passable(11));
+  REQUIRE_FALSE(with_properties.passable(11));
+  REQUIRE(with_properties.passable(12));
+  REQUIRE(with_properties.passable(13));
+
+  REQUIRE_THROWS_AS(properties.set(0, "passable", std::int64_t{ 1 }), std::runtime_error);
+  REQUIRE_THROWS_AS(properties.set(4, "passable", true), std::out_of_range);
+}
+
+TEST_CASE("Game_Map only stores scripts for scripted cells", "[game_map]")
+{
+  using namespace lefticus::travels;
+
+  Game_Map map{ Size{ 100, 100 } };
+  REQUIRE(map.size() == Size{ 100, 100 });
+
+  map.locations.at(Point{ 3, 4 }).can_enter = [](const Game &, Point, Direction from) {
+    return from == Direction::North;
+  };
+  map.locations.at(Point{ 5, 5 }).draw = [](Vector2D_Span<Color> &, const Game &, Point, Layer) {};
+  REQUIRE(map.locations.scripted_count() == 2);
+
+  const auto &const_map = map;
+  REQUIRE_FALSE(const_map.locations.at(Point{ 7, 7 }).enter_action);
+  REQUIRE(map.locations.find(Point{ 7, 7 }) == nullptr);
+  REQUIRE(map.locations.scripted_count() == 2);
+  REQUIRE_THROWS_AS(const_map.locations.at(Point{ 100, 0 }), std::range_error);
+
+  const Game game{};
+  REQUIRE(map.can_enter_from(game, Point{ 3, 4 }, Direction::North));
+  REQUIRE_FALSE(map.can_enter_from(game, Point{ 3, 4 }, Direction::South));
+  REQUIRE(map.can_enter_from(game, Point{ 0, 0 }, Direction::South));
+
+  REQUIRE(map.static_draw(Point{ 3, 4 }));
+  REQUIRE_FALSE(map.static_draw(Point{ 5, 5 }));
+}
+
+TEST_CASE("Map_Chunks loads chunks on demand and evicts the ones out of view longest", "[map_chunks]")
+{
+  using namespace lefticus::travels;
+
+  constexpr auto chunk_size = Map_Chunks::chunk_size;
+  constexpr auto chunk_bytes = chunk_size * chunk_size * sizeof(std::uint32_t);
+
+  std::atomic<std::size_t> loads = 0;
+  const auto loader = [&loads](const Point origin, Map_Chunks::Chunk &chunk) {
+    ++loads;
+    for (std::size_t y = 0; y < chunk.size().height; ++y) {
+      for (std::size_t x = 0; x < chunk.size().width; ++x) {
+        chunk.at(Point{ x, y }) = static_cast<std::uint32_t>((origin.x + x) + (origin.y + y) * 1000);
+      }
+    }
+  };
+  Map_Chunks chunks{ Size{ chunk_size * 4, chunk_size * 4 + 1 }, loader, chunk_bytes * 2 };
+
+  REQUIRE(chunks.at(Point{ 3, 5 }) == 5003);
+  REQUIRE(chunks.at(Point{ chunk_size * 3 + 1, chunk_size * 4 }) == chunk_size * 3 + 1 + chunk_size * 4 * 1000);
+  REQUIRE(chunks.stats().blocking_loads == 2);
+  REQUIRE(chunks.stats().resident_chunks == 2);
+  REQUIRE_THROWS_AS(chunks.at(Point{ chunk_size * 4, 0 }), std::range_error);
+
+  // a third chunk goes over the budget, the least recently used one has to go
+  REQUIRE(chunks.at(Point{ chunk_size, 0 }) == chunk_size);
+  REQUIRE(chunks.stats().resident_chunks == 2);
+  REQUIRE(chunks.stats().evictions == 1);
+
+  // the visible area is always kept, even when that goes over the budget
+  chunks.prefetch(Point{ 0, 0 }, Size{ chunk_size * 2, chunk_size * 2 }, 0);
+  REQUIRE(chunks.stats().resident_chunks == 4);
+  REQUIRE(chunks.at(Point{ chunk_size + 2, chunk_size + 1 }) == chunk_size + 2 + (chunk_size + 1) * 1000);
+
+  const Map_Chunks empty{ Size{ 10, 10 } };
+  REQUIRE(empty.at(Point{ 9, 9 }) == Map_Chunks::empty_cell);
+
+  // what `prefetch` has in view counts as a use, reading a cell doesn't
+  Map_Chunks used{ Size{ chunk_size * 4, chunk_size }, loader, chunk_bytes * 2 };
+  const auto first = Point{ 0, 0 };
+  const auto second = Point{ chunk_size, 0 };
+  const auto third = Point{ chunk_size * 2, 0 };
+  static_cast<void>(used.at(first));
+  static_cast<void>(used.at(second));
+  used.prefetch(first, Size{ 1, 1 }, 0);
+  static_cast<void>(used.at(second));
+  used.prefetch(third, Size{ 1, 1 }, 0);
+  REQUIRE(used.stats().evictions == 1);
+  REQUIRE_FALSE(used.resident_at(second));
+  REQUIRE(used.resident_at(first) == 0U);
+  REQUIRE(used.stats().blocking_loads == 3);
+
+  // a chunk in view at the back of the list is skipped over, not a reason to stay over the budget
+  used.prefetch(second, Size{ 1, 1 }, 0);
+  static_cast<void>(used.at(first));
+  static_cast<void>(used.at(Point{ chunk_size * 3, 0 }));
+  REQUIRE(used.stats().resident_chunks == 2);
+  REQUIRE(used.resident_at(second) == chunk_size);
+  REQUIRE_FALSE(used.resident_at(first));
+  REQUIRE(used.stats().blocking_loads == 6);
+}
+
+TEST_CASE("Chunk_Runs expands any chunk on its own", "[map_chunks]")
+{
+  using namespace lefticus::travels;
+
+  constexpr auto chunk_size = Map_Chunks::chunk_size;
+  const auto size = Size{ chunk_size * 2 + 5, chunk_size + 3 };
+  const auto value = [](const Point cell) { return static_cast<std::uint32_t>(cell.x / 7 + (cell.y / 2) * 100); };
+  const auto runs = Chunk_Runs::encode(size, value);
+
+  // far fewer runs than cells
+  REQUIRE(runs.runs().size() / (2 * sizeof(std::uint32_t)) < size.width * size.height / 4);
+
+  for (std::size_t chunk_y = 0; chunk_y < 2; ++chunk_y) {
+    for (std::size_t chunk_x = 0; chunk_x < 3; ++chunk_x) {
+      Map_Chunks::Chunk cells{ Size{ chunk_size, chunk_size } };
+      fill(cells, Map_Chunks::empty_cell);
+      runs.expand(Point{ chunk_x, chunk_y }, cells);
+
+      for (std::size_t y = 0; y < chunk_size; ++y) {
+        for (std::size_t x = 0; x < chunk_size; ++x) {
+          const auto cell = Point{ chunk_x * chunk_size + x, chunk_y * chunk_size + y };
+          const auto expected = cell.x < size.width && cell.y < size.height ? value(cell) : Map_Chunks::empty_cell;
+          REQUIRE(cells.at(Point{ x, y }) == expected);
+        }
+      }
+    }
+  }
+
+  // runs missing from damaged data leave their cells alone
+  const auto damaged = Chunk_Runs{ size, runs.starts(), runs.runs().first(8), nullptr };
+  Map_Chunks::Chunk cells{ Size{ chunk_size, chunk_size } };
+  fill(cells, Map_Chunks::empty_cell);
+  damaged.expand(Point{ 2, 1 }, cells);
+  REQUIRE(cells.at(Point{ 0, 0 }) == Map_Chunks::empty_cell);
+  REQUIRE_THROWS_AS((Chunk_Runs{ Size{ chunk_size * 3, 1 }, runs.starts(), runs.runs(), nullptr }), std::runtime_error);
+}
+
+TEST_CASE("Infinite Tiled maps are read without flattening their chunks", "[game_map]")
+{
+  using namespace lefticus::travels;
+
+  const auto directory = std::filesystem::temp_directory_path() / "travels_infinite_map_test";
+  std::filesystem::create_directories(directory);
+  const auto map_json = directory / "infinite.tmj";
+  {
+    std::ofstream output{ map_json };
+    output << R"({ "tilewidth": 8, "tileheight": 8, "width": 4, "height": 4, "infinite": true, "tilesets": [],
+      "layers": [
+        { "type": "tilelayer", "visible": true, "chunks": [
+          { "x": -2, "y": -2, "width": 2, "height": 2, "data": [ 1, 1, 1, 2 ] },
+          { "x": 2, "y": 0, "width": 2, "height": 2, "data": [ 3, 0, 0, 0 ] } ] },
+        { "type": "tilelayer", "visible": false, "chunks": [
+          { "x": 0, "y": 0, "width": 2, "height": 2, "data": [ 9, 9, 9, 9 ] } ] },
+        { "type": "tilelayer", "visible": true,
+          "properties": [ { "name": "foreground", "type": "bool", "value": true } ], "chunks": [
+          { "x": -2, "y": -2, "width": 2, "height": 2, "data": [ 0, 0, 0, 4 ] } ] } ] })";
+  }
+
+  const auto layout = read_tiled_map_layout(map_json);
+  std::filesystem::remove_all(directory);
+
+  const auto &map = layout.map;
+  REQUIRE(map.map_size == Size{ 6, 4 });
+  REQUIRE(map.layers.size() == 2);
+  REQUIRE(map.layers[1].foreground);
+
+  Map_Chunks::Chunk cells{ Size{ Map_Chunks::chunk_size, Map_Chunks::chunk_size } };
+  map.cells.expand(Point{ 0, 0 }, cells);
+  const auto gids = [&](const Point cell) { return map.stacks.at(cells.at(cell)); };
+  REQUIRE(gids(Point{ 0, 0 }) == std::vector<std::uint32_t>{ 1, 0 });
+  REQUIRE(gids(Point{ 1, 1 }) == std::vector<std::uint32_t>{ 2, 4 });
+  REQUIRE(gids(Point{ 4, 2 }) == std::vector<std::uint32_t>{ 3, 0 });
+  REQUIRE(gids(Point{ 5, 3 }) == std::vector<std::uint32_t>{ 0, 0 });
+  REQUIRE(gids(Point{ 3, 0 }) == std::vector<std::uint32_t>{ 0, 0 });
+  REQUIRE(map.stacks.size() == 4);
+}
+
+TEST_CASE("Thread_Pool runs tasks submitted from other tasks", "[thread_pool]")
+{
+  using namespace lefticus::travels;
+
+  std::atomic<int> finished = 0;
+  std::future<int> answer;
+  std::future<int> failure;
+
+  {
+    Thread_Pool pool{ 2 };
+    answer = pool.submit([&pool, &finished] {
+      for (int task = 0; task < 10; ++task) {// NOLINT magic numbers
+        pool.post([&finished] { ++finished; });
+      }
+      return 42;// NOLINT magic numbers
+    });
+    failure = pool.submit([]() -> int { throw std::runtime_error("failed"); });
+
+    REQUIRE(answer.get() == 42);
+  }
+
+  // the destructor runs everything that is queued
+  REQUIRE(finished == 10);
+  REQUIRE_THROWS_AS(failure.get(), std::runtime_error);
+}
+
+namespace {
+// a map of three tile stacks in diagonal stripes, with one animated cell at {30, 35}
+lefticus::travels::Game make_striped_game(const lefticus::travels::Size map_size = lefticus::travels::Size{ 80, 80 },
+  const std::size_t memory_budget = lefticus::travels::Map_Chunks::default_memory_budget)
+{
+  using namespace lefticus::travels;
+
+  Game game;
+  game.tile_size = Size{ 8, 8 };
+  game.current_map = "map";
+  game.player.map_location = Point{ 40, 40 };
+  game.player.draw = [](Vector2D_Span<Color> &pixels, const Game &, Point) { fill(pixels, Color{ 255, 0, 0, 255 }); };
+
+  Game_Map map{ map_size };
+  map.tiles = Map_Chunks{ map_size,
+    [](const Point origin, Map_Chunks::Chunk &chunk) {
+      for (std::size_t y = 0; y < chunk.size().height; ++y) {
+        for (std::size_t x = 0; x < chunk.size().width; ++x) {
+          chunk.at(Point{ x, y }) = static_cast<std::uint32_t>((origin.x + x + origin.y + y) % 3);
+        }
+      }
+    },
+    memory_budget };
+
+  for (std::uint8_t stack = 0; stack < 3; ++stack) {
+    auto &tiles = map.tile_stacks.emplace_back(game.tile_size);
+    fill(tiles.background, Color{ static_cast<std::uint8_t>(stack * 80), 40, 40, 255 });
+    fill(tiles.foreground, Color{ 0, 0, 255, static_cast<std::uint8_t>(stack * 60) });
+    tiles.has_background = true;
+    tiles.has_foreground = stack != 0;
+    tiles.build_mip_levels();
+  }
+
+  map.locations.at(Point{ 30, 35 }).draw = [](Vector2D_Span<Color> &pixels, const Game &, Point, Layer layer) {
+    if (layer == Layer::Background) { fill(pixels, Color{ 0, 255, 0, 255 }); }
+  };
+  game.maps.emplace("map", std::move(map));
+
+  return game;
+}
+}// namespace
+
+TEST_CASE("Drawing in bands on a thread pool matches drawing on one thread", "[viewport]")
+{
+  using namespace lefticus::travels;
+
+  auto game = make_striped_game();
+
+  Bitmap serial{ Size{ 320, 240 } };
+  Viewport_Tracker serial_tracker;
+  draw(serial, game, serial_tracker);
+  REQUIRE(serial_tracker.bands == 1);
+
+  Thread_Pool pool{ 3 };
+  Bitmap banded{ Size{ 320, 240 } };
+  Viewport_Tracker banded_tracker;
+  banded_tracker.pool = &pool;
+  draw(banded, game, banded_tracker);
+  REQUIRE(banded_tracker.bands == 4);
+  REQUIRE(banded_tracker.tiles_drawn == serial_tracker.tiles_drawn);
+  REQUIRE(std::ranges::equal(banded.pixels.data(), serial.pixels.data()));
+
+  // only the animated and the player's tiles are drawn again, not worth splitting up
+  draw(banded, game, banded_tracker);
+  REQUIRE(banded_tracker.tiles_drawn == 2);
+  REQUIRE(banded_tracker.bands == 1);
+
+  // the game's own viewport is never split, so it isn't given a pool
+  REQUIRE(max_draw_bands(Size{ 64, 40 }, Size{ 8, 8 }) == 1);
+  REQUIRE(max_draw_bands(Size{ 320, 240 }, game.tile_size) == 30);
+}
+
+TEST_CASE("Drawing in bands follows the camera across chunks", "[viewport]")
+{
+  using namespace lefticus::travels;
+
+  // a budget of a few chunks, so that they are loaded and evicted all the time while the bands draw
+  constexpr auto chunk_bytes = Map_Chunks::chunk_size * Map_Chunks::chunk_size * sizeof(std::uint32_t);
+  auto game = make_striped_game(Size{ 200, 200 }, chunk_bytes * 4);
+
+  Thread_Pool pool{ 3 };
+  Bitmap serial{ Size{ 640, 480 } };
+  Bitmap banded{ Size{ 640, 480 } };
+  Viewport_Tracker serial_tracker;
+  Viewport_Tracker banded_tracker;
+  banded_tracker.pool = &pool;
+
+  for (std::size_t frame = 0; frame < 120; ++frame) {
+    game.player.map_location = Point{ 40 + frame, 30 + frame / 2 };
+    draw(serial, game, serial_tracker);
+    draw(banded, game, banded_tracker);
+    REQUIRE(banded_tracker.bands == 4);
+    REQUIRE(std::ranges::equal(banded.pixels.data(), serial.pixels.data()));
+  }
+  REQUIRE(game.get_current_map().tiles.stats().evictions > 0);
+}
+
+TEST_CASE("The minimap draws tile stacks from their mip levels", "[minimap]")
+{
+  using namespace lefticus::travels;
+
+  Vector2D<Color> block{ Size{ 2, 2 } };
+  block.at(Point{ 0, 0 }) = Color{ 200, 0, 0, 255 };
+  block.at(Point{ 1, 0 }) = Color{ 100, 0, 0, 255 };
+  block.at(Point{ 0, 1 }) = Color{ 0, 0, 0, 0 };// transparent, doesn't darken the others
+  block.at(Point{ 1, 1 }) = Color{ 0, 0, 0, 0 };
+  Vector2D<Color> reduced{ Size{ 1, 1 } };
+  box_filter(block, reduced);
+  REQUIRE(reduced.at(Point{ 0, 0 }) == Color{ 150, 0, 0, 128 });
+
+  auto game = make_striped_game();
+  const auto &map = game.get_current_map();
+  REQUIRE(map.tile_stacks[1].mip_levels.size() == Tile_Stack::mip_level_count);
+  REQUIRE(map.tile_stacks[1].mip_levels[2].size() == Size{ 1, 1 });
+
+  REQUIRE(minimap_level(Size{ 64, 40 }, game.tile_size, Size{ 16, 10 }) == 0);
+  REQUIRE(minimap_level(Size{ 64, 40 }, game.tile_size, Size{ 30, 20 }) == 1);
+  REQUIRE(minimap_level(Size{ 64, 40 }, game.tile_size, map.size()) == 2);
+
+  // too big to fit, the part around the player is drawn at 1 pixel per cell
+  Bitmap minimap{ Size{ 64, 40 } };
+  Minimap_Tracker tracker;
+  draw_minimap(minimap, game, tracker);
+  REQUIRE(tracker.cells_drawn == 64 * 40);
+  REQUIRE(tracker.upper_left == Point{ 8, 20 });
+
+  const auto stack = map.tiles.at(Point{ 8, 20 });
+  REQUIRE(minimap.pixels.at(Point{ 0, 0 }) == map.tile_stacks[stack].mip_levels[2].at(Point{ 0, 0 }));
+  // the player is under the foreground of its cell, like in the viewport
+  REQUIRE(minimap.pixels.at(Point{ 32, 20 }) == blend(Color{ 255, 0, 0, 255 }, Color{ 0, 0, 255, 120 }));
+  REQUIRE(minimap.pixels.at(Point{ 22, 15 }) == Color{ 0, 255, 0, 255 });
+
+  // then only the animated cell and the player
+  draw_minimap(minimap, game, tracker);
+  REQUIRE(tracker.cells_drawn == 2);
+}
+
+TEST_CASE("Ansi_Encoder only writes what changed", "[ansi_encoder]")
+{
+  using namespace lefticus::travels;
+
+  Vector2D<Color> pixels{ Size{ 4, 2 } };
+  fill(pixels, Color{ 1, 2, 3, 255 });
+  pixels.at(Point{ 3, 1 }) = Color{ 200, 100, 0, 255 };
+
+  Ansi_Encoder encoder;
+
+  // one color for the run of plain cells, then both colors for the last one
+  REQUIRE(encoder.encode(pixels, Point{ 10, 5 })
+          == "\x1b[6;11H\x1b[48;2;1;2;3m   \x1b[38;2;200;100;0m▄\x1b[0m");
+  REQUIRE(encoder.stats().cells_written == 4);
+  REQUIRE(encoder.stats().color_changes == 2);
+
+  REQUIRE(encoder.encode(pixels, Point{ 10, 5 }).empty());
+  REQUIRE(encoder.stats().bytes == 0);
+
+  pixels.at(Point{ 2, 0 }) = Color{ 0, 0, 0, 255 };
+  REQUIRE(encoder.encode(pixels, Point{ 10, 5 }) == "\x1b[6;13H\x1b[38;2;1;2;3;48;2;0;0;0m▄\x1b[0m");
+  REQUIRE(encoder.stats().cells_written == 1);
+
+  // alpha isn't sent, so a change to only alpha isn't either
+  pixels.at(Point{ 0, 1 }) = Color{ 1, 2, 3, 0 };
+  REQUIRE(encoder.encode(pixels, Point{ 10, 5 }).empty());
+
+  // moving the region writes everything again
+  REQUIRE(encoder.encode(pixels, Point{ 0, 0 }).starts_with("\x1b[1;1H"));
+  REQUIRE(encoder.stats().cells_written == 4);
+
+  encoder.invalidate();
+  REQUIRE(encoder.encode(pixels, Point{ 0, 0 }).size() == encoder.stats().bytes);
+  REQUIRE(encoder.stats().cells_written == 4);
+}
+
+TEST_CASE("Palette_Quantizer maps colors to the nearest xterm palette entry", "[palette]")
+{
+  using namespace lefticus::travels;
+
+  const Palette_Quantizer palette_256{ Color_Depth::Palette_256 };
+  REQUIRE(palette_256.index(Color{ 255, 0, 0, 255 }) == 196);
+  REQUIRE(palette_256.index(Color{ 0, 0, 0, 255 }) == 16);
+  REQUIRE(palette_256.index(Color{ 118, 118, 118, 255 }) == 243);
+  REQUIRE(palette_256.color(243) == Color{ 118, 118, 118, 255 });
+  REQUIRE(palette_256.color(palette_256.index(Color{ 95, 135, 255, 255 })) == Color{ 95, 135, 255, 255 });
+
+  const Palette_Quantizer palette_16{ Color_Depth::Palette_16 };
+  REQUIRE(palette_16.index(Color{ 250, 10, 10, 255 }) == 9);
+  REQUIRE(palette_16.index(Color{ 10, 10, 10, 255 }) == 0);
+
+  REQUIRE_THROWS_AS(Palette_Quantizer{ Color_Depth::True_Color }, std::invalid_argument);
+
+  // a gray between two of the palette's grays
+  Vector2D<Color> pixels{ Size{ 8, 8 } };
+  fill(pixels, Color{ 123, 123, 123, 255 });
+  Vector2D<std::uint8_t> indices{ pixels.size() };
+
+  palette_256.quantize(pixels, indices);
+  REQUIRE(std::ranges::all_of(indices.data(), [](const auto index) { return index == 244; }));
+
+  // dithered, it is a pattern of colors around it that averages out close to it
+  const Palette_Quantizer dithered{ Color_Depth::Palette_256, true };
+  dithered.quantize(pixels, indices);
+  REQUIRE(std::ranges::count(indices.data(), std::uint8_t{ 244 }) < 64);
+
+  int total = 0;
+  for (const auto index : indices.data()) { total += dithered.color(index).R; }
+  REQUIRE(std::abs(total / 64 - 123) <= 4);
+  REQUIRE(indices.at(Point{ 1, 2 }) == dithered.index(Color{ 123, 123, 123, 255 }, Point{ 1, 2 }));
+}
+
+TEST_CASE("Log_Ring keeps the newest records", "[log_ring]")
+{
+  using namespace lefticus::travels;
+
+  REQUIRE_THROWS_AS(Log_Ring{ 0 }, std::invalid_argument);
+
+  Log_Ring ring{ 4 };
+  const auto now = std::chrono::system_clock::now();
+  for (int record = 0; record < 6; ++record) {// NOLINT magic numbers
+    ring.push(now, record, 1, "game", std::to_string(record));
+  }
+
+  REQUIRE(ring.size() == 4);
+  REQUIRE(ring.total() == 6);
+
+  const auto newest = ring.newest(1, 10);// NOLINT magic numbers
+  REQUIRE(newest.size() == 3);
+  REQUIRE(newest[0].payload == "4");
+  REQUIRE(newest[2].payload == "2");
+  REQUIRE(newest[2].level == 2);
+  REQUIRE(newest[2].logger_name == "game");
+  REQUIRE(newest[2].time == now);
+  REQUIRE(ring.newest(4, 1).empty());
+
+  ring.push(now, 0, 1, "a logger name that is too long", std::string(500, 'x'));// NOLINT magic numbers
+  const auto truncated = ring.newest(0, 1);
+  REQUIRE(truncated[0].payload == std::string(Log_Ring::max_payload, 'x'));
+  REQUIRE(truncated[0].logger_name.size() == Log_Ring::max_logger_name);
+
+  // writers on several threads, wrapping around many times
+  Log_Ring shared{ 16 };// NOLINT magic numbers
+  std::vector<std::jthread> writers;
+  for (int writer = 0; writer < 4; ++writer) {// NOLINT magic numbers
+    writers.emplace_back([&shared, &now, writer] {
+      for (int record = 0; record < 1000; ++record) {// NOLINT magic numbers
+        shared.push(now, writer, 0, "game", std::to_string(writer) + ":" + std::to_string(record));
+      }
+    });
+  }
+  writers.clear();
+
+  REQUIRE(shared.total() == 4000);
+  const auto last = shared.newest(0, 16);// NOLINT magic numbers
+  REQUIRE(last.size() == 16);
+  REQUIRE(std::ranges::all_of(
+    last, [](const auto &entry) { return entry.payload.starts_with(std::to_string(entry.level) + ":"); }));
+}
+
+TEST_CASE("Path_Finder finds paths through the clusters and follows changes", "[pathfinding]")
+{
+  using namespace lefticus::travels;
+
+  // a wall down the middle of the map with one gap in it
+  Passability_Grid grid{ Size{ 64, 64 } };
+  for (std::size_t cur_y = 0; cur_y < 64; ++cur_y) { grid.set_entry_mask(Point{ 32, cur_y }, 0); }
+  grid.set_entry_mask(Point{ 32, 50 }, Passability_Grid::all_sides);
+
+  Path_Finder finder{ grid };
+
+  // where the steps lead, if every one of them is allowed
+  const auto walk = [&finder](Point cell, const std::vector<Direction> &path) -> std::optional<Point> {
+    for (const auto direction : path) {
+      if (!finder.grid().can_step(cell, direction)) { return std::nullopt; }
+      cell = step(cell, direction);
+    }
+    return cell;
+  };
+
+  const auto nearby = finder.find_path(Point{ 2, 2 }, Point{ 10, 5 });
+  REQUIRE(nearby.has_value());
+  REQUIRE(nearby->size() == 11);
+  REQUIRE_FALSE(finder.stats().hierarchical);
+
+  const auto shortest = finder.find_shortest_path(Point{ 2, 2 }, Point{ 60, 2 });
+  REQUIRE(shortest.has_value());
+  REQUIRE(shortest->size() == 58 + 2 * 48);
+
+  const auto across = finder.find_path(Point{ 2, 2 }, Point{ 60, 2 });
+  REQUIRE(across.has_value());
+  REQUIRE(finder.stats().hierarchical);
+  REQUIRE(walk(Point{ 2, 2 }, *across) == Point{ 60, 2 });
+  REQUIRE(across->size() >= shortest->size());
+  REQUIRE(across->size() <= shortest->size() + shortest->size() / 10);
+
+  REQUIRE(finder.find_path(Point{ 5, 5 }, Point{ 5, 5 })->empty());
+  REQUIRE_THROWS_AS(finder.find_path(Point{ 64, 0 }, Point{ 0, 0 }), std::range_error);
+
+  // closing the gap splits the map in two, the landmarks only ever underestimate after that
+  REQUIRE(finder.stats().landmarks);
+  finder.set_entry_mask(Point{ 32, 50 }, 0);
+  REQUIRE(finder.stats().landmarks);
+  REQUIRE(finder.component(Point{ 2, 2 }) != finder.component(Point{ 60, 2 }));
+  REQUIRE_FALSE(finder.find_path(Point{ 2, 2 }, Point{ 60, 2 }).has_value());
+
+  // a gap that can only be entered from the west is a one way passage
+  finder.set_entry_mask(Point{ 32, 50 }, side_bit(Direction::West));
+  REQUIRE(finder.component(Point{ 2, 2 }) == finder.component(Point{ 60, 2 }));
+  const auto east_bound = finder.find_path(Point{ 2, 2 }, Point{ 60, 2 });
+  REQUIRE(east_bound.has_value());
+  REQUIRE(walk(Point{ 2, 2 }, *east_bound) == Point{ 60, 2 });
+  REQUIRE_FALSE(finder.find_path(Point{ 60, 2 }, Point{ 2, 2 }).has_value());
+
+  // opening it up could make the landmarks overestimate, until they are placed again
+  REQUIRE_FALSE(finder.stats().landmarks);
+  finder.place_landmarks();
+  REQUIRE(finder.stats().landmarks);
+  const auto measured = finder.find_path(Point{ 2, 2 }, Point{ 60, 2 });
+  REQUIRE(measured.has_value());
+  REQUIRE(walk(Point{ 2, 2 }, *measured) == Point{ 60, 2 });
+
+  // the grid of a map asks the scripts of its cells for each side
+  Game game;
+  Game_Map map{ Size{ 4, 4 } };
+  map.locations.at(Point{ 1, 1 }).can_enter = [](const Game &, Point, Direction from) {
+    return from == Direction::North;
+  };
+  const Passability_Grid map_grid{ game, map };
+  REQUIRE(map_grid.entry_mask(Point{ 1, 1 }) == side_bit(Direction::North));
+  REQUIRE(map_grid.entry_mask(Point{ 0, 0 }) == Passability_Grid::all_sides);
+  REQUIRE(map_grid.can_step(Point{ 1, 0 }, Direction::South));
+  REQUIRE_FALSE(map_grid.can_step(Point{ 0, 1 }, Direction::East));
+}
+
+TEST_CASE("Variable comparisons look their variables up by slot", "[variables]")
+{
+  using namespace lefticus::travels;
+
+  REQUIRE(Variable_Slot::intern("Cash") == Variable_Slot::intern(std::string{ "Cash" }));
+  REQUIRE(Variable_Slot::intern("Cash") != Variable_Slot::intern("Debt"));
+  REQUIRE(Variable_Slot::intern("Debt").name() == "Debt");
+
+  Game game;
+  game.variables["Cash"] = 50;// NOLINT magic numbers
+
+  const auto rich = variable{ "Cash" } >= 40 && 100 > variable{ "Cash" };// NOLINT magic numbers
+  REQUIRE(rich(game));
+
+  game.variables.at(Variable_Slot::intern("Cash")) = std::int64_t{ 10 };
+  REQUIRE_FALSE(rich(game));
+
+  // a condition can be built before its variable exists
+  const auto flagged = variable{ "Not set yet" } == true;
+  REQUIRE_THROWS_AS(flagged(game), std::out_of_range);
+  game.variables["Not set yet"] = true;
+  REQUIRE(flagged(game));
+  REQUIRE(game.variables.contains("Not set yet"));
+  REQUIRE_FALSE(game.variables.contains("Debt"));
+}
+
+TEST_CASE("Variable comparisons are only evaluated again when their inputs change", "[variables]")
+{
+  using namespace lefticus::travels;
+
+  Game game;
+  game.variables["Cash"] = 50;// NOLINT magic numbers
+  game.variables["Flag"] = false;
+  game.variables["Other"] = false;
+
+  int evaluations = 0;
+  const auto counted = Variable_Comparison{ [&evaluations](const Game &current) {
+                                             ++evaluations;
+                                             return std::get<bool>(current.variables.at("Flag"));
+                                           },
+    { Variable_Slot::intern("Flag") } };
+
+  const auto either = variable{ "Cash" } > 100 || counted;// NOLINT magic numbers
+  const auto both = counted && variable{ "Cash" } > 10;// NOLINT magic numbers
+
+  REQUIRE_FALSE(either(game));
+  REQUIRE_FALSE(both(game));
+  REQUIRE(evaluations == 1);
+
+  // not an input of either
+  game.variables["Other"] = true;
+  REQUIRE_FALSE(either(game));
+  REQUIRE(evaluations == 1);
+
+  // only the side that depends on Cash is evaluated again
+  game.variables["Cash"] = 200;// NOLINT magic numbers
+  REQUIRE(either(game));
+  REQUIRE_FALSE(both(game));
+  REQUIRE(evaluations == 1);
+
+  game.variables["Flag"] = true;
+  REQUIRE(both(game));
+  REQUIRE(evaluations == 2);
+
+  // a copy is a different set of variables, even with the same versions
+  Game other;
+  other.variables = game.variables;
+  REQUIRE(both(other));
+  other.variables["Flag"] = false;
+  REQUIRE_FALSE(both(other));
+  REQUIRE(both(game));
+}
+
+TEST_CASE("Headless runs are reproducible", "[headless]")
+{
+  using namespace lefticus::travels;
+
+  const auto options = Headless_Options{ .frames = 20, .input = parse_input_script("..e.e..s") };
+
+  auto game = hacking::lesson_00::make_lesson();
+  const auto report = run_headless(game, options);
+  REQUIRE(report.frames.size() == 20);
+  REQUIRE(report.ticks == 38);
+  REQUIRE(game.player.map_location != Point{ 1, 1 });
+
+  auto replayed_game = hacking::lesson_00::make_lesson();
+  const auto replay = run_headless(replayed_game, options);
+  REQUIRE(replayed_game.player.map_location == game.player.map_location);
+  REQUIRE(std::ranges::equal(
+    report.frames, replay.frames, {}, &Headless_Report::Frame::hash, &Headless_Report::Frame::hash));
+
+  REQUIRE_THROWS_AS(parse_input_script("nx"), std::invalid_argument);
+}
+
+TEST_CASE("Recorded input replays the same frames", "[headless]")
+{
+  using namespace lefticus::travels;
+
+  auto game = hacking::lesson_00::make_lesson();
+  const auto report =
+    run_headless(game, Headless_Options{ .frames = 20, .tick_rate = 50, .input = parse_input_script("..e.e..s") });
+  REQUIRE(report.recording.ticks == report.ticks);
+  // the lesson's opening popup is dismissed before the three moves
+  REQUIRE(report.recording.inputs.size() == 4);
+  REQUIRE(report.recording.inputs.front().command == Input_Command::Dismiss_Popup);
+
+  std::stringstream file;
+  write_input_recording(report.recording, file);
+  const auto recording = read_input_recording(file);
+  REQUIRE(recording.tick_rate == 50);
+  REQUIRE(recording.ticks == report.ticks);
+  REQUIRE(std::ranges::equal(recording.inputs, report.recording.inputs, [](const auto &lhs, const auto &rhs) {
+    return lhs.tick == rhs.tick && lhs.command == rhs.command && lhs.count == rhs.count
+           && lhs.menu_item == rhs.menu_item;
+  }));
+
+  // the replay runs at the recording's tick rate, not the default one
+  auto replayed_game = hacking::lesson_00::make_lesson();
+  const auto replay = run_headless(replayed_game, Headless_Options{ .replay = recording });
+  REQUIRE(replay.ticks == report.ticks);
+  REQUIRE(replayed_game.player.map_location == game.player.map_location);
+  REQUIRE(replayed_game.clock == game.clock);
+  REQUIRE(replay.frames.back().hash == report.frames.back().hash);
+
+  auto truncated = file.str();
+  truncated.pop_back();
+  std::stringstream truncated_file{ truncated };
+  REQUIRE_THROWS_AS(read_input_recording(truncated_file), std::runtime_error);
+
+  std::stringstream not_a_recording{ "travels" };
+  REQUIRE_THROWS_AS(read_input_recording(not_a_recording), std::runtime_error);
+
+  // a tick this short would round down to nothing
+  std::stringstream too_fast;
+  write_input_recording(Input_Recording{ .tick_rate = 2e9, .ticks = 0, .inputs = {} }, too_fast);// NOLINT magic number
+  REQUIRE_THROWS_AS(read_input_recording(too_fast), std::runtime_error);
+}
+
+TEST_CASE("Recorded menu choices replay the same variables", "[headless]")
+{
+  using namespace lefticus::travels;
+
+  const auto make_store = [] {
+    auto game = hacking::lesson_00::make_lesson();
+    game.set_menu(Menu{ set_flag("Buy", "Sold!", variable{ "Bought" }), exit_menu() });
+    return game;
+  };
+
+  using enum Input_Command;
+  Input_Recording recording{ .tick_rate = 60, .ticks = 10, .inputs = {} };
+  recording.inputs.push_back(Input_Recording::Input{ .tick = 1, .command = Dismiss_Popup });
+  recording.inputs.push_back(Input_Recording::Input{ .tick = 3, .command = Choose_Menu_Item, .menu_item = 0 });
+  recording.inputs.push_back(Input_Recording::Input{ .tick = 3, .command = Dismiss_Popup });
+  recording.inputs.push_back(Input_Recording::Input{ .tick = 5, .command = Choose_Menu_Item, .menu_item = 1 });
+
+  std::stringstream file;
+  write_input_recording(recording, file);
+  const auto read = read_input_recording(file);
+  REQUIRE(read.inputs.size() == 4);
+  REQUIRE(read.inputs[3].command == Choose_Menu_Item);
+  REQUIRE(read.inputs[3].menu_item == 1);
+
+  auto game = make_store();
+  run_headless(game, Headless_Options{ .replay = read });
+  REQUIRE(game.variables["Bought"] == Variable{ true });
+  REQUIRE_FALSE(game.has_menu());
+  REQUIRE_FALSE(game.has_popup_message());
+
+  // without a replay nobody answers, the menu is closed without buying anything, and that is recorded
+  auto unanswered = make_store();
+  const auto report = run_headless(unanswered, Headless_Options{ .frames = 2 });
+  REQUIRE(unanswered.variables["Bought"] != Variable{ true });
+  REQUIRE(std::ranges::any_of(
+    report.recording.inputs, [](const auto &input) { return input.command == Input_Command::Close_Menu; }));
+
+  auto replayed = make_store();
+  run_headless(replayed, Headless_Options{ .replay = report.recording });
+  REQUIRE(replayed.variables["Bought"] != Variable{ true });
+  REQUIRE_FALSE(replayed.has_menu());
+}